@@ -44,7 +44,8 @@ Item {
             iconSource: Qt.resolvedUrl("PhotoEditor/assets/edit_crop.png")
             onTriggered: {
                 photoData.isLongOperation = false;
-                cropper.start("image://photo/" + photoData.path);
+                cropper.start("image://photo/" + photoData.path,
+                              photoData.path, photoData.size);
             }
         },
         Action {
@@ -102,10 +103,7 @@ Item {
 
         onEditFinished: {
             console.log("Edit finished")
-            // If we are editing exposure we don't need to checkpoint at every
-            // edit, and the exposure UI will checkpoint when the user confirms.
-            if (exposureSelector.opacity > 0) exposureSelector.reload()
-            else stack.checkpoint()
+            stack.checkpoint()
         }
     }
 
@@ -133,8 +131,10 @@ Item {
             }
         }
 
-        function start(target) {
+        function start(target, path, size) {
             source = "PhotoEditor/CropInteractor.qml";
+            item.photoPath = path;
+            item.photoSize = size;
             item.targetPhoto = target;
         }
 
@@ -146,20 +146,13 @@ Item {
         anchors.fill: parent
         opacity: 0.0
         enabled: !photoData.busy
-        onExposureChanged: {
-            // Restore the starting version of the image, otherwise we will
-            // accumulate compensations over the previous ones.
-            stack.restoreSnapshot(stack.level)
-            photoData.exposureCompensation(exposure)
-        }
         onConfirm: {
-            stack.checkpoint();
-            exposureSelector.opacity = 0.0
-        }
-        onCancel: {
-            stack.restoreSnapshot(stack.level)
+            // Only the confirmed value is applied to the photo, the
+            // intermediate values are just previewed.
             exposureSelector.opacity = 0.0
+            if (exposure != 0.0) photoData.exposureCompensation(exposure)
         }
+        onCancel: exposureSelector.opacity = 0.0
         visible: opacity > 0
     }
 
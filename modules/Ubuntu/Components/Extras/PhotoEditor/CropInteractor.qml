@@ -31,6 +31,9 @@ Rectangle {
     color: "black"
 
     property alias targetPhoto: original.source
+    // Path and full size of the photo, used to show sharp tiles when zooming
+    property alias photoPath: tiles.source
+    property alias photoSize: tiles.photoSize
 
     property string matteColor: "black"
     property real matteOpacity: 0.6
@@ -136,5 +139,16 @@ Rectangle {
                 scale = rects.photoExtentScale;
             }
         }
+
+        TiledPhoto {
+            id: tiles
+            anchors.fill: parent
+            visible: original.status == Image.Ready
+            displayScale: original.scale
+            visibleArea: Qt.rect(-original.x / original.scale,
+                                 -original.y / original.scale,
+                                 cropInteractor.width / original.scale,
+                                 cropInteractor.height / original.scale)
+        }
     }
 }
@@ -24,21 +24,49 @@ Rectangle {
     id: adjuster
     color:"black"
 
-    property alias exposure: exposureSelector.value
+    property alias exposure: preview.exposure
     property bool enabled
 
     signal confirm()
     signal cancel()
 
-    Image {
-        id: targetImage
+    // The preview is rendered from a screen-sized copy of the photo, so the
+    // slider can update it live. The actual edit is only done on confirm.
+    PhotoPreview {
+        id: preview
         anchors.fill: parent
-        fillMode: Image.PreserveAspectFit
-        asynchronous: true
-        cache: false
-        sourceSize {
-            width: targetImage.width
-            height: targetImage.height
+        exposure: exposureSelector.value
+    }
+
+    Canvas {
+        id: histogram
+        anchors.left: parent.left
+        anchors.top: parent.top
+        anchors.margins: units.gu(2)
+        width: units.gu(16)
+        height: units.gu(8)
+        visible: preview.ready
+
+        onPaint: {
+            var ctx = getContext("2d");
+            ctx.clearRect(0, 0, width, height);
+
+            var bins = preview.histogram;
+            var highest = 0;
+            for (var i = 0; i < bins.length; i++) highest = Math.max(highest, bins[i]);
+            if (highest == 0) return;
+
+            ctx.fillStyle = Qt.rgba(1, 1, 1, 0.6);
+            var binWidth = width / bins.length;
+            for (i = 0; i < bins.length; i++) {
+                var binHeight = height * bins[i] / highest;
+                ctx.fillRect(i * binWidth, height - binHeight, binWidth, binHeight);
+            }
+        }
+
+        Connections {
+            target: preview
+            onHistogramChanged: histogram.requestPaint()
         }
     }
 
@@ -51,7 +79,7 @@ Rectangle {
 
         Slider {
             id: exposureSelector
-            live: false
+            live: true
             minimumValue: -1.0
             maximumValue: +1.0
             value: 0.0
@@ -73,8 +101,8 @@ Rectangle {
                 color: UbuntuColors.green
                 enabled: adjuster.enabled
                 onTriggered: {
-                    targetImage.source = "";
                     confirm();
+                    preview.path = "";
                 }
             }
             Button {
@@ -82,24 +110,17 @@ Rectangle {
                 color: UbuntuColors.red
                 enabled: adjuster.enabled
                 onTriggered: {
-                    targetImage.source = "";
+                    preview.path = "";
                     cancel();
                 }
             }
         }
     }
 
-    function start(target) {
-        targetImage.source = target;
-        exposure = 0.0;
+    function start(path) {
+        exposureSelector.value = 0.0;
+        preview.reset();
+        preview.path = path;
         opacity = 1.0;
     }
-
-    function reload() {
-        var path = targetImage.source;
-        targetImage.asynchronous = false;
-        targetImage.source = "";
-        targetImage.asynchronous = true;
-        targetImage.source = path;
-    }
 }
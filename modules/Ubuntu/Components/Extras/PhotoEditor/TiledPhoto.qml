@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+import QtQuick 2.3
+
+/*!
+  Displays a photo stretched over the whole item using tiles from the
+  "phototile" image provider. Only the tiles intersecting visibleArea are
+  loaded, at the pyramid level matching the current on-screen scale, so that
+  zooming into a huge photo stays sharp without decoding it in full.
+*/
+Item {
+    id: tiledPhoto
+
+    // Path of the photo file
+    property string source
+    // Size of the full resolution photo, as displayed (see PhotoData.size)
+    property size photoSize
+    // Scale applied to this item by its ancestors or by its own scale property
+    property real displayScale: scale
+    // Part of the item that is visible on screen, in item coordinates
+    property rect visibleArea: Qt.rect(0, 0, width, height)
+
+    readonly property int tileSize: 256
+    readonly property int levelCount: {
+        var count = 1;
+        var extent = Math.max(photoSize.width, photoSize.height);
+        while (extent > tileSize) {
+            extent = Math.ceil(extent / 2);
+            count++;
+        }
+        return count;
+    }
+    readonly property int level: {
+        var onScreenWidth = width * displayScale;
+        if (photoSize.width <= 0 || onScreenWidth <= 0) return levelCount - 1;
+        var wanted = Math.floor(Math.log(photoSize.width / onScreenWidth) / Math.LN2);
+        return Math.max(0, Math.min(levelCount - 1, wanted));
+    }
+    // Size of a tile of the current level, in item coordinates
+    readonly property real tileExtent: photoSize.width > 0 ?
+        tileSize * Math.pow(2, level) * width / photoSize.width : 0
+
+    function tileSource(tileLevel, column, row) {
+        return "image://phototile/" + tileLevel + "/" + column + "/" + row + "/" + source;
+    }
+
+    function visibleTiles() {
+        var tiles = [];
+        if (!source || tileExtent <= 0) return tiles;
+
+        var levelWidth = Math.ceil(photoSize.width / Math.pow(2, level));
+        var levelHeight = Math.ceil(photoSize.height / Math.pow(2, level));
+        var columns = Math.ceil(levelWidth / tileSize);
+        var rows = Math.ceil(levelHeight / tileSize);
+
+        var firstColumn = Math.max(0, Math.floor(visibleArea.x / tileExtent));
+        var lastColumn = Math.min(columns - 1,
+                                  Math.floor((visibleArea.x + visibleArea.width) / tileExtent));
+        var firstRow = Math.max(0, Math.floor(visibleArea.y / tileExtent));
+        var lastRow = Math.min(rows - 1,
+                               Math.floor((visibleArea.y + visibleArea.height) / tileExtent));
+
+        for (var row = firstRow; row <= lastRow; row++) {
+            for (var column = firstColumn; column <= lastColumn; column++) {
+                tiles.push({ "column": column, "row": row });
+            }
+        }
+        return tiles;
+    }
+
+    // Whole photo from the smallest level, shown while the tiles load.
+    Image {
+        anchors.fill: parent
+        asynchronous: true
+        source: tiledPhoto.source ?
+                tiledPhoto.tileSource(tiledPhoto.levelCount - 1, 0, 0) : ""
+    }
+
+    Repeater {
+        model: tiledPhoto.visibleTiles()
+
+        Image {
+            x: modelData.column * tiledPhoto.tileExtent
+            y: modelData.row * tiledPhoto.tileExtent
+            width: Math.min(tiledPhoto.tileExtent, tiledPhoto.width - x)
+            height: Math.min(tiledPhoto.tileExtent, tiledPhoto.height - y)
+            asynchronous: true
+            smooth: true
+            source: tiledPhoto.tileSource(tiledPhoto.level, modelData.column, modelData.row)
+        }
+    }
+}
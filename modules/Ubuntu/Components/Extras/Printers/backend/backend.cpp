@@ -198,6 +198,22 @@ QMap<QString, QVariant> PrinterBackend::printerGetJobAttributes(
     return QMap<QString, QVariant>();
 }
 
+QList<JobAttributes> PrinterBackend::printerGetJobsAttributes(
+        const QList<QPair<QString, int>> &jobs)
+{
+    QList<JobAttributes> list;
+
+    for (int i = 0; i < jobs.size(); i++) {
+        JobAttributes job;
+        job.printerName = jobs.at(i).first;
+        job.jobId = jobs.at(i).second;
+        job.attributes = printerGetJobAttributes(job.printerName, job.jobId);
+        list << job;
+    }
+
+    return list;
+}
+
 QString PrinterBackend::printerName() const
 {
     return m_printerName;
@@ -228,6 +244,11 @@ PrinterEnum::State PrinterBackend::state() const
     return PrinterEnum::State::IdleState;
 }
 
+qint64 PrinterBackend::configChangeTime() const
+{
+    return -1;
+}
+
 QList<QPageSize> PrinterBackend::supportedPageSizes() const
 {
     return QList<QPageSize>();
@@ -289,6 +310,11 @@ QString PrinterBackend::defaultPrinterName()
     return QString();
 }
 
+void PrinterBackend::requestJobs()
+{
+    Q_EMIT jobListLoaded(printerGetJobs());
+}
+
 void PrinterBackend::requestJobExtendedAttributes(
         QSharedPointer<Printer> printer, QSharedPointer<PrinterJob> job)
 {
@@ -296,15 +322,40 @@ void PrinterBackend::requestJobExtendedAttributes(
     Q_UNUSED(job);
 }
 
+void PrinterBackend::refreshJobs(const QString &printerName,
+                                 const QList<int> &jobIds)
+{
+    Q_UNUSED(printerName);
+    Q_UNUSED(jobIds);
+}
+
 void PrinterBackend::requestPrinterDrivers()
 {
 }
 
-void PrinterBackend::requestPrinter(const QString &printerName)
+void PrinterBackend::cancelPrinterDrivers()
+{
+}
+
+void PrinterBackend::requestPrinter(const QString &printerName,
+                                    const TaskScheduler::Priority priority)
+{
+    Q_UNUSED(printerName);
+    Q_UNUSED(priority);
+}
+
+void PrinterBackend::requestPrinterState(const QString &printerName)
 {
     Q_UNUSED(printerName);
 }
 
+void PrinterBackend::requestPrinterOptions(const QString &printerName,
+                                           const QStringList &options)
+{
+    Q_EMIT printerOptionsLoaded(printerName, options,
+                                printerGetOptions(printerName, options));
+}
+
 PrinterEnum::PrinterType PrinterBackend::type() const
 {
     return m_type;
@@ -315,6 +366,11 @@ void PrinterBackend::setPrinterNameInternal(const QString &printerName)
     m_printerName = printerName;
 }
 
+void PrinterBackend::setStateInternal(const PrinterEnum::State &state)
+{
+    Q_UNUSED(state);
+}
+
 void PrinterBackend::refresh()
 {
 }
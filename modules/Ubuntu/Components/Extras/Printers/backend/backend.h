@@ -17,6 +17,7 @@
 #ifndef USC_PRINTERS_BACKEND_H
 #define USC_PRINTERS_BACKEND_H
 
+#include "backend/taskscheduler.h"
 #include "printer/printer.h"
 #include "printer/printerjob.h"
 
@@ -90,6 +91,9 @@ public:
                                                      const int jobId);
     virtual QMap<QString, QVariant> printerGetJobAttributes(
         const QString &name, const int jobId);
+    // Jobs are given as pairs of printer name and job id.
+    virtual QList<JobAttributes> printerGetJobsAttributes(
+        const QList<QPair<QString, int>> &jobs);
 
     virtual QString printerName() const;
     virtual QString description() const;
@@ -98,6 +102,8 @@ public:
     virtual bool isRemote() const;
 
     virtual PrinterEnum::State state() const;
+    // The printer-config-change-time of the printer, or -1.
+    virtual qint64 configChangeTime() const;
     virtual QList<QPageSize> supportedPageSizes() const;
     virtual QPageSize defaultPageSize() const;
     virtual bool supportsCustomPageSizes() const;
@@ -113,24 +119,53 @@ public:
     virtual QSharedPointer<Printer> getPrinter(const QString &printerName);
     virtual QString defaultPrinterName();
 
+    /* Loads the jobs of all printers, and emits them with jobListLoaded.
+    This default implementation does so synchronously. */
+    virtual void requestJobs();
     virtual void requestJobExtendedAttributes(QSharedPointer<Printer> printer,
                                               QSharedPointer<PrinterJob> job);
+    /* Reloads the extended attributes of jobs whose state may have changed,
+    emitting them with jobsLoaded. Backends may batch and delay this. */
+    virtual void refreshJobs(const QString &printerName,
+                             const QList<int> &jobIds);
+    /* Loads the drivers, and emits them with printerDriversLoaded. They may
+    be emitted with printerDriversChunkLoaded as they load, too. */
     virtual void requestPrinterDrivers();
-    virtual void requestPrinter(const QString &printerName);
+    virtual void cancelPrinterDrivers();
+    virtual void requestPrinter(
+            const QString &printerName,
+            const TaskScheduler::Priority priority
+                = TaskScheduler::Priority::Background);
+    /* Loads only the state and change times of a printer, which is much
+    cheaper than requestPrinter, and emits them with printerStateLoaded. */
+    virtual void requestPrinterState(const QString &printerName);
+    /* Loads the given options of a printer, like printerGetOptions, and
+    emits them with printerOptionsLoaded. This default implementation does
+    so synchronously. */
+    virtual void requestPrinterOptions(const QString &printerName,
+                                       const QStringList &options);
 
     virtual PrinterEnum::PrinterType type() const;
 
     virtual void setPrinterNameInternal(const QString &printerName);
+    virtual void setStateInternal(const PrinterEnum::State &state);
 
 public Q_SLOTS:
     virtual void refresh();
 
 Q_SIGNALS:
+    void printerDriversChunkLoaded(const QList<PrinterDriver> &drivers);
     void printerDriversLoaded(const QList<PrinterDriver> &drivers);
     void printerDriversFailedToLoad(const QString &errorMessage);
 
     void jobLoaded(QString, int, QMap<QString, QVariant>);
+    void jobsLoaded(const QList<JobAttributes> &jobs);
+    void jobListLoaded(const QList<QSharedPointer<PrinterJob>> &jobs);
     void printerLoaded(QSharedPointer<Printer> printers);
+    void printerStateLoaded(const PrinterStateAttributes &attributes);
+    void printerOptionsLoaded(const QString &printerName,
+                              const QStringList &options,
+                              const QMap<QString, QVariant> &values);
     void deviceFound(const Device &device);
     void deviceSearchFinished();
 
@@ -15,8 +15,11 @@
  */
 
 #include "backend/backend_cups.h"
+#include "backend/devicecache.h"
+#include "cups/destinationsnapshot.h"
 #include "cups/devicesearcher.h"
 #include "cups/jobloader.h"
+#include "cups/printercache.h"
 #include "cups/printerdriverloader.h"
 #include "cups/printerloader.h"
 #include "utils.h"
@@ -26,19 +29,24 @@
 #include <cups/ppd.h>
 
 #include <QLocale>
+#include <QMutexLocker>
 #include <QThread>
 #include <QTimeZone>
 
+// How often jobs are refreshed at most, in milliseconds.
+#define JOB_REFRESH_INTERVAL 1000
+
 #define __CUPS_ADD_OPTION(dest, name, value) dest->num_options = \
     cupsAddOption(name, value, dest->num_options, &dest->options);
 
 #define __CUPS_ATTR_EXISTS(map, attr, type) map.contains(attr) \
     && map.value(attr).canConvert<type>()
 
-PrinterCupsBackend::PrinterCupsBackend(IppClient *client, QPrinterInfo info,
-                                       OrgCupsCupsdNotifierInterface *notifier,
+PrinterCupsBackend::PrinterCupsBackend(IppClient *client,
+                                       const QString &printerName,
+                                       CupsNotifier *notifier,
                                        QObject *parent)
-    : PrinterBackend(info.printerName(), parent)
+    : PrinterBackend(printerName, parent)
     , m_knownQualityOptions({
         "Quality", "PrintQuality", "HPPrintQuality", "StpQuality",
         "OutputMode",})
@@ -46,12 +54,62 @@ PrinterCupsBackend::PrinterCupsBackend(IppClient *client, QPrinterInfo info,
         QStringLiteral("StateMessage"), QStringLiteral("DeviceUri"),
         QStringLiteral("IsShared"), QStringLiteral("Copies"),
     })
+    , m_jobAttributeNames({
+        "Collate", "copies", "ColorModel", "date-time-at-completed",
+        "date-time-at-creation", "date-time-at-processing", "Duplex",
+        "job-media-sheets-completed", "job-impressions-completed",
+        "landscape", "page-ranges", "OutputOrder", "job-k-octets",
+        "job-state", "job-originating-user-name",
+        "job-printer-state-message",})
     , m_client(client)
-    , m_info(info)
     , m_notifier(notifier)
     , m_cupsSubscriptionId(-1)
+    , m_jobRequestTimer(this)
+    , m_jobRefreshTimer(this)
 {
     m_type = PrinterEnum::PrinterType::CupsType;
+
+    /* The destinations are enumerated again after changes to the queues.
+    This is connected before the signals below are forwarded, so that
+    whoever handles them sees the new destinations. */
+    auto snapshot = DestinationSnapshot::instance();
+    connect(m_notifier, SIGNAL(PrinterAdded(const QString&, const QString&,
+                                            const QString&, uint,
+                                            const QString&, bool)),
+            snapshot, SLOT(invalidate()), Qt::UniqueConnection);
+    connect(m_notifier, SIGNAL(PrinterDeleted(const QString&, const QString&,
+                                              const QString&, uint,
+                                              const QString&, bool)),
+            snapshot, SLOT(invalidate()), Qt::UniqueConnection);
+    connect(m_notifier, SIGNAL(PrinterModified(const QString&, const QString&,
+                                               const QString&, uint,
+                                               const QString&, bool)),
+            snapshot, SLOT(invalidate()), Qt::UniqueConnection);
+    connect(m_notifier, SIGNAL(PrinterDeleted(const QString&, const QString&,
+                                              const QString&, uint,
+                                              const QString&, bool)),
+            PrinterCache::instance(),
+            SLOT(printerDeleted(const QString&, const QString&,
+                                const QString&, uint,
+                                const QString&, bool)),
+            Qt::UniqueConnection);
+    connect(m_notifier, SIGNAL(PrinterDeleted(const QString&, const QString&,
+                                              const QString&, uint,
+                                              const QString&, bool)),
+            CapabilityCache::instance(),
+            SLOT(printerDeleted(const QString&, const QString&,
+                                const QString&, uint,
+                                const QString&, bool)),
+            Qt::UniqueConnection);
+    connect(m_notifier, SIGNAL(PrinterModified(const QString&, const QString&,
+                                               const QString&, uint,
+                                               const QString&, bool)),
+            PrinterCache::instance(),
+            SLOT(printerModified(const QString&, const QString&,
+                                 const QString&, uint,
+                                 const QString&, bool)),
+            Qt::UniqueConnection);
+
     connect(m_notifier, SIGNAL(JobCompleted(const QString&, const QString&,
                                             const QString&, uint,
                                             const QString&, bool, uint, uint,
@@ -102,19 +160,23 @@ PrinterCupsBackend::PrinterCupsBackend(IppClient *client, QPrinterInfo info,
                                              const QString&, uint,
                                              const QString&, bool)));
 
+    // Requests for job attributes made in the same event loop iteration are
+    // loaded together.
+    m_jobRequestTimer.setSingleShot(true);
+    m_jobRequestTimer.setInterval(0);
+    connect(&m_jobRequestTimer, SIGNAL(timeout()),
+            this, SLOT(loadPendingJobs()));
+
+    // Refreshes of jobs, caused by printer state changes, are loaded at most
+    // once per interval however often the printer changes.
+    m_jobRefreshTimer.setSingleShot(true);
+    m_jobRefreshTimer.setInterval(JOB_REFRESH_INTERVAL);
+    connect(&m_jobRefreshTimer, SIGNAL(timeout()),
+            this, SLOT(loadRefreshJobs()));
 }
 
 PrinterCupsBackend::~PrinterCupsBackend()
 {
-    Q_FOREACH(auto dest, m_dests) {
-        if (dest)
-            cupsFreeDests(1, dest);
-    }
-    Q_FOREACH(auto ppd, m_ppds) {
-        if (ppd)
-            ppdClose(ppd);
-    }
-
     cancelSubscription();
     Q_EMIT cancelWorkers();
 }
@@ -145,7 +207,8 @@ QString PrinterCupsBackend::printerAddWithPpd(const QString &name,
 
 bool PrinterCupsBackend::holdsDefinition() const
 {
-    return !m_info.isNull();
+    return !m_printerName.isEmpty()
+        && DestinationSnapshot::instance()->contains(m_printerName);
 }
 
 QString PrinterCupsBackend::printerDelete(const QString &name)
@@ -235,7 +298,6 @@ QMap<QString, QVariant> PrinterCupsBackend::printerGetOptions(
     QMap<QString, QVariant> ret;
 
     cups_dest_t *dest = getDest(name);
-    ppd_file_t* ppd = getPpd(name);
 
     // Used to store extended attributes, which we should request maximum once.
     QMap<QString, QVariant> extendedAttributesResults;
@@ -256,66 +318,27 @@ QMap<QString, QVariant> PrinterCupsBackend::printerGetOptions(
         }
     }
 
+    // Capabilities come from the PPD, so only load them when asked for.
+    PrinterCapabilities caps;
     Q_FOREACH(const QString &option, options) {
-        if (option == QStringLiteral("DefaultColorModel") && ppd) {
-            ColorModel model;
-            ppd_option_t *ppdColorModel = ppdFindOption(ppd, "ColorModel");
-            if (ppdColorModel) {
-                ppd_choice_t* def = ppdFindChoice(ppdColorModel,
-                                                  ppdColorModel->defchoice);
-                if (def) {
-                    model = Utils::parsePpdColorModel(def->choice,
-                                                      def->text,
-                                                      "ColorModel");
-                }
-            }
-            ret[option] = QVariant::fromValue(model);
-        } else if (option == QStringLiteral("DefaultPrintQuality") && ppd) {
-            PrintQuality quality;
-            Q_FOREACH(const QString opt, m_knownQualityOptions) {
-                ppd_option_t *ppdQuality = ppdFindOption(ppd, opt.toUtf8());
-                if (ppdQuality) {
-                    ppd_choice_t* def = ppdFindChoice(ppdQuality,
-                                                      ppdQuality->defchoice);
-                    if (def) {
-                        quality = Utils::parsePpdPrintQuality(def->choice,
-                                                              def->text, opt);
-                    }
-                }
-            }
-            ret[option] = QVariant::fromValue(quality);
-        } else if (option == QStringLiteral("SupportedPrintQualities") && ppd) {
-            QList<PrintQuality> qualities;
-            Q_FOREACH(const QString &opt, m_knownQualityOptions) {
-                ppd_option_t *qualityOpt = ppdFindOption(ppd, opt.toUtf8());
-                if (qualityOpt) {
-                    for (int i = 0; i < qualityOpt->num_choices; ++i) {
-                        qualities.append(
-                            Utils::parsePpdPrintQuality(
-                                qualityOpt->choices[i].choice,
-                                qualityOpt->choices[i].text,
-                                opt
-                            )
-                        );
-                    }
-                }
-            }
-            ret[option] = QVariant::fromValue(qualities);
-        } else if (option == QStringLiteral("SupportedColorModels") && ppd) {
-            QList<ColorModel> models;
-            ppd_option_t *colorModels = ppdFindOption(ppd, "ColorModel");
-            if (colorModels) {
-                for (int i = 0; i < colorModels->num_choices; ++i) {
-                    models.append(
-                        Utils::parsePpdColorModel(
-                            colorModels->choices[i].choice,
-                            colorModels->choices[i].text,
-                            QStringLiteral("ColorModel")
-                        )
-                    );
-                }
-            }
-            ret[option] = QVariant::fromValue(models);
+        if (option == QStringLiteral("DefaultColorModel")
+                || option == QStringLiteral("SupportedColorModels")
+                || option == QStringLiteral("DefaultPrintQuality")
+                || option == QStringLiteral("SupportedPrintQualities")) {
+            caps = capabilities(name);
+            break;
+        }
+    }
+
+    Q_FOREACH(const QString &option, options) {
+        if (option == QStringLiteral("DefaultColorModel") && caps.hasPpd) {
+            ret[option] = QVariant::fromValue(caps.defaultColorModel);
+        } else if (option == QStringLiteral("DefaultPrintQuality") && caps.hasPpd) {
+            ret[option] = QVariant::fromValue(caps.defaultPrintQuality);
+        } else if (option == QStringLiteral("SupportedPrintQualities") && caps.hasPpd) {
+            ret[option] = QVariant::fromValue(caps.supportedPrintQualities);
+        } else if (option == QStringLiteral("SupportedColorModels") && caps.hasPpd) {
+            ret[option] = QVariant::fromValue(caps.supportedColorModels);
         } else if (option == QStringLiteral("AcceptJobs") && dest) {
             // "true" if the destination is accepting new jobs, "false" if not.
             QString res = cupsGetOption("printer-is-accepting-jobs",
@@ -347,7 +370,18 @@ QMap<QString, QVariant> PrinterCupsBackend::printerGetOptions(
 cups_dest_t* PrinterCupsBackend::makeDest(const QString &name,
                                           const PrinterJob *options)
 {
-    cups_dest_t *dest = getDest(name);
+    cups_dest_t *cached = getDest(name);
+    if (!cached) {
+        return Q_NULLPTR;
+    }
+
+    /* The cached destination is shared with other backends, so the job
+    options are added to a copy, which is kept until the next job. */
+    cups_dest_t *dest = Q_NULLPTR;
+    cupsCopyDest(cached, 0, &dest);
+    m_printDest = QSharedPointer<cups_dest_t>(dest, [](cups_dest_t *d) {
+        cupsFreeDests(1, d);
+    });
 
     if (options->collate()) {
         __CUPS_ADD_OPTION(dest, "Collate", "True");
@@ -411,6 +445,11 @@ int PrinterCupsBackend::printFileToDest(const QString &filepath,
                                         const QString &title,
                                         const cups_dest_t *dest)
 {
+    if (!dest) {
+        qWarning() << Q_FUNC_INFO << "no destination to print" << filepath;
+        return -1;
+    }
+
     qDebug() << "Printing:" << filepath << title << dest->name << dest->num_options;
     return cupsPrintFile(dest->name,
                          filepath.toLocal8Bit(),
@@ -444,8 +483,44 @@ QList<cups_job_t *> PrinterCupsBackend::getCupsJobs(const QString &name)
 QMap<QString, QVariant> PrinterCupsBackend::printerGetJobAttributes(
     const QString &name, const int jobId)
 {
-    Q_UNUSED(name);
-    QMap<QString, QVariant> rawMap = m_client->printerGetJobAttributes(name, jobId);
+    return filterJobAttributes(m_client->printerGetJobAttributes(name, jobId));
+}
+
+QList<JobAttributes> PrinterCupsBackend::printerGetJobsAttributes(
+    const QList<QPair<QString, int>> &jobs)
+{
+    QList<int> jobIds;
+    for (int i = 0; i < jobs.size(); i++) {
+        jobIds << jobs.at(i).second;
+    }
+
+    QMap<int, QMap<QString, QVariant>> rawMaps =
+        m_client->printerGetJobsAttributes(
+            jobIds, m_jobAttributeNames + m_knownQualityOptions);
+
+    QList<JobAttributes> list;
+    for (int i = 0; i < jobs.size(); i++) {
+        JobAttributes job;
+        job.printerName = jobs.at(i).first;
+        job.jobId = jobs.at(i).second;
+
+        // Jobs missing from the reply, e.g. because cupsd does not support
+        // job-ids, are loaded one by one.
+        if (rawMaps.contains(job.jobId)) {
+            job.attributes = filterJobAttributes(rawMaps.value(job.jobId));
+        } else {
+            job.attributes = printerGetJobAttributes(job.printerName,
+                                                     job.jobId);
+        }
+        list << job;
+    }
+
+    return list;
+}
+
+QMap<QString, QVariant> PrinterCupsBackend::filterJobAttributes(
+    const QMap<QString, QVariant> &rawMap) const
+{
     QMap<QString, QVariant> map;
 
     // Filter attributes to know values
@@ -546,7 +621,7 @@ QMap<QString, QVariant> PrinterCupsBackend::printerGetJobAttributes(
     }
 
     // If there is a state then get it, as there could have been a signal
-    // flood. Which then means a forceJobRefresh is able to update the state
+    // flood. Which then means a forceJobsRefresh is able to update the state
     if (__CUPS_ATTR_EXISTS(rawMap, "job-state", int)) {
         map.insert("State", rawMap.value("job-state").toInt());
     }
@@ -629,82 +704,99 @@ QString PrinterCupsBackend::printerName() const
 
 QString PrinterCupsBackend::description() const
 {
-    return m_info.description();
+    return destOption(QStringLiteral("printer-info"));
 }
 
 QString PrinterCupsBackend::location() const
 {
-    return m_info.location();
+    return destOption(QStringLiteral("printer-location"));
 }
 
 QString PrinterCupsBackend::makeAndModel() const
 {
-    return m_info.makeAndModel();
+    return destOption(QStringLiteral("printer-make-and-model"));
 }
 
 bool PrinterCupsBackend::isRemote() const
 {
-    return m_info.isRemote();
+    return destOption(QStringLiteral("printer-type")).toUInt()
+        & CUPS_PRINTER_REMOTE;
 }
 
 PrinterEnum::State PrinterCupsBackend::state() const
 {
-    switch (m_info.state()) {
-    case QPrinter::Active:
+    if (m_hasState) {
+        return m_state;
+    }
+
+    // The same mapping as QPrinterInfo::state().
+    switch (destOption(QStringLiteral("printer-state")).toInt()) {
+    case IPP_PSTATE_IDLE:
+        return PrinterEnum::State::IdleState;
+    case IPP_PSTATE_PROCESSING:
         return PrinterEnum::State::ActiveState;
-    case QPrinter::Aborted:
-        return PrinterEnum::State::AbortedState;
-    case QPrinter::Error:
-        return PrinterEnum::State::ErrorState;
-    case QPrinter::Idle:
     default:
-        return PrinterEnum::State::IdleState;
+        return PrinterEnum::State::ErrorState;
     }
 }
 
+qint64 PrinterCupsBackend::configChangeTime() const
+{
+    if (m_printerName.isEmpty()) {
+        return -1;
+    }
+
+    // Without loading the capabilities, which would parse the PPD.
+    if (m_capabilities.contains(m_printerName)) {
+        return m_capabilities[m_printerName].changeTime;
+    }
+
+    if (!m_hasConfigChangeTime) {
+        m_configChangeTime = PrinterCache::instance()->configChangeTime(
+            m_client, getPrinterName(m_printerName));
+        m_hasConfigChangeTime = true;
+    }
+    return m_configChangeTime;
+}
+
 QList<QPageSize> PrinterCupsBackend::supportedPageSizes() const
 {
-    return m_info.supportedPageSizes();
+    return capabilities(m_printerName).supportedPageSizes;
 }
 
 QPageSize PrinterCupsBackend::defaultPageSize() const
 {
-    return m_info.defaultPageSize();
+    return capabilities(m_printerName).defaultPageSize;
 }
 
 bool PrinterCupsBackend::supportsCustomPageSizes() const
 {
-    return m_info.supportsCustomPageSizes();
+    return capabilities(m_printerName).supportsCustomPageSizes;
 }
 
 QPageSize PrinterCupsBackend::minimumPhysicalPageSize() const
 {
-    return m_info.minimumPhysicalPageSize();
+    return capabilities(m_printerName).minimumPhysicalPageSize;
 }
 
 QPageSize PrinterCupsBackend::maximumPhysicalPageSize() const
 {
-    return m_info.maximumPhysicalPageSize();
+    return capabilities(m_printerName).maximumPhysicalPageSize;
 }
 
 QList<int> PrinterCupsBackend::supportedResolutions() const
 {
-    return m_info.supportedResolutions();
+    return capabilities(m_printerName).supportedResolutions;
 }
 
 PrinterEnum::DuplexMode PrinterCupsBackend::defaultDuplexMode() const
 {
-    return Utils::qDuplexModeToDuplexMode(m_info.defaultDuplexMode());
+    return capabilities(m_printerName).defaultDuplexMode;
 }
 
 QList<PrinterEnum::DuplexMode> PrinterCupsBackend::supportedDuplexModes() const
 {
-    QList<PrinterEnum::DuplexMode> list;
-    Q_FOREACH(const QPrinter::DuplexMode mode, m_info.supportedDuplexModes()) {
-        if (mode != QPrinter::DuplexAuto) {
-            list.append(Utils::qDuplexModeToDuplexMode(mode));
-        }
-    }
+    QList<PrinterEnum::DuplexMode> list = capabilities(m_printerName).supportedDuplexModes;
 
     if (list.isEmpty())
         list.append(PrinterEnum::DuplexMode::DuplexNone);
@@ -719,18 +811,30 @@ QList<QSharedPointer<Printer>> PrinterCupsBackend::availablePrinters()
 
 QStringList PrinterCupsBackend::availablePrinterNames()
 {
-    return QPrinterInfo::availablePrinterNames();
+    return DestinationSnapshot::instance()->printerNames();
 }
 
 QSharedPointer<Printer> PrinterCupsBackend::getPrinter(const QString &printerName)
 {
-    QPrinterInfo info = QPrinterInfo::printerInfo(printerName);
-    return QSharedPointer<Printer>(new Printer(new PrinterCupsBackend(m_client, info, m_notifier)));
+    return QSharedPointer<Printer>(new Printer(
+        new PrinterCupsBackend(m_client, printerName, m_notifier)));
 }
 
 QString PrinterCupsBackend::defaultPrinterName()
 {
-    return QPrinterInfo::defaultPrinterName();
+    return DestinationSnapshot::instance()->defaultPrinterName();
+}
+
+void PrinterCupsBackend::requestJobs()
+{
+    auto loader = new JobListLoader(this);
+    connect(loader, SIGNAL(loaded(const QList<QSharedPointer<PrinterJob>>&)),
+            this, SIGNAL(jobListLoaded(const QList<QSharedPointer<PrinterJob>>&)));
+
+    TaskScheduler::instance()->submit(QStringLiteral("joblist"), loader,
+                                      "load",
+                                      TaskScheduler::Priority::Background,
+                                      this);
 }
 
 void PrinterCupsBackend::requestJobExtendedAttributes(
@@ -742,83 +846,254 @@ void PrinterCupsBackend::requestJobExtendedAttributes(
         return;
     }
 
-    auto thread = new QThread;
-    auto loader = new JobLoader(this, printer->name(), job->jobId());
-    loader->moveToThread(thread);
-    connect(thread, SIGNAL(started()), loader, SLOT(load()));
-    connect(loader, SIGNAL(finished()), thread, SLOT(quit()));
-    connect(loader, SIGNAL(finished()), loader, SLOT(deleteLater()));
-    connect(loader, SIGNAL(loaded(QString, int, QMap<QString, QVariant>)),
-            this, SIGNAL(jobLoaded(QString, int, QMap<QString, QVariant>)));
-    connect(loader, SIGNAL(loaded(QString, int, QMap<QString, QVariant>)),
-            this, SLOT(onJobLoaded(QString, int, QMap<QString, QVariant>)));
-    connect(thread, SIGNAL(finished()), thread, SLOT(deleteLater()));
-
     m_activeJobRequests << pair;
+    m_pendingJobRequests << pair;
+    m_jobRequestTimer.start();
+}
 
-    thread->start();
+void PrinterCupsBackend::refreshJobs(const QString &printerName,
+                                     const QList<int> &jobIds)
+{
+    Q_FOREACH(const int jobId, jobIds) {
+        m_refreshJobRequests << QPair<QString, int>(printerName, jobId);
+    }
+
+    // Not restarted, so that a printer changing all the time still gets
+    // its jobs refreshed.
+    if (!m_refreshJobRequests.isEmpty() && !m_jobRefreshTimer.isActive()) {
+        m_jobRefreshTimer.start();
+    }
 }
 
-void PrinterCupsBackend::requestPrinter(const QString &printerName)
+void PrinterCupsBackend::loadRefreshJobs()
 {
-    if (m_activePrinterRequests.contains(printerName)) {
+    Q_FOREACH(auto pair, m_refreshJobRequests) {
+        // The attributes in flight may predate the change.
+        if (m_activeJobRequests.contains(pair)) {
+            m_staleJobRequests << pair;
+            continue;
+        }
+
+        m_activeJobRequests << pair;
+        m_pendingJobRequests << pair;
+    }
+    m_refreshJobRequests.clear();
+
+    // All of them in one request.
+    m_jobRequestTimer.stop();
+    loadPendingJobs();
+}
+
+void PrinterCupsBackend::loadPendingJobs()
+{
+    if (m_pendingJobRequests.isEmpty()) {
         return;
     }
 
-    auto thread = new QThread;
+    // Every batch is a task of its own, jobs are deduplicated beforehand.
+    static int batch = 0;
+    QString key = QStringLiteral("jobs:%1").arg(++batch);
+
+    auto loader = new JobLoader(this, m_pendingJobRequests);
+    connect(loader, SIGNAL(loaded(const QList<JobAttributes>&)),
+            this, SIGNAL(jobsLoaded(const QList<JobAttributes>&)));
+    connect(loader, SIGNAL(loaded(const QList<JobAttributes>&)),
+            this, SLOT(onJobsLoaded(const QList<JobAttributes>&)));
+
+    m_pendingJobRequests.clear();
+
+    TaskScheduler::instance()->submit(key, loader, "load",
+                                      TaskScheduler::Priority::Background,
+                                      this);
+}
+
+void PrinterCupsBackend::requestPrinter(const QString &printerName,
+                                        const TaskScheduler::Priority priority)
+{
+    QString key = QStringLiteral("printer:%1").arg(printerName);
+
     auto loader = new PrinterLoader(printerName, m_client, m_notifier);
-    loader->moveToThread(thread);
-    connect(thread, SIGNAL(started()), loader, SLOT(load()));
-    connect(loader, SIGNAL(finished()), thread, SLOT(quit()));
-    connect(loader, SIGNAL(finished()), loader, SLOT(deleteLater()));
     connect(loader, SIGNAL(loaded(QSharedPointer<Printer>)),
             this, SIGNAL(printerLoaded(QSharedPointer<Printer>)));
-    connect(loader, SIGNAL(loaded(QSharedPointer<Printer>)),
-            this, SLOT(onPrinterLoaded(QSharedPointer<Printer>)));
-    connect(thread, SIGNAL(finished()), thread, SLOT(deleteLater()));
 
-    m_activePrinterRequests << printerName;
+    // If the printer is already being loaded this only raises its priority.
+    TaskScheduler::instance()->submit(key, loader, "load", priority, this);
+}
 
-    thread->start();
+void PrinterCupsBackend::requestPrinterState(const QString &printerName)
+{
+    // The state being loaded may predate the change, so load it again after.
+    if (m_activeStateRequests.contains(printerName)) {
+        m_staleStateRequests << printerName;
+        return;
+    }
+    m_activeStateRequests << printerName;
+
+    QString key = QStringLiteral("state:%1").arg(printerName);
+
+    auto loader = new PrinterStateLoader(printerName, m_client);
+    connect(loader, SIGNAL(loaded(const PrinterStateAttributes&)),
+            this, SLOT(onPrinterStateLoaded(const PrinterStateAttributes&)));
+
+    TaskScheduler::instance()->submit(key, loader, "load",
+                                      TaskScheduler::Priority::Background,
+                                      this);
+}
+
+void PrinterCupsBackend::requestPrinterOptions(const QString &printerName,
+                                               const QStringList &options)
+{
+    QString key = QStringLiteral("options:%1:%2").arg(printerName)
+                                                 .arg(options.join(","));
+
+    auto loader = new PrinterOptionsLoader(printerName, options, m_client,
+                                           m_notifier);
+    // The capabilities come first, so that they are here with the options.
+    connect(loader, &PrinterOptionsLoader::capabilitiesLoaded,
+            this, &PrinterCupsBackend::onCapabilitiesLoaded);
+    connect(loader, &PrinterOptionsLoader::loaded,
+            this, &PrinterBackend::printerOptionsLoaded);
+
+    // Options are asked for when something is about to show them.
+    TaskScheduler::instance()->submit(key, loader, "load",
+                                      TaskScheduler::Priority::Visible,
+                                      this);
+}
+
+bool PrinterCupsBackend::loadedCapabilities(
+        PrinterCapabilities *capabilities) const
+{
+    if (!m_capabilities.contains(m_printerName)) {
+        return false;
+    }
+
+    *capabilities = m_capabilities[m_printerName];
+    return true;
+}
+
+void PrinterCupsBackend::setCapabilitiesInternal(
+        const PrinterCapabilities &capabilities)
+{
+    m_capabilities[m_printerName] = capabilities;
+}
+
+void PrinterCupsBackend::onCapabilitiesLoaded(
+        const PrinterCapabilities &capabilities)
+{
+    setCapabilitiesInternal(capabilities);
+}
+
+void PrinterCupsBackend::setStateInternal(const PrinterEnum::State &state)
+{
+    m_hasState = true;
+    m_state = state;
 }
 
 void PrinterCupsBackend::requestPrinterDrivers()
 {
-    auto thread = new QThread;
     auto loader = new PrinterDriverLoader();
-    loader->moveToThread(thread);
     connect(loader, SIGNAL(error(const QString&)),
             this, SIGNAL(printerDriversFailedToLoad(const QString&)));
-    connect(this, SIGNAL(requestPrinterDriverCancel()), loader, SLOT(cancel()));
-    connect(thread, SIGNAL(started()), loader, SLOT(process()));
-    connect(loader, SIGNAL(finished()), thread, SLOT(quit()));
-    connect(loader, SIGNAL(finished()), loader, SLOT(deleteLater()));
+    /* Direct, so that the loader is cancelled while it waits for cupsd
+    rather than after. */
+    connect(this, SIGNAL(requestPrinterDriverCancel()), loader, SLOT(cancel()),
+            Qt::DirectConnection);
+    connect(loader, SIGNAL(chunkLoaded(const QList<PrinterDriver>&)),
+            this, SIGNAL(printerDriversChunkLoaded(const QList<PrinterDriver>&)));
     connect(loader, SIGNAL(loaded(const QList<PrinterDriver>&)),
             this, SIGNAL(printerDriversLoaded(const QList<PrinterDriver>&)));
-    connect(thread, SIGNAL(finished()), thread, SLOT(deleteLater()));
 
-    thread->start();
+    TaskScheduler::instance()->submit(QStringLiteral("drivers"), loader,
+                                      "process",
+                                      TaskScheduler::Priority::Background,
+                                      this);
 }
 
-void PrinterCupsBackend::cancelPrinterDriverRequest()
+void PrinterCupsBackend::cancelPrinterDrivers()
 {
     Q_EMIT requestPrinterDriverCancel();
 }
 
 void PrinterCupsBackend::searchForDevices()
 {
+    DeviceCache *cache = DeviceCache::instance();
+    if (cache->isFresh()) {
+        Q_FOREACH(const Device &device, cache->devices()) {
+            Q_EMIT deviceFound(device);
+        }
+        Q_EMIT deviceSearchFinished();
+        return;
+    }
+
+    connect(cache, SIGNAL(deviceInserted(const Device&)),
+            this, SIGNAL(deviceFound(const Device&)), Qt::UniqueConnection);
+    connect(cache, SIGNAL(searchFinished()),
+            this, SLOT(onDeviceSearchFinished()), Qt::UniqueConnection);
 
-    auto thread = new QThread;
-    auto searcher = new DeviceSearcher();
-    searcher->moveToThread(thread);
-    connect(thread, SIGNAL(started()), searcher, SLOT(load()));
-    connect(searcher, SIGNAL(finished()), thread, SLOT(quit()));
-    connect(searcher, SIGNAL(finished()), searcher, SLOT(deleteLater()));
-    connect(searcher, SIGNAL(finished()), this, SIGNAL(deviceSearchFinished()));
-    connect(searcher, SIGNAL(loaded(const Device&)),
-            this, SIGNAL(deviceFound(const Device&)));
-    connect(thread, SIGNAL(finished()), thread, SLOT(deleteLater()));
-    thread->start();
+    /* Join the search in flight. Whoever asked has cleared the devices
+    found so far, so they are sent again; the rest follow as they come. */
+    if (cache->isSearching()) {
+        Q_FOREACH(const Device &device, cache->devices()) {
+            Q_EMIT deviceFound(device);
+        }
+        return;
+    }
+
+    /* The CUPS backends are searched in groups side by side, each with its
+    own timeout in seconds, so that slow network backends do not hold up
+    the USB printers. Socket devices are found by the snmp backend. The last
+    group has all the other backends. The searches get threads of their own,
+    as they would keep the TaskScheduler busy for their whole timeout. */
+    const QList<QPair<QStringList, int>> groups({
+        qMakePair(QStringList({"usb"}), 5),
+        qMakePair(QStringList({"dnssd"}), 10),
+        qMakePair(QStringList({"ipp", "ipps"}), 10),
+        qMakePair(QStringList({"socket", "snmp"}), 10),
+        qMakePair(QStringList({"lpd"}), 10),
+    });
+    cache->begin(groups.size() + 1);
+
+    QStringList grouped;
+    for (int i = 0; i <= groups.size(); i++) {
+        QStringList include;
+        QStringList exclude;
+        int timeout = CUPS_TIMEOUT_DEFAULT;
+        if (i < groups.size()) {
+            include = groups.at(i).first;
+            timeout = groups.at(i).second;
+            grouped << include;
+        } else {
+            exclude = grouped;
+        }
+
+        // The groups can overlap, as CUPS backends may report the same
+        // device; the cache drops the duplicates.
+        auto thread = new QThread;
+        auto searcher = new DeviceSearcher(new IppClient, include, exclude,
+                                           timeout);
+        searcher->moveToThread(thread);
+        connect(thread, SIGNAL(started()), searcher, SLOT(load()));
+        connect(searcher, SIGNAL(finished()), thread, SLOT(quit()));
+        connect(searcher, SIGNAL(finished()), searcher, SLOT(deleteLater()));
+        connect(searcher, SIGNAL(loaded(const Device&)),
+                cache, SLOT(insert(const Device&)));
+        connect(searcher, SIGNAL(failed(const QString&)), cache, SLOT(fail()));
+        connect(searcher, SIGNAL(finished()), cache, SLOT(finish()));
+        connect(thread, SIGNAL(finished()), thread, SLOT(deleteLater()));
+
+        thread->start();
+    }
+}
+
+void PrinterCupsBackend::onDeviceSearchFinished()
+{
+    DeviceCache *cache = DeviceCache::instance();
+    disconnect(cache, SIGNAL(deviceInserted(const Device&)),
+               this, SIGNAL(deviceFound(const Device&)));
+    disconnect(cache, SIGNAL(searchFinished()),
+               this, SLOT(onDeviceSearchFinished()));
+
+    Q_EMIT deviceSearchFinished();
 }
 
 void PrinterCupsBackend::refresh()
@@ -826,12 +1101,19 @@ void PrinterCupsBackend::refresh()
     if (m_printerName.isEmpty()) {
         throw std::invalid_argument("Trying to refresh unnamed printer.");
     } else {
-        m_info = QPrinterInfo::printerInfo(m_printerName);
+        m_capabilities.clear();
+        m_hasConfigChangeTime = false;
+        m_hasState = false;
     }
 }
 
 void PrinterCupsBackend::createSubscription()
 {
+    // The poller of the notifier holds a subscription of its own.
+    if (m_notifier->isPolling()) {
+        return;
+    }
+
     m_cupsSubscriptionId = m_client->createSubscription();;
 }
 
@@ -861,12 +1143,11 @@ cups_dest_t* PrinterCupsBackend::getDest(const QString &name) const
     QString printerName = getPrinterName(name);
     QString instance = getPrinterInstance(name);
 
-    if (m_dests.contains(name)) {
-        return m_dests[name];
-    } else {
-        m_dests[name] = m_client->getDest(printerName, instance);
-        return m_dests[name];
+    if (!m_dests.contains(name)) {
+        m_dests[name] = PrinterCache::instance()->dest(m_client, printerName,
+                                                       instance);
     }
+    return m_dests[name].data();
 }
 
 ppd_file_t* PrinterCupsBackend::getPpd(const QString &name) const
@@ -874,12 +1155,166 @@ ppd_file_t* PrinterCupsBackend::getPpd(const QString &name) const
     QString printerName = getPrinterName(name);
     QString instance = getPrinterInstance(name);
 
-    if (m_ppds.contains(name)) {
-        return m_ppds[name];
-    } else {
-        m_ppds[name] = m_client->getPpdFile(printerName, instance);
-        return m_ppds[name];
+    if (!m_ppds.contains(name)) {
+        m_ppds[name] = PrinterCache::instance()->ppd(m_client, printerName,
+                                                     instance);
+    }
+    return m_ppds[name].data();
+}
+
+// An option of this backend's destination, as of the last snapshot.
+QString PrinterCupsBackend::destOption(const QString &option) const
+{
+    if (m_printerName.isEmpty()) {
+        return QString();
     }
+    return DestinationSnapshot::instance()->option(m_printerName, option);
+}
+
+/* Returns the capabilities of the printer. Those of this backend's printer
+are taken from the on-disk cache while its configuration is unchanged.
+
+The change time is the one fetched with the printer, which PrinterLoader
+does on a worker, as PrinterOptionsLoader does for the backends it makes.
+So revalidating the cache costs no request of its own here. */
+PrinterCapabilities PrinterCupsBackend::capabilities(const QString &name) const
+{
+    if (m_capabilities.contains(name)) {
+        return m_capabilities[name];
+    }
+
+    PrinterCapabilities caps;
+    bool cacheable = !name.isEmpty() && name == m_printerName;
+    qint64 changeTime = -1;
+
+    if (cacheable) {
+        changeTime = configChangeTime();
+    }
+
+    if (!cacheable
+            || !CapabilityCache::instance()->lookup(name, changeTime, &caps)) {
+        caps = loadCapabilities(name);
+        caps.changeTime = changeTime;
+
+        if (cacheable) {
+            CapabilityCache::instance()->store(name, caps);
+        }
+    }
+
+    m_capabilities[name] = caps;
+    return caps;
+}
+
+PrinterCapabilities PrinterCupsBackend::loadCapabilities(const QString &name) const
+{
+    PrinterCapabilities caps;
+    ppd_file_t* ppd = getPpd(name);
+
+    // The PPD is shared with backends on other threads.
+    QMutexLocker locker(PrinterCache::instance()->ppdLock());
+    if (ppd) {
+        caps.hasPpd = true;
+
+        ppd_option_t *colorModels = ppdFindOption(ppd, "ColorModel");
+        if (colorModels) {
+            ppd_choice_t* def = ppdFindChoice(colorModels,
+                                              colorModels->defchoice);
+            if (def) {
+                caps.defaultColorModel = Utils::parsePpdColorModel(
+                    def->choice, def->text, "ColorModel");
+            }
+
+            for (int i = 0; i < colorModels->num_choices; ++i) {
+                caps.supportedColorModels.append(
+                    Utils::parsePpdColorModel(
+                        colorModels->choices[i].choice,
+                        colorModels->choices[i].text,
+                        QStringLiteral("ColorModel")
+                    )
+                );
+            }
+        }
+
+        Q_FOREACH(const QString &opt, m_knownQualityOptions) {
+            ppd_option_t *qualityOpt = ppdFindOption(ppd, opt.toUtf8());
+            if (qualityOpt) {
+                ppd_choice_t* def = ppdFindChoice(qualityOpt,
+                                                  qualityOpt->defchoice);
+                if (def) {
+                    caps.defaultPrintQuality = Utils::parsePpdPrintQuality(
+                        def->choice, def->text, opt);
+                }
+
+                for (int i = 0; i < qualityOpt->num_choices; ++i) {
+                    caps.supportedPrintQualities.append(
+                        Utils::parsePpdPrintQuality(
+                            qualityOpt->choices[i].choice,
+                            qualityOpt->choices[i].text,
+                            opt
+                        )
+                    );
+                }
+            }
+        }
+
+        /* Read from the PPD already parsed above, rather than through
+        QPrinterInfo, which would download and parse it again. Sizes are in
+        points. */
+        ppd_option_t *pageSizes = ppdFindOption(ppd, "PageSize");
+        if (pageSizes) {
+            for (int i = 0; i < pageSizes->num_choices; ++i) {
+                const ppd_choice_t &choice = pageSizes->choices[i];
+                ppd_size_t *size = ppdPageSize(ppd, choice.choice);
+                if (!size) {
+                    continue;
+                }
+
+                QPageSize pageSize(
+                    QSize(qRound(size->width), qRound(size->length)),
+                    QString::fromUtf8(choice.text), QPageSize::FuzzyMatch);
+                caps.supportedPageSizes.append(pageSize);
+                if (qstrcmp(choice.choice, pageSizes->defchoice) == 0) {
+                    caps.defaultPageSize = pageSize;
+                }
+            }
+        }
+
+        caps.supportsCustomPageSizes = ppd->variable_sizes;
+        if (ppd->variable_sizes) {
+            caps.minimumPhysicalPageSize = QPageSize(
+                QSize(qRound(ppd->custom_min[0]), qRound(ppd->custom_min[1])),
+                QString(), QPageSize::ExactMatch);
+            caps.maximumPhysicalPageSize = QPageSize(
+                QSize(qRound(ppd->custom_max[0]), qRound(ppd->custom_max[1])),
+                QString(), QPageSize::ExactMatch);
+        }
+
+        ppd_option_t *resolutions = ppdFindOption(ppd, "Resolution");
+        if (resolutions) {
+            for (int i = 0; i < resolutions->num_choices; ++i) {
+                int res = Utils::parsePpdResolution(
+                    resolutions->choices[i].choice);
+                if (res > 0) {
+                    caps.supportedResolutions.append(res);
+                }
+            }
+        }
+
+        ppd_option_t *duplexModes = ppdFindOption(ppd, "Duplex");
+        if (duplexModes) {
+            caps.defaultDuplexMode = Utils::ppdChoiceToDuplexMode(
+                duplexModes->defchoice);
+            for (int i = 0; i < duplexModes->num_choices; ++i) {
+                auto mode = Utils::ppdChoiceToDuplexMode(
+                    duplexModes->choices[i].choice);
+                if (!caps.supportedDuplexModes.contains(mode)) {
+                    caps.supportedDuplexModes.append(mode);
+                }
+            }
+        }
+    }
+
+    return caps;
 }
 
 bool PrinterCupsBackend::isExtendedAttribute(const QString &attributeName) const
@@ -887,17 +1322,30 @@ bool PrinterCupsBackend::isExtendedAttribute(const QString &attributeName) const
     return m_extendedAttributeNames.contains(attributeName);
 }
 
-void PrinterCupsBackend::onJobLoaded(QString printerName, int jobId,
-                                     QMap<QString, QVariant> attributes)
+void PrinterCupsBackend::onPrinterStateLoaded(
+        const PrinterStateAttributes &attributes)
 {
-    Q_UNUSED(attributes);
+    m_activeStateRequests.remove(attributes.printerName);
+    Q_EMIT printerStateLoaded(attributes);
 
-    QPair<QString, int> pair(printerName, jobId);
-    m_activeJobRequests.remove(pair);
+    if (m_staleStateRequests.remove(attributes.printerName)) {
+        requestPrinterState(attributes.printerName);
+    }
 }
 
-void PrinterCupsBackend::onPrinterLoaded(QSharedPointer<Printer> printer)
+void PrinterCupsBackend::onJobsLoaded(const QList<JobAttributes> &jobs)
 {
-    m_activePrinterRequests.remove(printer->name());
+    Q_FOREACH(const JobAttributes &job, jobs) {
+        QPair<QString, int> pair(job.printerName, job.jobId);
+        m_activeJobRequests.remove(pair);
+
+        if (m_staleJobRequests.remove(pair)) {
+            m_refreshJobRequests << pair;
+        }
+    }
+
+    if (!m_refreshJobRequests.isEmpty() && !m_jobRefreshTimer.isActive()) {
+        m_jobRefreshTimer.start();
+    }
 }
 
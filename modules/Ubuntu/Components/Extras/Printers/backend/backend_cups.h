@@ -18,20 +18,21 @@
 #define USC_PRINTERS_CUPS_BACKEND_H
 
 #include "backend/backend.h"
+#include "backend/capabilitycache.h"
+#include "cups/cupsnotifier.h"
 #include "cups/ippclient.h"
-#include "cupsdnotifier.h" // Note: this file was generated.
 
 #include <cups/cups.h>
 
-#include <QPrinterInfo>
 #include <QSet>
+#include <QTimer>
 
 class PRINTERS_DECL_EXPORT PrinterCupsBackend : public PrinterBackend
 {
     Q_OBJECT
 public:
-    explicit PrinterCupsBackend(IppClient *client, QPrinterInfo info,
-                                OrgCupsCupsdNotifierInterface* notifier,
+    explicit PrinterCupsBackend(IppClient *client, const QString &printerName,
+                                CupsNotifier* notifier,
                                 QObject *parent = Q_NULLPTR);
     virtual ~PrinterCupsBackend() override;
 
@@ -91,6 +92,7 @@ public:
     virtual bool isRemote() const override;
 
     virtual PrinterEnum::State state() const override;
+    virtual qint64 configChangeTime() const override;
     virtual QList<QPageSize> supportedPageSizes() const override;
     virtual QPageSize defaultPageSize() const override;
     virtual bool supportsCustomPageSizes() const override;
@@ -106,13 +108,30 @@ public:
     virtual QSharedPointer<Printer> getPrinter(const QString &printerName) override;
     virtual QString defaultPrinterName() override;
 
+    virtual void requestJobs() override;
     virtual void requestJobExtendedAttributes(
             QSharedPointer<Printer> printer,
             QSharedPointer<PrinterJob> job) override;
+    virtual void refreshJobs(const QString &printerName,
+                             const QList<int> &jobIds) override;
     virtual void requestPrinterDrivers() override;
-    virtual void requestPrinter(const QString &printerName) override;
+    virtual void cancelPrinterDrivers() override;
+    virtual void requestPrinter(
+            const QString &printerName,
+            const TaskScheduler::Priority priority
+                = TaskScheduler::Priority::Background) override;
+    virtual void requestPrinterState(const QString &printerName) override;
+    virtual void requestPrinterOptions(const QString &printerName,
+                                       const QStringList &options) override;
+    virtual void setStateInternal(const PrinterEnum::State &state) override;
+    /* Gives the capabilities of the printer if they are loaded already, and
+    takes those loaded by another backend of the same printer. */
+    bool loadedCapabilities(PrinterCapabilities *capabilities) const;
+    void setCapabilitiesInternal(const PrinterCapabilities &capabilities);
     virtual QMap<QString, QVariant> printerGetJobAttributes(
         const QString &name, const int jobId) override;
+    virtual QList<JobAttributes> printerGetJobsAttributes(
+        const QList<QPair<QString, int>> &jobs) override;
 
 public Q_SLOTS:
     virtual void refresh() override;
@@ -131,30 +150,57 @@ Q_SIGNALS:
 
 private:
     void cancelSubscription();
-    void cancelPrinterDriverRequest();
     QList<cups_job_t *> getCupsJobs(const QString &name = QStringLiteral());
 
     QString getPrinterName(const QString &name) const;
     QString getPrinterInstance(const QString &name) const;
     cups_dest_t* getDest(const QString &name) const;
     ppd_file_t* getPpd(const QString &name) const;
+    QString destOption(const QString &option) const;
+    PrinterCapabilities capabilities(const QString &name) const;
+    PrinterCapabilities loadCapabilities(const QString &name) const;
     bool isExtendedAttribute(const QString &attributeName) const;
+    QMap<QString, QVariant> filterJobAttributes(
+        const QMap<QString, QVariant> &rawMap) const;
 
     const QStringList m_knownQualityOptions;
     const QStringList m_extendedAttributeNames;
+    const QStringList m_jobAttributeNames;
     IppClient *m_client;
-    QPrinterInfo m_info;
-    OrgCupsCupsdNotifierInterface *m_notifier;
+    CupsNotifier *m_notifier;
     int m_cupsSubscriptionId;
-    mutable QMap<QString, cups_dest_t*> m_dests; // Printer name, dest.
-    mutable QMap<QString, ppd_file_t*> m_ppds; // Printer name, ppd.
-    QSet<QString> m_activePrinterRequests;
+    // Printer name, dest. Shared with other backends via PrinterCache.
+    mutable QMap<QString, QSharedPointer<cups_dest_t>> m_dests;
+    // Printer name, ppd. Shared with other backends via PrinterCache.
+    mutable QMap<QString, QSharedPointer<ppd_file_t>> m_ppds;
+    QSharedPointer<cups_dest_t> m_printDest; // Last dest made for a job.
+    // Printer name, capabilities.
+    mutable QMap<QString, PrinterCapabilities> m_capabilities;
     QSet<QPair<QString, int>> m_activeJobRequests;
+    QList<QPair<QString, int>> m_pendingJobRequests;
+    QTimer m_jobRequestTimer;
+    // Jobs to refresh at the next interval, and those to refresh again once
+    // their request in flight is done.
+    QSet<QPair<QString, int>> m_refreshJobRequests;
+    QSet<QPair<QString, int>> m_staleJobRequests;
+    QTimer m_jobRefreshTimer;
+    // The state last loaded by requestPrinterState, if any.
+    bool m_hasState = false;
+    // Fetched once, unless the capabilities have one.
+    mutable bool m_hasConfigChangeTime = false;
+    mutable qint64 m_configChangeTime = -1;
+    PrinterEnum::State m_state = PrinterEnum::State::IdleState;
+    // Printers whose state is being loaded, and those changed meanwhile.
+    QSet<QString> m_activeStateRequests;
+    QSet<QString> m_staleStateRequests;
 
 private Q_SLOTS:
-    void onJobLoaded(QString printerName, int jobId,
-                     QMap<QString, QVariant> attributes);
-    void onPrinterLoaded(QSharedPointer<Printer> printer);
+    void loadPendingJobs();
+    void loadRefreshJobs();
+    void onJobsLoaded(const QList<JobAttributes> &jobs);
+    void onPrinterStateLoaded(const PrinterStateAttributes &attributes);
+    void onCapabilitiesLoaded(const PrinterCapabilities &capabilities);
+    void onDeviceSearchFinished();
 };
 
 #endif // USC_PRINTERS_CUPS_BACKEND_H
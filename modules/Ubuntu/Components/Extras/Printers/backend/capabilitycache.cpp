@@ -0,0 +1,278 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "backend/capabilitycache.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QPointer>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+// Bump the version when the format changes; older files are then ignored.
+#define CAPABILITY_CACHE_MAGIC 0x50434150 // "PCAP"
+#define CAPABILITY_CACHE_VERSION 2
+
+// Milliseconds to wait for further changes before writing the file.
+#define CAPABILITY_CACHE_SAVE_DELAY 2000
+
+static QDataStream& operator<<(QDataStream &out, const ColorModel &model)
+{
+    out << model.name << model.text << static_cast<qint32>(model.colorType)
+        << model.originalOption;
+    return out;
+}
+
+static QDataStream& operator>>(QDataStream &in, ColorModel &model)
+{
+    qint32 colorType;
+    in >> model.name >> model.text >> colorType >> model.originalOption;
+    model.colorType = static_cast<PrinterEnum::ColorModelType>(colorType);
+    return in;
+}
+
+static QDataStream& operator<<(QDataStream &out, const PrintQuality &quality)
+{
+    out << quality.name << quality.text << quality.originalOption;
+    return out;
+}
+
+static QDataStream& operator>>(QDataStream &in, PrintQuality &quality)
+{
+    in >> quality.name >> quality.text >> quality.originalOption;
+    return in;
+}
+
+static QDataStream& operator<<(QDataStream &out,
+                               const PrinterCapabilities &caps)
+{
+    QList<qint32> duplexModes;
+    Q_FOREACH(const PrinterEnum::DuplexMode mode, caps.supportedDuplexModes) {
+        duplexModes << static_cast<qint32>(mode);
+    }
+
+    out << caps.changeTime << caps.hasPpd
+        << caps.defaultColorModel << caps.supportedColorModels
+        << caps.defaultPrintQuality << caps.supportedPrintQualities
+        << caps.supportedPageSizes << caps.defaultPageSize
+        << caps.supportsCustomPageSizes
+        << caps.minimumPhysicalPageSize << caps.maximumPhysicalPageSize
+        << caps.supportedResolutions
+        << static_cast<qint32>(caps.defaultDuplexMode) << duplexModes;
+    return out;
+}
+
+static QDataStream& operator>>(QDataStream &in, PrinterCapabilities &caps)
+{
+    qint32 defaultDuplexMode;
+    QList<qint32> duplexModes;
+
+    in >> caps.changeTime >> caps.hasPpd
+       >> caps.defaultColorModel >> caps.supportedColorModels
+       >> caps.defaultPrintQuality >> caps.supportedPrintQualities
+       >> caps.supportedPageSizes >> caps.defaultPageSize
+       >> caps.supportsCustomPageSizes
+       >> caps.minimumPhysicalPageSize >> caps.maximumPhysicalPageSize
+       >> caps.supportedResolutions
+       >> defaultDuplexMode >> duplexModes;
+
+    caps.defaultDuplexMode = static_cast<PrinterEnum::DuplexMode>(defaultDuplexMode);
+    caps.supportedDuplexModes.clear();
+    Q_FOREACH(const qint32 mode, duplexModes) {
+        caps.supportedDuplexModes << static_cast<PrinterEnum::DuplexMode>(mode);
+    }
+    return in;
+}
+
+CapabilityCache::CapabilityCache(const QString &path, QObject *parent)
+    : QObject(parent)
+    , m_path(path)
+    , m_saveTimer(this)
+{
+    m_saveTimer.setSingleShot(true);
+    m_saveTimer.setInterval(CAPABILITY_CACHE_SAVE_DELAY);
+    connect(&m_saveTimer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+CapabilityCache::~CapabilityCache()
+{
+    flush();
+}
+
+CapabilityCache* CapabilityCache::instance()
+{
+    static QPointer<CapabilityCache> cache;
+
+    if (!cache) {
+        auto path = QStandardPaths::writableLocation(
+            QStandardPaths::CacheLocation) + "/printer-capabilities";
+        cache = new CapabilityCache(path, QCoreApplication::instance());
+    }
+    return cache;
+}
+
+bool CapabilityCache::lookup(const QString &printerName,
+                             const qint64 changeTime,
+                             PrinterCapabilities *capabilities)
+{
+    QMutexLocker locker(&m_mutex);
+    ensureLoaded();
+
+    auto it = m_entries.find(printerName);
+    if (changeTime < 0 || it == m_entries.end()) {
+        return false;
+    }
+
+    // The printer was reconfigured, so the entry will never match again.
+    if (it.value().changeTime != changeTime) {
+        m_entries.erase(it);
+        scheduleSave();
+        return false;
+    }
+
+    *capabilities = it.value();
+    return true;
+}
+
+void CapabilityCache::store(const QString &printerName,
+                            const PrinterCapabilities &capabilities)
+{
+    if (capabilities.changeTime < 0) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    ensureLoaded();
+
+    m_entries.insert(printerName, capabilities);
+    scheduleSave();
+}
+
+void CapabilityCache::remove(const QString &printerName)
+{
+    QMutexLocker locker(&m_mutex);
+    ensureLoaded();
+
+    if (m_entries.remove(printerName) > 0) {
+        scheduleSave();
+    }
+}
+
+void CapabilityCache::flush()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_dirty) {
+        save();
+    }
+}
+
+void CapabilityCache::printerDeleted(const QString &text,
+                                     const QString &printerUri,
+                                     const QString &printerName,
+                                     uint printerState,
+                                     const QString &printerStateReason,
+                                     bool acceptingJobs)
+{
+    Q_UNUSED(text);
+    Q_UNUSED(printerUri);
+    Q_UNUSED(printerState);
+    Q_UNUSED(printerStateReason);
+    Q_UNUSED(acceptingJobs);
+
+    QMutexLocker locker(&m_mutex);
+    ensureLoaded();
+
+    // Instances of the printer go with it.
+    QMutableMapIterator<QString, PrinterCapabilities> it(m_entries);
+    while (it.hasNext()) {
+        it.next();
+        if (it.key() == printerName
+                || it.key().startsWith(printerName + "/")) {
+            it.remove();
+            scheduleSave();
+        }
+    }
+}
+
+void CapabilityCache::ensureLoaded()
+{
+    if (m_loaded) {
+        return;
+    }
+    m_loaded = true;
+
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic;
+    qint32 version;
+    in >> magic >> version;
+    if (magic != CAPABILITY_CACHE_MAGIC || version != CAPABILITY_CACHE_VERSION) {
+        return;
+    }
+
+    QMap<QString, PrinterCapabilities> entries;
+    in >> entries;
+    if (in.status() != QDataStream::Ok) {
+        qWarning() << Q_FUNC_INFO << "ignoring corrupt cache" << m_path;
+        return;
+    }
+
+    m_entries = entries;
+}
+
+// Called with the lock held, from any thread; the timer lives in ours.
+void CapabilityCache::scheduleSave()
+{
+    m_dirty = true;
+    QMetaObject::invokeMethod(&m_saveTimer, "start", Qt::QueuedConnection);
+}
+
+void CapabilityCache::save()
+{
+    m_dirty = false;
+
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+
+    QSaveFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << Q_FUNC_INFO << "failed to write" << m_path
+                   << file.errorString();
+        return;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << static_cast<quint32>(CAPABILITY_CACHE_MAGIC)
+        << static_cast<qint32>(CAPABILITY_CACHE_VERSION)
+        << m_entries;
+
+    if (!file.commit()) {
+        qWarning() << Q_FUNC_INFO << "failed to write" << m_path
+                   << file.errorString();
+    }
+}
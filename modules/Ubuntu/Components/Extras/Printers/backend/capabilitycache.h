@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef USC_PRINTERS_CAPABILITYCACHE_H
+#define USC_PRINTERS_CAPABILITYCACHE_H
+
+#include "printers_global.h"
+#include "enums.h"
+#include "structs.h"
+
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QObject>
+#include <QPageSize>
+#include <QString>
+#include <QTimer>
+
+/* What a printer can do, as derived from its PPD. */
+struct PrinterCapabilities
+{
+    qint64 changeTime = -1; // The printer-config-change-time.
+
+    bool hasPpd = false;
+    ColorModel defaultColorModel;
+    QList<ColorModel> supportedColorModels;
+    PrintQuality defaultPrintQuality;
+    QList<PrintQuality> supportedPrintQualities;
+
+    QList<QPageSize> supportedPageSizes;
+    QPageSize defaultPageSize;
+    bool supportsCustomPageSizes = false;
+    QPageSize minimumPhysicalPageSize;
+    QPageSize maximumPhysicalPageSize;
+    QList<int> supportedResolutions;
+    PrinterEnum::DuplexMode defaultDuplexMode
+        = PrinterEnum::DuplexMode::DuplexNone;
+    QList<PrinterEnum::DuplexMode> supportedDuplexModes;
+};
+
+Q_DECLARE_METATYPE(PrinterCapabilities)
+
+/* Keeps the capabilities of printers on disk, so that they are available
+without downloading and parsing PPDs. An entry is only returned while the
+printer-config-change-time of its printer is unchanged, and is dropped
+once it is found to be stale or its printer is deleted. Changes are written
+out together, shortly after the last one, so that loading many printers
+writes the file once. May be used from any thread. */
+class PRINTERS_DECL_EXPORT CapabilityCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CapabilityCache(const QString &path, QObject *parent = Q_NULLPTR);
+    ~CapabilityCache();
+
+    // The cache shared by all the backends, kept in the user's cache dir.
+    static CapabilityCache* instance();
+
+    bool lookup(const QString &printerName, const qint64 changeTime,
+                PrinterCapabilities *capabilities);
+    void store(const QString &printerName,
+               const PrinterCapabilities &capabilities);
+    void remove(const QString &printerName);
+
+public Q_SLOTS:
+    // Writes pending changes now, instead of when the timer fires.
+    void flush();
+    void printerDeleted(const QString &text, const QString &printerUri,
+                        const QString &printerName, uint printerState,
+                        const QString &printerStateReason,
+                        bool acceptingJobs);
+
+private:
+    void ensureLoaded();
+    void scheduleSave();
+    void save();
+
+    const QString m_path;
+    QMutex m_mutex;
+    bool m_loaded = false;
+    bool m_dirty = false;
+    QMap<QString, PrinterCapabilities> m_entries;
+    QTimer m_saveTimer;
+};
+
+#endif // USC_PRINTERS_CAPABILITYCACHE_H
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "backend/devicecache.h"
+
+#include <QCoreApplication>
+#include <QPointer>
+
+// How long the results of a search are reused, in milliseconds.
+#define DEVICE_CACHE_TTL 120000
+
+DeviceCache::DeviceCache(const qint64 ttl, QObject *parent)
+    : QObject(parent)
+    , m_ttl(ttl)
+{
+}
+
+DeviceCache::~DeviceCache()
+{
+}
+
+DeviceCache* DeviceCache::instance()
+{
+    static QPointer<DeviceCache> cache;
+
+    if (!cache) {
+        cache = new DeviceCache(DEVICE_CACHE_TTL, QCoreApplication::instance());
+    }
+    return cache;
+}
+
+bool DeviceCache::isFresh() const
+{
+    return !m_searching && m_finished.isValid()
+        && m_finished.elapsed() < m_ttl;
+}
+
+bool DeviceCache::isSearching() const
+{
+    return m_searching;
+}
+
+QList<Device> DeviceCache::devices() const
+{
+    return m_devices;
+}
+
+void DeviceCache::begin(const int searches)
+{
+    m_searching = true;
+    m_searches = searches;
+    m_failed = false;
+    m_devices.clear();
+    m_keys.clear();
+    m_finished.invalidate();
+}
+
+bool DeviceCache::insert(const Device &device)
+{
+    QString key = device.key();
+    if (m_keys.contains(key)) {
+        return false;
+    }
+
+    m_keys << key;
+    m_devices << device;
+    Q_EMIT deviceInserted(device);
+    return true;
+}
+
+void DeviceCache::fail()
+{
+    m_failed = true;
+}
+
+void DeviceCache::finish()
+{
+    if (!m_searching || --m_searches > 0) {
+        return;
+    }
+
+    m_searching = false;
+    if (!m_failed) {
+        m_finished.start();
+    }
+    Q_EMIT searchFinished();
+}
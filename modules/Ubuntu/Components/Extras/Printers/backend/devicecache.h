@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USC_PRINTERS_DEVICECACHE_H
+#define USC_PRINTERS_DEVICECACHE_H
+
+#include "printers_global.h"
+
+#include "structs.h"
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QString>
+
+/* The devices found by the last search, so that opening the page for adding
+a printer again shows them right away, instead of after another search of
+10 seconds or more. The results are reused for ttl milliseconds after the
+search finished, provided that none of its parts failed. Devices are told
+apart by Device::key(). The cache also keeps count of the searches in
+flight, so that a backend asking for devices meanwhile joins the search
+rather than starting another. Must be used from the main thread. */
+class PRINTERS_DECL_EXPORT DeviceCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DeviceCache(const qint64 ttl, QObject *parent = Q_NULLPTR);
+    ~DeviceCache();
+
+    // The cache shared by all the backends.
+    static DeviceCache* instance();
+
+    // Whether a search finished less than ttl milliseconds ago.
+    bool isFresh() const;
+    bool isSearching() const;
+    QList<Device> devices() const;
+
+    // Forgets the devices of the last search, which is made of searches parts.
+    void begin(const int searches = 1);
+
+public Q_SLOTS:
+    // Returns false if the device was found already.
+    bool insert(const Device &device);
+    // Marks the search as failed, so that its devices are not reused.
+    void fail();
+    // Ends one part of the search.
+    void finish();
+
+Q_SIGNALS:
+    void deviceInserted(const Device &device);
+    // Emitted once all the parts of the search have ended.
+    void searchFinished();
+
+private:
+    const qint64 m_ttl;
+    bool m_searching = false;
+    int m_searches = 0;
+    bool m_failed = false;
+    QList<Device> m_devices;
+    QSet<QString> m_keys;
+    QElapsedTimer m_finished;
+};
+
+#endif // USC_PRINTERS_DEVICECACHE_H
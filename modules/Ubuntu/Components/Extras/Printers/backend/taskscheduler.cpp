@@ -0,0 +1,275 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "backend/taskscheduler.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QMetaObject>
+
+#define PRIORITY_COUNT 3
+
+TaskWorker::TaskWorker(TaskScheduler *scheduler)
+    : QObject(scheduler)
+    , m_scheduler(scheduler)
+{
+    m_thread.start();
+}
+
+TaskWorker::~TaskWorker()
+{
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void TaskWorker::run(const QString &key, QObject *owner, QObject *task,
+                     const QByteArray &slot)
+{
+    m_key = key;
+    m_owner = owner;
+    m_hasOwner = owner != Q_NULLPTR;
+    m_timer.start();
+
+    task->moveToThread(&m_thread);
+    connect(task, SIGNAL(finished()), this, SLOT(onTaskFinished()));
+    connect(task, SIGNAL(finished()), task, SLOT(deleteLater()));
+
+    if (!QMetaObject::invokeMethod(task, slot.constData(),
+                                   Qt::QueuedConnection)) {
+        qWarning() << Q_FUNC_INFO << "unable to run" << key
+                   << "no slot named" << slot;
+        task->deleteLater();
+        QMetaObject::invokeMethod(this, "onTaskFinished", Qt::QueuedConnection);
+    }
+}
+
+bool TaskWorker::isIdle() const
+{
+    return m_key.isNull();
+}
+
+QString TaskWorker::key() const
+{
+    return m_key;
+}
+
+bool TaskWorker::isRunning(const QString &key, const QObject *owner) const
+{
+    if (isIdle() || m_key != key) {
+        return false;
+    }
+
+    // An owner destroyed meanwhile gets nothing from this run.
+    if (m_hasOwner) {
+        return m_owner && m_owner.data() == owner;
+    }
+    return owner == Q_NULLPTR;
+}
+
+qint64 TaskWorker::elapsed() const
+{
+    return m_timer.elapsed();
+}
+
+void TaskWorker::onTaskFinished()
+{
+    if (isIdle()) {
+        return;
+    }
+
+    m_scheduler->taskFinished(this);
+}
+
+
+TaskScheduler::TaskScheduler(const int workers, QObject *parent)
+    : QObject(parent)
+{
+    for (int i = 0; i < qMax(1, workers); i++) {
+        m_workers << new TaskWorker(this);
+    }
+    m_stats.workers = m_workers.size();
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    for (int p = 0; p < PRIORITY_COUNT; p++) {
+        Q_FOREACH(const Task &task, m_queues[p]) {
+            delete task.task;
+        }
+        m_queues[p].clear();
+    }
+
+    // Waits for the running tasks.
+    qDeleteAll(m_workers);
+    m_workers.clear();
+}
+
+TaskScheduler* TaskScheduler::instance()
+{
+    static QPointer<TaskScheduler> scheduler;
+
+    if (!scheduler) {
+        scheduler = new TaskScheduler(4, QCoreApplication::instance());
+    }
+    return scheduler;
+}
+
+bool TaskScheduler::submit(const QString &key, QObject *task, const char *slot,
+                           const Priority priority, QObject *owner)
+{
+    int queue = static_cast<int>(priority);
+    int depth = queueDepth();
+    m_stats.submitted++;
+
+    if (contains(key, owner)) {
+        m_stats.deduplicated++;
+        delete task;
+
+        // Move an already queued task forward if it is now more urgent.
+        for (int p = queue + 1; p < PRIORITY_COUNT; p++) {
+            int i = indexOf(m_queues[p], key, owner);
+            if (i > -1) {
+                m_queues[queue] << m_queues[p].takeAt(i);
+                break;
+            }
+        }
+        return false;
+    }
+
+    Task t;
+    t.key = key;
+    t.task = task;
+    t.slot = QByteArray(slot);
+    t.owner = owner;
+    t.hasOwner = owner != Q_NULLPTR;
+    t.queued.start();
+    m_queues[queue] << t;
+
+    dispatch();
+
+    if (depth != queueDepth()) {
+        Q_EMIT queueDepthChanged(queueDepth());
+    }
+    return true;
+}
+
+bool TaskScheduler::contains(const QString &key, const QObject *owner) const
+{
+    Q_FOREACH(TaskWorker *worker, m_workers) {
+        if (worker->isRunning(key, owner)) {
+            return true;
+        }
+    }
+
+    for (int p = 0; p < PRIORITY_COUNT; p++) {
+        if (indexOf(m_queues[p], key, owner) > -1) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int TaskScheduler::queueDepth() const
+{
+    int depth = 0;
+    for (int p = 0; p < PRIORITY_COUNT; p++) {
+        depth += m_queues[p].size();
+    }
+    return depth;
+}
+
+TaskScheduler::Stats TaskScheduler::stats() const
+{
+    Stats stats = m_stats;
+    stats.queued = queueDepth();
+    stats.running = 0;
+    Q_FOREACH(TaskWorker *worker, m_workers) {
+        if (!worker->isIdle()) {
+            stats.running++;
+        }
+    }
+    return stats;
+}
+
+void TaskScheduler::taskFinished(TaskWorker *worker)
+{
+    qint64 elapsed = worker->elapsed();
+    m_stats.completed++;
+    m_stats.totalRunLatency += elapsed;
+    m_stats.maxRunLatency = qMax(m_stats.maxRunLatency, elapsed);
+
+    worker->m_key = QString();
+    worker->m_owner.clear();
+    worker->m_hasOwner = false;
+
+    int depth = queueDepth();
+    dispatch();
+
+    if (depth != queueDepth()) {
+        Q_EMIT queueDepthChanged(queueDepth());
+    }
+}
+
+void TaskScheduler::dispatch()
+{
+    Q_FOREACH(TaskWorker *worker, m_workers) {
+        if (!worker->isIdle()) {
+            continue;
+        }
+
+        Task task;
+        bool found = false;
+        for (int p = 0; p < PRIORITY_COUNT && !found; p++) {
+            while (!m_queues[p].isEmpty()) {
+                task = m_queues[p].takeFirst();
+
+                // Nobody is waiting for the result any more.
+                if (task.hasOwner && !task.owner) {
+                    delete task.task;
+                    continue;
+                }
+
+                found = true;
+                break;
+            }
+        }
+
+        if (!found) {
+            break;
+        }
+
+        qint64 waited = task.queued.elapsed();
+        m_stats.totalQueueLatency += waited;
+        m_stats.maxQueueLatency = qMax(m_stats.maxQueueLatency, waited);
+
+        worker->run(task.key, task.owner, task.task, task.slot);
+    }
+}
+
+int TaskScheduler::indexOf(const QList<Task> &queue, const QString &key,
+                           const QObject *owner) const
+{
+    for (int i = 0; i < queue.size(); i++) {
+        const Task &task = queue.at(i);
+        if (task.key != key || task.hasOwner != (owner != Q_NULLPTR)) {
+            continue;
+        }
+        if (!task.hasOwner || (task.owner && task.owner.data() == owner)) {
+            return i;
+        }
+    }
+    return -1;
+}
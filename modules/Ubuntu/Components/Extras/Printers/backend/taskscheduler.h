@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USC_PRINTERS_TASKSCHEDULER_H
+#define USC_PRINTERS_TASKSCHEDULER_H
+
+#include "printers_global.h"
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QThread>
+
+class TaskScheduler;
+
+/* Runs one task at a time on its own thread. Used by TaskScheduler only. */
+class TaskWorker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TaskWorker(TaskScheduler *scheduler);
+    ~TaskWorker();
+
+    void run(const QString &key, QObject *owner, QObject *task,
+             const QByteArray &slot);
+    bool isIdle() const;
+    QString key() const;
+    bool isRunning(const QString &key, const QObject *owner) const;
+    qint64 elapsed() const;
+
+private Q_SLOTS:
+    void onTaskFinished();
+
+private:
+    friend class TaskScheduler;
+
+    TaskScheduler *m_scheduler;
+    QThread m_thread;
+    QString m_key;
+    QPointer<QObject> m_owner;
+    bool m_hasOwner = false;
+    QElapsedTimer m_timer;
+};
+
+/* Runs the background loaders of the backends on a fixed number of threads,
+instead of a new thread per request.
+
+A task is a QObject with a slot that does the work and a finished() signal,
+like PrinterLoader. Tasks are identified by a key and their owner, which
+receives the result; submitting a task whose key is already queued or
+running for the same owner does nothing, apart from raising the priority of
+the queued one. Tasks of other owners run regardless, as their results are
+delivered to their owners only. Queued tasks are started in priority order,
+and in submission order within a priority. Tasks whose owner is destroyed
+before they start are dropped. */
+class PRINTERS_DECL_EXPORT TaskScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Priority
+    {
+        // Lower values start first.
+        Visible = 0,
+        DefaultPrinter,
+        Background,
+    };
+
+    // Latencies are in milliseconds.
+    struct Stats
+    {
+        int workers = 0;
+        int queued = 0;
+        int running = 0;
+        int submitted = 0;
+        int deduplicated = 0;
+        int completed = 0;
+        qint64 totalQueueLatency = 0;
+        qint64 maxQueueLatency = 0;
+        qint64 totalRunLatency = 0;
+        qint64 maxRunLatency = 0;
+    };
+
+    explicit TaskScheduler(const int workers = 4, QObject *parent = Q_NULLPTR);
+    ~TaskScheduler();
+
+    /* The scheduler shared by all the backends. Must be called from the
+    main thread. */
+    static TaskScheduler* instance();
+
+    /* Takes ownership of the task, which is deleted once it has emitted
+    finished(), or right away if it is not scheduled. slot is the name of
+    the method that does the work, e.g. "load". Returns whether the task was
+    scheduled. */
+    bool submit(const QString &key, QObject *task, const char *slot,
+                const Priority priority, QObject *owner = Q_NULLPTR);
+    bool contains(const QString &key, const QObject *owner = Q_NULLPTR) const;
+
+    int queueDepth() const;
+    Stats stats() const;
+
+Q_SIGNALS:
+    void queueDepthChanged(int depth);
+
+private:
+    friend class TaskWorker;
+
+    struct Task
+    {
+        QString key;
+        QObject *task = Q_NULLPTR;
+        QByteArray slot;
+        QPointer<QObject> owner;
+        bool hasOwner = false;
+        QElapsedTimer queued;
+    };
+
+    void taskFinished(TaskWorker *worker);
+    void dispatch();
+    int indexOf(const QList<Task> &queue, const QString &key,
+                const QObject *owner) const;
+
+    QList<TaskWorker*> m_workers;
+    QList<Task> m_queues[3];
+    Stats m_stats;
+};
+
+#endif // USC_PRINTERS_TASKSCHEDULER_H
@@ -0,0 +1,422 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cups/cupsnotifier.h"
+#include "cups/notificationpoller.h"
+#include "cupsdnotifier.h" // Note: this file was generated.
+
+#include <QMetaObject>
+
+// How often the events are drained at most, in milliseconds; once a frame.
+#define NOTIFIER_DRAIN_INTERVAL 16
+
+CupsEventRing::CupsEventRing(const int capacity)
+    : m_capacity(2)
+{
+    while (m_capacity < capacity) {
+        m_capacity *= 2;
+    }
+    m_mask = m_capacity - 1;
+    m_slots.reset(new CupsEvent[m_capacity]);
+}
+
+int CupsEventRing::capacity() const
+{
+    return m_capacity;
+}
+
+bool CupsEventRing::isEmpty() const
+{
+    return m_head.loadAcquire() == m_tail.loadAcquire();
+}
+
+bool CupsEventRing::push(const CupsEvent &event)
+{
+    quint32 tail = m_tail.load();
+    if (tail - m_head.loadAcquire() == (quint32) m_capacity) {
+        return false;
+    }
+
+    m_slots[tail & m_mask] = event;
+    m_tail.storeRelease(tail + 1);
+    return true;
+}
+
+bool CupsEventRing::pop(CupsEvent &event)
+{
+    quint32 head = m_head.load();
+    if (head == m_tail.loadAcquire()) {
+        return false;
+    }
+
+    // Leave the slot empty so that its strings are freed now.
+    event = m_slots[head & m_mask];
+    m_slots[head & m_mask] = CupsEvent();
+    m_head.storeRelease(head + 1);
+    return true;
+}
+
+
+CupsNotifierReader::CupsNotifierReader(CupsNotifier *notifier)
+    : QObject(Q_NULLPTR)
+    , m_notifier(notifier)
+{
+}
+
+void CupsNotifierReader::onPrinterAdded(
+        const QString &text, const QString &printerUri,
+        const QString &printerName, uint printerState,
+        const QString &printerStateReasons, bool acceptingJobs)
+{
+    CupsEvent event;
+    event.type = CupsEvent::Type::PrinterAdded;
+    event.text = text;
+    event.printerUri = printerUri;
+    event.printerName = printerName;
+    event.printerState = printerState;
+    event.printerStateReasons = printerStateReasons;
+    event.acceptingJobs = acceptingJobs;
+    push(event);
+}
+
+void CupsNotifierReader::onPrinterDeleted(
+        const QString &text, const QString &printerUri,
+        const QString &printerName, uint printerState,
+        const QString &printerStateReasons, bool acceptingJobs)
+{
+    CupsEvent event;
+    event.type = CupsEvent::Type::PrinterDeleted;
+    event.text = text;
+    event.printerUri = printerUri;
+    event.printerName = printerName;
+    event.printerState = printerState;
+    event.printerStateReasons = printerStateReasons;
+    event.acceptingJobs = acceptingJobs;
+    push(event);
+}
+
+void CupsNotifierReader::onPrinterModified(
+        const QString &text, const QString &printerUri,
+        const QString &printerName, uint printerState,
+        const QString &printerStateReasons, bool acceptingJobs)
+{
+    CupsEvent event;
+    event.type = CupsEvent::Type::PrinterModified;
+    event.text = text;
+    event.printerUri = printerUri;
+    event.printerName = printerName;
+    event.printerState = printerState;
+    event.printerStateReasons = printerStateReasons;
+    event.acceptingJobs = acceptingJobs;
+    push(event);
+}
+
+void CupsNotifierReader::onPrinterStateChanged(
+        const QString &text, const QString &printerUri,
+        const QString &printerName, uint printerState,
+        const QString &printerStateReasons, bool acceptingJobs)
+{
+    CupsEvent event;
+    event.type = CupsEvent::Type::PrinterStateChanged;
+    event.text = text;
+    event.printerUri = printerUri;
+    event.printerName = printerName;
+    event.printerState = printerState;
+    event.printerStateReasons = printerStateReasons;
+    event.acceptingJobs = acceptingJobs;
+    push(event);
+}
+
+void CupsNotifierReader::onJobCreated(
+        const QString &text, const QString &printerUri,
+        const QString &printerName, uint printerState,
+        const QString &printerStateReasons, bool acceptingJobs,
+        uint jobId, uint jobState, const QString &jobStateReasons,
+        const QString &jobName, uint jobImpressionsCompleted)
+{
+    CupsEvent event;
+    event.type = CupsEvent::Type::JobCreated;
+    event.text = text;
+    event.printerUri = printerUri;
+    event.printerName = printerName;
+    event.printerState = printerState;
+    event.printerStateReasons = printerStateReasons;
+    event.acceptingJobs = acceptingJobs;
+    event.jobId = jobId;
+    event.jobState = jobState;
+    event.jobStateReasons = jobStateReasons;
+    event.jobName = jobName;
+    event.jobImpressionsCompleted = jobImpressionsCompleted;
+    push(event);
+}
+
+void CupsNotifierReader::onJobState(
+        const QString &text, const QString &printerUri,
+        const QString &printerName, uint printerState,
+        const QString &printerStateReasons, bool acceptingJobs,
+        uint jobId, uint jobState, const QString &jobStateReasons,
+        const QString &jobName, uint jobImpressionsCompleted)
+{
+    CupsEvent event;
+    event.type = CupsEvent::Type::JobState;
+    event.text = text;
+    event.printerUri = printerUri;
+    event.printerName = printerName;
+    event.printerState = printerState;
+    event.printerStateReasons = printerStateReasons;
+    event.acceptingJobs = acceptingJobs;
+    event.jobId = jobId;
+    event.jobState = jobState;
+    event.jobStateReasons = jobStateReasons;
+    event.jobName = jobName;
+    event.jobImpressionsCompleted = jobImpressionsCompleted;
+    push(event);
+}
+
+void CupsNotifierReader::onJobCompleted(
+        const QString &text, const QString &printerUri,
+        const QString &printerName, uint printerState,
+        const QString &printerStateReasons, bool acceptingJobs,
+        uint jobId, uint jobState, const QString &jobStateReasons,
+        const QString &jobName, uint jobImpressionsCompleted)
+{
+    CupsEvent event;
+    event.type = CupsEvent::Type::JobCompleted;
+    event.text = text;
+    event.printerUri = printerUri;
+    event.printerName = printerName;
+    event.printerState = printerState;
+    event.printerStateReasons = printerStateReasons;
+    event.acceptingJobs = acceptingJobs;
+    event.jobId = jobId;
+    event.jobState = jobState;
+    event.jobStateReasons = jobStateReasons;
+    event.jobName = jobName;
+    event.jobImpressionsCompleted = jobImpressionsCompleted;
+    push(event);
+}
+
+void CupsNotifierReader::onEvents(const QList<CupsEvent> &events)
+{
+    Q_FOREACH(const CupsEvent &event, events) {
+        push(event);
+    }
+}
+
+void CupsNotifierReader::pushBacklog()
+{
+    while (!m_backlog.isEmpty()) {
+        if (!m_notifier->m_ring.push(m_backlog.first())) {
+            break;
+        }
+        m_backlog.removeFirst();
+    }
+
+    m_notifier->m_backlogged.storeRelease(m_backlog.isEmpty() ? 0 : 1);
+
+    wake();
+}
+
+void CupsNotifierReader::push(const CupsEvent &event)
+{
+    // Events are never dropped nor reordered; once the ring is full they
+    // wait here until the notifier has drained it.
+    if (!m_backlog.isEmpty() || !m_notifier->m_ring.push(event)) {
+        m_backlog << event;
+        m_notifier->m_backlogged.storeRelease(1);
+    }
+
+    wake();
+}
+
+void CupsNotifierReader::wake()
+{
+    // One queued call until the notifier drains, however many events.
+    if (m_notifier->m_wakeScheduled.testAndSetOrdered(0, 1)) {
+        QMetaObject::invokeMethod(m_notifier, "scheduleDrain",
+                                  Qt::QueuedConnection);
+    }
+}
+
+
+CupsNotifier::CupsNotifier(const QString &path,
+                           const QDBusConnection &connection,
+                           QObject *parent)
+    : QObject(parent)
+    , m_reader(new CupsNotifierReader(this))
+{
+    m_drainTimer.setSingleShot(true);
+    m_drainTimer.setInterval(NOTIFIER_DRAIN_INTERVAL);
+    connect(&m_drainTimer, SIGNAL(timeout()), this, SLOT(drain()));
+
+    if (!connection.isConnected()) {
+        m_poller = new NotificationPoller(m_reader);
+        connect(m_poller, &NotificationPoller::eventsReceived,
+                m_reader, &CupsNotifierReader::onEvents);
+    } else {
+        auto interface = new OrgCupsCupsdNotifierInterface("", path, connection,
+                                                           m_reader);
+        connect(interface, SIGNAL(PrinterAdded(const QString&, const QString&,
+                                               const QString&, uint,
+                                               const QString&, bool)),
+                m_reader, SLOT(onPrinterAdded(const QString&, const QString&,
+                                              const QString&, uint,
+                                              const QString&, bool)));
+        connect(interface, SIGNAL(PrinterDeleted(const QString&, const QString&,
+                                                 const QString&, uint,
+                                                 const QString&, bool)),
+                m_reader, SLOT(onPrinterDeleted(const QString&, const QString&,
+                                                const QString&, uint,
+                                                const QString&, bool)));
+        connect(interface, SIGNAL(PrinterModified(const QString&, const QString&,
+                                                  const QString&, uint,
+                                                  const QString&, bool)),
+                m_reader, SLOT(onPrinterModified(const QString&, const QString&,
+                                                 const QString&, uint,
+                                                 const QString&, bool)));
+        connect(interface, SIGNAL(PrinterStateChanged(const QString&,
+                                                      const QString&,
+                                                      const QString&, uint,
+                                                      const QString&, bool)),
+                m_reader, SLOT(onPrinterStateChanged(const QString&,
+                                                     const QString&,
+                                                     const QString&, uint,
+                                                     const QString&, bool)));
+        connect(interface, SIGNAL(JobCreated(const QString&, const QString&,
+                                             const QString&, uint, const QString&,
+                                             bool, uint, uint, const QString&,
+                                             const QString&, uint)),
+                m_reader, SLOT(onJobCreated(const QString&, const QString&,
+                                            const QString&, uint, const QString&,
+                                            bool, uint, uint, const QString&,
+                                            const QString&, uint)));
+        connect(interface, SIGNAL(JobState(const QString&, const QString&,
+                                           const QString&, uint, const QString&,
+                                           bool, uint, uint, const QString&,
+                                           const QString&, uint)),
+                m_reader, SLOT(onJobState(const QString&, const QString&,
+                                          const QString&, uint, const QString&,
+                                          bool, uint, uint, const QString&,
+                                          const QString&, uint)));
+        connect(interface, SIGNAL(JobCompleted(const QString&, const QString&,
+                                               const QString&, uint,
+                                               const QString&, bool, uint, uint,
+                                               const QString&, const QString&,
+                                               uint)),
+                m_reader, SLOT(onJobCompleted(const QString&, const QString&,
+                                              const QString&, uint,
+                                              const QString&, bool, uint, uint,
+                                              const QString&, const QString&,
+                                              uint)));
+    }
+
+    // The interface or poller is a child of the reader, so it moves along
+    // and does its work on the event thread.
+    m_reader->moveToThread(&m_thread);
+    m_thread.start();
+
+    if (m_poller) {
+        QMetaObject::invokeMethod(m_poller, "start", Qt::QueuedConnection);
+    }
+}
+
+CupsNotifier::~CupsNotifier()
+{
+    // Otherwise the thread would only stop once the poll cupsd holds ends.
+    if (m_poller) {
+        m_poller->abort();
+    }
+
+    m_thread.quit();
+    m_thread.wait();
+    delete m_reader;
+}
+
+bool CupsNotifier::isPolling() const
+{
+    return m_poller != Q_NULLPTR;
+}
+
+void CupsNotifier::scheduleDrain()
+{
+    if (!m_drainTimer.isActive()) {
+        m_drainTimer.start();
+    }
+}
+
+void CupsNotifier::drain()
+{
+    // Cleared first, so that events pushed while draining wake us again.
+    m_wakeScheduled.storeRelease(0);
+
+    CupsEvent event;
+    while (m_ring.pop(event)) {
+        dispatch(event);
+    }
+
+    if (m_backlogged.loadAcquire()) {
+        QMetaObject::invokeMethod(m_reader, "pushBacklog",
+                                  Qt::QueuedConnection);
+    }
+}
+
+void CupsNotifier::dispatch(const CupsEvent &event)
+{
+    switch (event.type) {
+    case CupsEvent::Type::PrinterAdded:
+        Q_EMIT PrinterAdded(event.text, event.printerUri, event.printerName,
+                            event.printerState, event.printerStateReasons,
+                            event.acceptingJobs);
+        break;
+    case CupsEvent::Type::PrinterDeleted:
+        Q_EMIT PrinterDeleted(event.text, event.printerUri, event.printerName,
+                              event.printerState, event.printerStateReasons,
+                              event.acceptingJobs);
+        break;
+    case CupsEvent::Type::PrinterModified:
+        Q_EMIT PrinterModified(event.text, event.printerUri,
+                               event.printerName, event.printerState,
+                               event.printerStateReasons, event.acceptingJobs);
+        break;
+    case CupsEvent::Type::PrinterStateChanged:
+        Q_EMIT PrinterStateChanged(event.text, event.printerUri,
+                                   event.printerName, event.printerState,
+                                   event.printerStateReasons,
+                                   event.acceptingJobs);
+        break;
+    case CupsEvent::Type::JobCreated:
+        Q_EMIT JobCreated(event.text, event.printerUri, event.printerName,
+                          event.printerState, event.printerStateReasons,
+                          event.acceptingJobs, event.jobId, event.jobState,
+                          event.jobStateReasons, event.jobName,
+                          event.jobImpressionsCompleted);
+        break;
+    case CupsEvent::Type::JobState:
+        Q_EMIT JobState(event.text, event.printerUri, event.printerName,
+                        event.printerState, event.printerStateReasons,
+                        event.acceptingJobs, event.jobId, event.jobState,
+                        event.jobStateReasons, event.jobName,
+                        event.jobImpressionsCompleted);
+        break;
+    case CupsEvent::Type::JobCompleted:
+        Q_EMIT JobCompleted(event.text, event.printerUri, event.printerName,
+                            event.printerState, event.printerStateReasons,
+                            event.acceptingJobs, event.jobId, event.jobState,
+                            event.jobStateReasons, event.jobName,
+                            event.jobImpressionsCompleted);
+        break;
+    }
+}
@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USC_PRINTERS_CUPS_CUPSNOTIFIER_H
+#define USC_PRINTERS_CUPS_CUPSNOTIFIER_H
+
+#include "printers_global.h"
+
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QDBusConnection>
+#include <QList>
+#include <QObject>
+#include <QScopedArrayPointer>
+#include <QString>
+#include <QThread>
+#include <QTimer>
+
+class OrgCupsCupsdNotifierInterface;
+class CupsNotifier;
+class NotificationPoller;
+
+/* A signal of the cupsd notifier, as the arguments it was sent with. The
+job fields are only set for job events. */
+struct CupsEvent
+{
+    enum class Type
+    {
+        PrinterAdded = 0,
+        PrinterDeleted,
+        PrinterModified,
+        PrinterStateChanged,
+        JobCreated,
+        JobState,
+        JobCompleted,
+    };
+
+    Type type = Type::PrinterModified;
+    QString text;
+    QString printerUri;
+    QString printerName;
+    uint printerState = 0;
+    QString printerStateReasons;
+    bool acceptingJobs = false;
+    uint jobId = 0;
+    uint jobState = 0;
+    QString jobStateReasons;
+    QString jobName;
+    uint jobImpressionsCompleted = 0;
+};
+
+/* A fixed size queue of events for exactly one producer thread and one
+consumer thread, which never blocks either of them. The capacity is
+rounded up to a power of two. */
+class PRINTERS_DECL_EXPORT CupsEventRing
+{
+public:
+    explicit CupsEventRing(const int capacity = 1024);
+
+    int capacity() const;
+    bool isEmpty() const;
+
+    // Producer only. Returns false if the ring is full.
+    bool push(const CupsEvent &event);
+    // Consumer only. Returns false if the ring is empty.
+    bool pop(CupsEvent &event);
+
+private:
+    Q_DISABLE_COPY(CupsEventRing)
+
+    int m_capacity;
+    quint32 m_mask;
+    QScopedArrayPointer<CupsEvent> m_slots;
+    // Only written by the consumer.
+    QAtomicInteger<quint32> m_head;
+    // Only written by the producer.
+    QAtomicInteger<quint32> m_tail;
+};
+
+/* Receives the D-Bus signals, or the polled events, on the event thread of
+a CupsNotifier. */
+class CupsNotifierReader : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CupsNotifierReader(CupsNotifier *notifier);
+
+public Q_SLOTS:
+    void onPrinterAdded(const QString &text, const QString &printerUri,
+                        const QString &printerName, uint printerState,
+                        const QString &printerStateReasons,
+                        bool acceptingJobs);
+    void onPrinterDeleted(const QString &text, const QString &printerUri,
+                          const QString &printerName, uint printerState,
+                          const QString &printerStateReasons,
+                          bool acceptingJobs);
+    void onPrinterModified(const QString &text, const QString &printerUri,
+                           const QString &printerName, uint printerState,
+                           const QString &printerStateReasons,
+                           bool acceptingJobs);
+    void onPrinterStateChanged(const QString &text, const QString &printerUri,
+                               const QString &printerName, uint printerState,
+                               const QString &printerStateReasons,
+                               bool acceptingJobs);
+    void onJobCreated(const QString &text, const QString &printerUri,
+                      const QString &printerName, uint printerState,
+                      const QString &printerStateReasons, bool acceptingJobs,
+                      uint jobId, uint jobState, const QString &jobStateReasons,
+                      const QString &jobName, uint jobImpressionsCompleted);
+    void onJobState(const QString &text, const QString &printerUri,
+                    const QString &printerName, uint printerState,
+                    const QString &printerStateReasons, bool acceptingJobs,
+                    uint jobId, uint jobState, const QString &jobStateReasons,
+                    const QString &jobName, uint jobImpressionsCompleted);
+    void onJobCompleted(const QString &text, const QString &printerUri,
+                        const QString &printerName, uint printerState,
+                        const QString &printerStateReasons,
+                        bool acceptingJobs, uint jobId, uint jobState,
+                        const QString &jobStateReasons, const QString &jobName,
+                        uint jobImpressionsCompleted);
+    // Events pulled by a NotificationPoller.
+    void onEvents(const QList<CupsEvent> &events);
+    // Pushes the events that did not fit in the ring.
+    void pushBacklog();
+
+private:
+    void push(const CupsEvent &event);
+    void wake();
+
+    CupsNotifier *m_notifier;
+    QList<CupsEvent> m_backlog;
+};
+
+/* The cupsd notifier, read on a thread of its own.
+
+The D-Bus signals are decoded into CupsEvents on the event thread and
+queued in a CupsEventRing, which the thread of the notifier drains at most
+once per frame, emitting the signals of OrgCupsCupsdNotifierInterface that
+the backends use. A burst of notifications thus costs the GUI thread one
+wake up per frame rather than one queued call per signal.
+
+Without a system bus, the events are pulled from cupsd by a
+NotificationPoller on the event thread instead. */
+class PRINTERS_DECL_EXPORT CupsNotifier : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CupsNotifier(const QString &path,
+                          const QDBusConnection &connection,
+                          QObject *parent = Q_NULLPTR);
+    ~CupsNotifier();
+
+    // Whether the events are polled for rather than sent over D-Bus.
+    bool isPolling() const;
+
+Q_SIGNALS:
+    void PrinterAdded(const QString &text, const QString &printerUri,
+                      const QString &printerName, uint printerState,
+                      const QString &printerStateReasons, bool acceptingJobs);
+    void PrinterDeleted(const QString &text, const QString &printerUri,
+                        const QString &printerName, uint printerState,
+                        const QString &printerStateReasons,
+                        bool acceptingJobs);
+    void PrinterModified(const QString &text, const QString &printerUri,
+                         const QString &printerName, uint printerState,
+                         const QString &printerStateReasons,
+                         bool acceptingJobs);
+    void PrinterStateChanged(const QString &text, const QString &printerUri,
+                             const QString &printerName, uint printerState,
+                             const QString &printerStateReasons,
+                             bool acceptingJobs);
+    void JobCreated(const QString &text, const QString &printerUri,
+                    const QString &printerName, uint printerState,
+                    const QString &printerStateReasons, bool acceptingJobs,
+                    uint jobId, uint jobState, const QString &jobStateReasons,
+                    const QString &jobName, uint jobImpressionsCompleted);
+    void JobState(const QString &text, const QString &printerUri,
+                  const QString &printerName, uint printerState,
+                  const QString &printerStateReasons, bool acceptingJobs,
+                  uint jobId, uint jobState, const QString &jobStateReasons,
+                  const QString &jobName, uint jobImpressionsCompleted);
+    void JobCompleted(const QString &text, const QString &printerUri,
+                      const QString &printerName, uint printerState,
+                      const QString &printerStateReasons, bool acceptingJobs,
+                      uint jobId, uint jobState, const QString &jobStateReasons,
+                      const QString &jobName, uint jobImpressionsCompleted);
+
+private Q_SLOTS:
+    void scheduleDrain();
+    void drain();
+
+private:
+    friend class CupsNotifierReader;
+
+    void dispatch(const CupsEvent &event);
+
+    CupsEventRing m_ring;
+    // Set by the reader when it has woken us up, cleared when draining.
+    QAtomicInt m_wakeScheduled;
+    // Set by the reader when events are waiting for room in the ring.
+    QAtomicInt m_backlogged;
+    QTimer m_drainTimer;
+    QThread m_thread;
+    CupsNotifierReader *m_reader;
+    NotificationPoller *m_poller = Q_NULLPTR;
+};
+
+#endif // USC_PRINTERS_CUPS_CUPSNOTIFIER_H
@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cups/destinationsnapshot.h"
+
+#include <QCoreApplication>
+#include <QMutexLocker>
+#include <QPointer>
+
+DestinationSnapshot::DestinationSnapshot(IppClient *client, QObject *parent)
+    : QObject(parent)
+    , m_client(client)
+{
+}
+
+DestinationSnapshot::~DestinationSnapshot()
+{
+    clear();
+    delete m_client;
+}
+
+DestinationSnapshot* DestinationSnapshot::instance()
+{
+    static QPointer<DestinationSnapshot> snapshot;
+
+    if (!snapshot) {
+        snapshot = new DestinationSnapshot(new IppClient(1),
+                                           QCoreApplication::instance());
+    }
+    return snapshot;
+}
+
+QStringList DestinationSnapshot::printerNames()
+{
+    QMutexLocker locker(&m_mutex);
+    ensureLoaded();
+    return m_names;
+}
+
+QString DestinationSnapshot::defaultPrinterName()
+{
+    QMutexLocker locker(&m_mutex);
+    ensureLoaded();
+    return m_defaultName;
+}
+
+bool DestinationSnapshot::contains(const QString &name)
+{
+    QMutexLocker locker(&m_mutex);
+    ensureLoaded();
+    return m_names.contains(name);
+}
+
+QString DestinationSnapshot::option(const QString &name, const QString &option)
+{
+    QMutexLocker locker(&m_mutex);
+    ensureLoaded();
+
+    cups_dest_t *dest = findDest(name);
+    if (!dest) {
+        return QString();
+    }
+    return QString::fromUtf8(cupsGetOption(option.toUtf8(), dest->num_options,
+                                           dest->options));
+}
+
+cups_dest_t* DestinationSnapshot::copyDest(const QString &name,
+                                           const QString &instance)
+{
+    QMutexLocker locker(&m_mutex);
+    ensureLoaded();
+
+    cups_dest_t *dest = cupsGetDest(
+        name.toUtf8(), instance.isEmpty() ? NULL : instance.toUtf8().constData(),
+        m_numDests, m_dests);
+    if (!dest) {
+        return Q_NULLPTR;
+    }
+
+    cups_dest_t *copy = Q_NULLPTR;
+    cupsCopyDest(dest, 0, &copy);
+    return copy;
+}
+
+void DestinationSnapshot::invalidate()
+{
+    QMutexLocker locker(&m_mutex);
+    m_valid = false;
+}
+
+void DestinationSnapshot::ensureLoaded()
+{
+    if (m_valid) {
+        return;
+    }
+
+    clear();
+    m_numDests = m_client->getDests(&m_dests);
+
+    for (int i = 0; i < m_numDests; i++) {
+        const cups_dest_t *dest = &m_dests[i];
+
+        // Instances are named <printer>/<instance>, as QPrinterInfo does.
+        QString name = QString::fromUtf8(dest->name);
+        if (dest->instance) {
+            name += QLatin1Char('/') + QString::fromUtf8(dest->instance);
+        }
+
+        m_names << name;
+        if (dest->is_default) {
+            m_defaultName = name;
+        }
+    }
+
+    m_valid = true;
+}
+
+// Looks up a destination named <printer> or <printer>/<instance>.
+cups_dest_t* DestinationSnapshot::findDest(const QString &name) const
+{
+    int slash = name.indexOf(QLatin1Char('/'));
+    QByteArray printer = name.left(slash).toUtf8();
+    QByteArray instance = slash < 0 ? QByteArray() : name.mid(slash + 1).toUtf8();
+
+    return cupsGetDest(printer.constData(),
+                       instance.isEmpty() ? NULL : instance.constData(),
+                       m_numDests, m_dests);
+}
+
+void DestinationSnapshot::clear()
+{
+    if (m_dests) {
+        cupsFreeDests(m_numDests, m_dests);
+    }
+    m_dests = Q_NULLPTR;
+    m_numDests = 0;
+    m_names.clear();
+    m_defaultName = QString();
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USC_PRINTERS_CUPS_DESTINATIONSNAPSHOT_H
+#define USC_PRINTERS_CUPS_DESTINATIONSNAPSHOT_H
+
+#include "cups/ippclient.h"
+
+#include <cups/cups.h>
+
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+/* All CUPS destinations, enumerated once and shared by every printer.
+
+The snapshot only holds what cupsGetDests2 returns, which needs no PPDs. It
+is taken on first use, and again only after it has been invalidated, which
+happens when cupsd reports that a printer was added, removed or modified.
+It may be used from any thread. */
+class DestinationSnapshot : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DestinationSnapshot(IppClient *client, QObject *parent = Q_NULLPTR);
+    ~DestinationSnapshot();
+
+    /* The snapshot shared by all the backends. Must first be called from the
+    main thread. */
+    static DestinationSnapshot* instance();
+
+    QStringList printerNames();
+    QString defaultPrinterName();
+
+    bool contains(const QString &name);
+    // An option of the destination, e.g. "printer-info", or a null string.
+    QString option(const QString &name, const QString &option);
+
+    /* Returns a copy of the destination, which the caller frees with
+    cupsFreeDests, or null if there is no such destination. */
+    cups_dest_t* copyDest(const QString &name, const QString &instance);
+
+public Q_SLOTS:
+    void invalidate();
+
+private:
+    void ensureLoaded();
+    void clear();
+    cups_dest_t* findDest(const QString &name) const;
+
+    IppClient *m_client;
+    QMutex m_mutex;
+    bool m_valid = false;
+    cups_dest_t *m_dests = Q_NULLPTR;
+    int m_numDests = 0;
+    QStringList m_names;
+    QString m_defaultName;
+};
+
+#endif // USC_PRINTERS_CUPS_DESTINATIONSNAPSHOT_H
@@ -19,9 +19,15 @@
 
 #include <QUrl>
 
-DeviceSearcher::DeviceSearcher(IppClient *client, QObject *parent)
+DeviceSearcher::DeviceSearcher(IppClient *client,
+                               const QStringList &includeSchemes,
+                               const QStringList &excludeSchemes,
+                               const int timeout, QObject *parent)
     : QObject(parent)
     , m_client(client)
+    , m_includeSchemes(includeSchemes)
+    , m_excludeSchemes(excludeSchemes)
+    , m_timeout(timeout)
 {
 }
 
@@ -32,7 +38,9 @@ DeviceSearcher::~DeviceSearcher()
 
 void DeviceSearcher::load()
 {
-    if (!m_client->getDevices(&DeviceSearcher::deviceCallBack, this)) {
+    if (!m_client->getDevices(&DeviceSearcher::deviceCallBack, this,
+                              m_includeSchemes, m_excludeSchemes,
+                              m_timeout)) {
         Q_EMIT failed(cupsLastErrorString());
     }
     Q_EMIT finished();
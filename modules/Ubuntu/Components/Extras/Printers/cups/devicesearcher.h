@@ -22,15 +22,21 @@
 
 #include <QObject>
 #include <QString>
+#include <QStringList>
 
 /* Class representing a device search. It is a worker object due to the time
-such a search takes (minimum 10 seconds). */
+such a search takes (minimum 10 seconds). The search can be limited to some
+CUPS backends, so that several searches can run side by side, each with its
+own timeout in seconds. */
 class DeviceSearcher : public QObject
 {
     Q_OBJECT
     IppClient *m_client;
 public:
     explicit DeviceSearcher(IppClient *client = new IppClient,
+                            const QStringList &includeSchemes = QStringList(),
+                            const QStringList &excludeSchemes = QStringList(),
+                            const int timeout = CUPS_TIMEOUT_DEFAULT,
                             QObject *parent = Q_NULLPTR);
     ~DeviceSearcher();
 
@@ -48,6 +54,10 @@ private:
         void *context);
     void deviceFound(const Device &device);
 
+    QStringList m_includeSchemes;
+    QStringList m_excludeSchemes;
+    int m_timeout;
+
 Q_SIGNALS:
     void loaded(const Device &device);
     void failed(const QString &errorMessage);
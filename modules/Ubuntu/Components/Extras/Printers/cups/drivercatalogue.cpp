@@ -0,0 +1,339 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "cups/drivercatalogue.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QSharedPointer>
+#include <QStandardPaths>
+
+#include <cstring>
+
+// Bump the version when the format changes; older files are then ignored.
+#define DRIVER_CATALOGUE_MAGIC 0x50445243 // "PDRC"
+#define DRIVER_CATALOGUE_VERSION 1
+
+namespace
+{
+struct Header
+{
+    quint32 magic;
+    quint32 version;
+    qint64 sourceStamp;
+    quint32 count;
+    quint32 stringsSize;
+};
+
+// Offsets and lengths into the string pool.
+struct Record
+{
+    quint32 name[2];
+    quint32 deviceId[2];
+    quint32 language[2];
+    quint32 makeModel[2];
+};
+
+/* The catalogues whose drivers were loaded. They stay mapped, as the
+drivers point into them; the last one loaded is reused while unchanged. */
+struct LoadedCatalogues
+{
+    QMutex lock;
+    QList<QSharedPointer<DriverCatalogue>> catalogues;
+    QString path;
+    qint64 sourceStamp = -1;
+    QList<PrinterDriver> drivers;
+};
+Q_GLOBAL_STATIC(LoadedCatalogues, loadedCatalogues)
+}
+
+DriverCatalogue::DriverCatalogue(const QString &path)
+    : m_file(path)
+{
+}
+
+DriverCatalogue::~DriverCatalogue()
+{
+    close();
+}
+
+QString DriverCatalogue::defaultPath(const QString &server)
+{
+    QByteArray key = QCryptographicHash::hash(
+        server.toUtf8(), QCryptographicHash::Sha1).toHex().left(16);
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+        + "/printer-drivers-" + QString::fromLatin1(key);
+}
+
+bool DriverCatalogue::isLocalServer(const QString &server)
+{
+    return server.startsWith(QLatin1Char('/'))
+        || server == QStringLiteral("localhost")
+        || server == QStringLiteral("127.0.0.1")
+        || server == QStringLiteral("::1");
+}
+
+qint64 DriverCatalogue::sourceStamp(const QStringList &directories)
+{
+    qint64 stamp = -1;
+
+    Q_FOREACH(const QString &directory, directories) {
+        QFileInfo info(directory);
+        if (!info.exists()) {
+            continue;
+        }
+        stamp = qMax(stamp, info.lastModified().toMSecsSinceEpoch());
+
+        QDir dir(directory);
+        Q_FOREACH(const QFileInfo &sub, dir.entryInfoList(
+                      QDir::Dirs | QDir::NoDotAndDotDot)) {
+            stamp = qMax(stamp, sub.lastModified().toMSecsSinceEpoch());
+        }
+    }
+    return stamp;
+}
+
+qint64 DriverCatalogue::ppdSourceStamp(const QString &server)
+{
+    if (!isLocalServer(server)) {
+        return -1;
+    }
+
+    /* cupsd rebuilds its PPD database from these, but the database itself
+    is normally not readable by users. Its cache dir is left out, as cupsd
+    writes there for reasons unrelated to drivers. */
+    return sourceStamp(QStringList({
+        QStringLiteral("/usr/share/cups/drv"),
+        QStringLiteral("/usr/share/cups/model"),
+        QStringLiteral("/usr/share/ppd"),
+        QStringLiteral("/usr/lib/cups/driver"),
+        QStringLiteral("/etc/cups/ppd"),
+    }));
+}
+
+bool DriverCatalogue::write(const QString &path, const qint64 sourceStamp,
+                            const QList<PrinterDriver> &drivers)
+{
+    QByteArray strings;
+    QHash<QByteArray, quint32> interned;
+    auto intern = [&strings, &interned](const QByteArray &s, quint32 *field) {
+        auto it = interned.constFind(s);
+        if (it == interned.constEnd()) {
+            it = interned.insert(s, strings.size());
+            strings.append(s);
+        }
+        field[0] = it.value();
+        field[1] = s.size();
+    };
+
+    QByteArray records(drivers.size() * sizeof(Record), Qt::Uninitialized);
+    Record *record = reinterpret_cast<Record*>(records.data());
+    Q_FOREACH(const PrinterDriver &driver, drivers) {
+        intern(driver.name, record->name);
+        intern(driver.deviceId, record->deviceId);
+        intern(driver.language, record->language);
+        intern(driver.makeModel, record->makeModel);
+        record++;
+    }
+
+    Header header;
+    header.magic = DRIVER_CATALOGUE_MAGIC;
+    header.version = DRIVER_CATALOGUE_VERSION;
+    header.sourceStamp = sourceStamp;
+    header.count = drivers.size();
+    header.stringsSize = strings.size();
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << Q_FUNC_INFO << "failed to write" << path
+                   << file.errorString();
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    file.write(records);
+    file.write(strings);
+
+    if (!file.commit()) {
+        qWarning() << Q_FUNC_INFO << "failed to write" << path
+                   << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool DriverCatalogue::load(const QString &path, const qint64 sourceStamp,
+                           QList<PrinterDriver> &drivers)
+{
+    LoadedCatalogues *loaded = loadedCatalogues();
+    QMutexLocker locker(&loaded->lock);
+
+    if (sourceStamp >= 0 && loaded->path == path
+            && loaded->sourceStamp == sourceStamp) {
+        drivers = loaded->drivers;
+        return true;
+    }
+
+    QSharedPointer<DriverCatalogue> catalogue(new DriverCatalogue(path));
+    if (!catalogue->open(sourceStamp)) {
+        return false;
+    }
+
+    /* A catalogue loaded before is not unmapped, as the drivers taken from
+    it may still be in use. That only happens when the PPD sources change
+    while the process runs. */
+    loaded->catalogues << catalogue;
+    loaded->path = path;
+    loaded->sourceStamp = sourceStamp;
+    loaded->drivers = catalogue->drivers();
+    drivers = loaded->drivers;
+    return true;
+}
+
+bool DriverCatalogue::open(const qint64 sourceStamp)
+{
+    close();
+
+    if (sourceStamp < 0 || !m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    m_size = m_file.size();
+    if (m_size < (qint64) sizeof(Header)) {
+        close();
+        return false;
+    }
+
+    m_data = m_file.map(0, m_size);
+    if (!m_data) {
+        close();
+        return false;
+    }
+
+    Header header;
+    memcpy(&header, m_data, sizeof(Header));
+
+    qint64 expected = sizeof(Header) + (qint64) header.count * sizeof(Record)
+        + header.stringsSize;
+    if (header.magic != DRIVER_CATALOGUE_MAGIC
+            || header.version != DRIVER_CATALOGUE_VERSION
+            || header.sourceStamp != sourceStamp
+            || expected != m_size) {
+        close();
+        return false;
+    }
+
+    m_count = header.count;
+    return true;
+}
+
+void DriverCatalogue::close()
+{
+    if (m_data) {
+        m_file.unmap(const_cast<uchar*>(m_data));
+    }
+    m_file.close();
+    m_data = Q_NULLPTR;
+    m_size = 0;
+    m_count = 0;
+}
+
+bool DriverCatalogue::isOpen() const
+{
+    return m_data != Q_NULLPTR;
+}
+
+int DriverCatalogue::count() const
+{
+    return m_count;
+}
+
+PrinterDriver DriverCatalogue::driver(const int i) const
+{
+    PrinterDriver driver;
+    if (i < 0 || i >= (int) m_count) {
+        return driver;
+    }
+
+    Record record;
+    memcpy(&record, m_data + sizeof(Header) + i * sizeof(Record),
+           sizeof(Record));
+
+    driver.name = string(record.name[0], record.name[1]);
+    driver.deviceId = string(record.deviceId[0], record.deviceId[1]);
+    driver.language = string(record.language[0], record.language[1]);
+    driver.makeModel = string(record.makeModel[0], record.makeModel[1]);
+    return driver;
+}
+
+QList<PrinterDriver> DriverCatalogue::drivers() const
+{
+    /* The strings are interned in the file, so a string seen before is
+    shared instead of being wrapped again. */
+    QHash<quint64, QByteArray> strings;
+    auto string = [this, &strings](const quint32 *field) {
+        const quint64 key = (quint64) field[0] << 32 | field[1];
+        auto it = strings.constFind(key);
+        if (it == strings.constEnd()) {
+            const char *data = stringData(field[0], field[1]);
+            it = strings.insert(key, data
+                ? QByteArray::fromRawData(data, field[1]) : QByteArray());
+        }
+        return it.value();
+    };
+
+    QList<PrinterDriver> list;
+    list.reserve(m_count);
+    for (int i = 0; i < (int) m_count; i++) {
+        Record record;
+        memcpy(&record, m_data + sizeof(Header) + i * sizeof(Record),
+               sizeof(Record));
+
+        PrinterDriver driver;
+        driver.name = string(record.name);
+        driver.deviceId = string(record.deviceId);
+        driver.language = string(record.language);
+        driver.makeModel = string(record.makeModel);
+        list << driver;
+    }
+    return list;
+}
+
+const char* DriverCatalogue::stringData(const quint32 offset,
+                                        const quint32 length) const
+{
+    const qint64 strings = sizeof(Header) + (qint64) m_count * sizeof(Record);
+    if (strings + offset + length > m_size) {
+        return Q_NULLPTR;
+    }
+    return reinterpret_cast<const char*>(m_data + strings + offset);
+}
+
+QByteArray DriverCatalogue::string(const quint32 offset,
+                                   const quint32 length) const
+{
+    const char *data = stringData(offset, length);
+    return data ? QByteArray(data, length) : QByteArray();
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef USC_PRINTERS_CUPS_DRIVERCATALOGUE_H
+#define USC_PRINTERS_CUPS_DRIVERCATALOGUE_H
+
+#include "printers_global.h"
+#include "structs.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+/* The list of available printer drivers, kept on disk so that it does not
+have to be fetched with CUPS-Get-PPDs every time a printer is added.
+
+The file is a fixed-size record per driver followed by a pool of strings in
+which repeated values, like languages and device ids, are stored once. It
+is memory-mapped when opened, so opening does not depend on the number of
+drivers, and the strings of the drivers point into the mapping instead of
+being copied out. A catalogue is stale once the PPD sources changed after
+it was written. */
+class PRINTERS_DECL_EXPORT DriverCatalogue
+{
+public:
+    explicit DriverCatalogue(const QString &path);
+    ~DriverCatalogue();
+
+    // The catalogue of the drivers of the given cupsd, in the user's cache dir.
+    static QString defaultPath(const QString &server);
+
+    /* Whether cupsd runs on this machine, as with a domain socket or
+    localhost, so that its PPD sources can be looked at. */
+    static bool isLocalServer(const QString &server);
+
+    /* The newest modification time, in ms since the epoch, of the given
+    directories and of their immediate subdirectories, which is where
+    packages install drivers and PPDs. -1 if none of them exists. */
+    static qint64 sourceStamp(const QStringList &directories);
+
+    /* The source stamp of the drivers known to the given cupsd, or -1 if
+    it runs elsewhere, in which case the catalogue is not used. It covers
+    drivers and PPDs that are added or removed, including the .drv files
+    cupsd compiles, but not those updated in place, which change no
+    directory; the catalogue keeps listing those until something else
+    changes. */
+    static qint64 ppdSourceStamp(const QString &server);
+
+    static bool write(const QString &path, const qint64 sourceStamp,
+                      const QList<PrinterDriver> &drivers);
+
+    /* Gets all the drivers of the catalogue at path, as drivers() does, and
+    keeps it mapped until the process exits, so that the drivers may be
+    kept for as long as needed. Loading an unchanged catalogue again gives
+    the same list instead of reading it anew. Thread-safe. */
+    static bool load(const QString &path, const qint64 sourceStamp,
+                     QList<PrinterDriver> &drivers);
+
+    /* Maps the catalogue. Fails if it is missing or corrupt, or was written
+    for another source stamp. */
+    bool open(const qint64 sourceStamp);
+    void close();
+    bool isOpen() const;
+
+    int count() const;
+    // A copy of the given driver, which outlives the catalogue.
+    PrinterDriver driver(const int i) const;
+    /* All the drivers, whose strings point into the mapping: they must not
+    be used after the catalogue is closed. Drivers with the same value of a
+    string share it. */
+    QList<PrinterDriver> drivers() const;
+
+private:
+    const char* stringData(const quint32 offset, const quint32 length) const;
+    QByteArray string(const quint32 offset, const quint32 length) const;
+
+    QFile m_file;
+    const uchar *m_data = Q_NULLPTR;
+    qint64 m_size = 0;
+    quint32 m_count = 0;
+};
+
+#endif // USC_PRINTERS_CUPS_DRIVERCATALOGUE_H
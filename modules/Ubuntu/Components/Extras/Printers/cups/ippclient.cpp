@@ -25,26 +25,71 @@
 
 #include <QDebug>
 #include <QDateTime>
+#include <QElapsedTimer>
+#include <QMutexLocker>
 #include <QtAlgorithms>
 #include <QTimeZone>
 #include <QUrl>
+#include <QVector>
 
-IppClient::IppClient()
-    : m_connection(httpConnectEncrypt(cupsServer(),
-                                      ippPort(),
-                                      cupsEncryption()))
+// How long a request waits for a connection when all of them are in use.
+#define CONNECTION_CHECKOUT_TIMEOUT 5000
+
+// How long a broken connection may take to reconnect.
+#define CONNECTION_RECONNECT_TIMEOUT 5000
+
+IppClient::IppClient(const int maxConnections)
+    : m_maxConnections(qMax(1, maxConnections))
 {
-    if (!m_connection) {
+    // Open the first connection right away, so that failures show up early.
+    http_t *connection = openConnection();
+    if (!connection) {
         qCritical("Failed to connect to cupsd");
     } else {
         qDebug("Successfully connected to cupsd.");
+        m_openConnections++;
+        m_idleConnections << connection;
     }
 }
 
 IppClient::~IppClient()
 {
-    if (m_connection)
-        httpClose(m_connection);
+    QMutexLocker locker(&m_poolLock);
+
+    if (m_idleConnections.size() != m_openConnections) {
+        qWarning() << "Destroying IppClient with"
+                   << m_openConnections - m_idleConnections.size()
+                   << "connections still in use.";
+    }
+
+    Q_FOREACH(http_t *connection, m_idleConnections) {
+        httpClose(connection);
+    }
+    m_idleConnections.clear();
+}
+
+IppClient::ConnectionPoolStats IppClient::connectionPoolStats() const
+{
+    QMutexLocker locker(&m_poolLock);
+
+    ConnectionPoolStats stats = m_poolStats;
+    stats.openConnections = m_openConnections;
+    stats.idleConnections = m_idleConnections.size();
+    return stats;
+}
+
+void IppClient::abortRequests()
+{
+    QMutexLocker locker(&m_poolLock);
+
+    /* The blocked reads return with an error, and the connections are closed
+    when they are checked in. */
+    Q_FOREACH(http_t *connection, m_busyConnections) {
+        if (!m_abortedConnections.contains(connection)) {
+            httpShutdown(connection);
+            m_abortedConnections << connection;
+        }
+    }
 }
 
 bool IppClient::printerDelete(const QString &printerName)
@@ -352,7 +397,7 @@ bool IppClient::printerClassSetOption(const QString &name,
                                    values[0].toUtf8(),
                                    numOptions, &options);
 
-        ppdfile = QString(cupsGetPPD(name.toUtf8()));
+        ppdfile = downloadPpd(name);
 
         newPpdFile = preparePpdForOptions(ppdfile.toUtf8(),
                                           options, numOptions).toLatin1().data();
@@ -434,7 +479,7 @@ QMap<QString, QVariant> IppClient::printerGetAttributes(
     auto resource = getResource(CupsResource::CupsResourceRoot);
 
     ipp_t *reply;
-    reply = cupsDoRequest(m_connection, request, resource.toUtf8());
+    reply = doRequest(request, resource.toUtf8());
 
     if (!isReplyOk(reply, false)) {
         qWarning() << Q_FUNC_INFO << "failed to get attributes"
@@ -475,14 +520,6 @@ QMap<QString, QVariant> IppClient::printerGetJobAttributes(const QString &printe
     ipp_t *request;
     QMap<QString, QVariant> map;
 
-    // Try to get the lock, if we can't after 5 seconds then fail and return
-    if (!m_thread_lock.tryLock(5000)) {
-        qWarning() << "Unable to get lock for IppClient::printerGetJobAttributes."
-                   << "Unable to load attributes for job:" << jobId << " for "
-                   << printerName;
-        return map;
-    }
-
     // Construct request
     request = ippNewRequest(IPP_GET_JOB_ATTRIBUTES);
 
@@ -495,8 +532,7 @@ QMap<QString, QVariant> IppClient::printerGetJobAttributes(const QString &printe
     // Send request and construct reply
     ipp_t *reply;
     const QString resourceChar = getResource(CupsResourceRoot);
-    reply = cupsDoRequest(m_connection, request,
-                          resourceChar.toUtf8());
+    reply = doRequest(request, resourceChar.toUtf8());
 
     // Check if the reply is OK
     if (isReplyOk(reply, false)) {
@@ -517,11 +553,89 @@ QMap<QString, QVariant> IppClient::printerGetJobAttributes(const QString &printe
         ippDelete(reply);
     }
 
-    m_thread_lock.unlock();
-
     return map;
 }
 
+QMap<int, QMap<QString, QVariant>> IppClient::printerGetJobsAttributes(
+        const QList<int> &jobIds, const QStringList &attributes)
+{
+    QMap<int, QMap<QString, QVariant>> jobs;
+
+    if (jobIds.isEmpty()) {
+        return jobs;
+    }
+
+    ipp_t *request = ippNewRequest(IPP_GET_JOBS);
+
+    // The root uri selects the jobs of all printers.
+    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI,
+                 "printer-uri", NULL, "ipp://localhost/");
+    addRequestingUsername(request, NULL);
+
+    // job-ids replaces which-jobs, cupsd rejects requests with both.
+    ipp_attribute_t *ids = ippAddIntegers(request, IPP_TAG_OPERATION,
+                                          IPP_TAG_INTEGER, "job-ids",
+                                          jobIds.size(), NULL);
+    for (int i = 0; i < jobIds.size(); i++) {
+        ippSetInteger(request, &ids, i, jobIds.at(i));
+    }
+
+    QStringList requested(attributes);
+    if (!requested.contains(QStringLiteral("job-id"))) {
+        requested << QStringLiteral("job-id");
+    }
+    ipp_attribute_t *attrs = ippAddStrings(request, IPP_TAG_OPERATION,
+                                           IPP_TAG_KEYWORD,
+                                           "requested-attributes",
+                                           requested.size(), NULL, NULL);
+    for (int i = 0; i < requested.size(); i++) {
+        ippSetString(request, &attrs, i, requested.at(i).toUtf8());
+    }
+
+    ipp_t *reply = doRequest(request, getResource(CupsResourceRoot).toUtf8());
+
+    if (isReplyOk(reply, false)) {
+        /* The reply holds one attribute group per job, separated by
+        attributes without a name. */
+        QMap<QString, QVariant> map;
+        int jobId = -1;
+
+        for (ipp_attribute_t *attr = ippFirstAttribute(reply); ;
+                attr = ippNextAttribute(reply)) {
+            if (!attr || !ippGetName(attr)) {
+                if (jobId > 0) {
+                    jobs.insert(jobId, map);
+                }
+                map.clear();
+                jobId = -1;
+
+                if (!attr) {
+                    break;
+                }
+                continue;
+            }
+
+            if (ippGetGroupTag(attr) != IPP_TAG_JOB) {
+                continue;
+            }
+
+            QString name = QString::fromUtf8(ippGetName(attr));
+            if (name == QStringLiteral("job-id")) {
+                jobId = ippGetInteger(attr, 0);
+            }
+            map.insert(name, getAttributeValue(attr));
+        }
+    } else {
+        qWarning() << "Not able to get attributes of" << jobIds.size()
+                   << "jobs.";
+    }
+
+    if (reply) {
+        ippDelete(reply);
+    }
+
+    return jobs;
+}
 
 /* This function sets given options to specified values in file 'ppdfile'.
  * This needs to be done because of applications which use content of PPD files
@@ -816,11 +930,9 @@ bool IppClient::postRequest(ipp_t *request, const QString &file,
     resourceChar = getResource(resource);
 
     if (!file.isEmpty())
-        reply = cupsDoFileRequest(m_connection, request, resourceChar.toUtf8(),
-                                  file.toUtf8());
+        reply = doFileRequest(request, resourceChar.toUtf8(), file.toUtf8());
     else
-        reply = cupsDoFileRequest(m_connection, request, resourceChar.toUtf8(),
-                                  NULL);
+        reply = doFileRequest(request, resourceChar.toUtf8(), NULL);
 
     return handleReply(reply);
 }
@@ -830,8 +942,7 @@ bool IppClient::sendRequest(ipp_t *request, const CupsResource &resource)
 {
     ipp_t *reply;
     const QString resourceChar = getResource(resource);
-    reply = cupsDoRequest(m_connection, request,
-                          resourceChar.toUtf8());
+    reply = doRequest(request, resourceChar.toUtf8());
     return handleReply(reply);
 }
 
@@ -908,7 +1019,7 @@ bool IppClient::printerIsClass(const QString &name)
                   "requested-attributes", 1, NULL, attrs);
 
     resource = getResource(CupsResource::CupsResourceRoot);
-    reply = cupsDoRequest(m_connection, request, resource.toUtf8());
+    reply = doRequest(request, resource.toUtf8());
 
     if (!isReplyOk(reply, true))
         return true;
@@ -924,6 +1035,22 @@ bool IppClient::printerIsClass(const QString &name)
     return retval;
 }
 
+void IppClient::addSchemes(ipp_t *request, const char *name,
+                           const QStringList &schemes)
+{
+    QList<QByteArray> values;
+    QVector<const char*> pointers;
+    Q_FOREACH(const QString &scheme, schemes) {
+        values << scheme.toUtf8();
+    }
+    Q_FOREACH(const QByteArray &value, values) {
+        pointers << value.constData();
+    }
+
+    ippAddStrings(request, IPP_TAG_OPERATION, IPP_TAG_NAME, name,
+                  pointers.size(), NULL, pointers.constData());
+}
+
 void IppClient::addClassUri(ipp_t *request, const QString &name)
 {
     QUrl uri(QString("ipp://localhost/printers/%1").arg(name));
@@ -937,10 +1064,10 @@ ppd_file_t* IppClient::getPpdFile(const QString &name,
     Q_UNUSED(instance);
 
     ppd_file_t* file = 0;
-    const char *ppdFile = cupsGetPPD(name.toUtf8());
-    if (ppdFile) {
-        file = ppdOpenFile(ppdFile);
-        unlink(ppdFile);
+    QByteArray ppdFile = downloadPpd(name).toUtf8();
+    if (!ppdFile.isEmpty()) {
+        file = ppdOpenFile(ppdFile.constData());
+        unlink(ppdFile.constData());
     }
     if (file) {
         ppdMarkDefaults(file);
@@ -956,23 +1083,43 @@ cups_dest_t* IppClient::getDest(const QString &name,
 {
     cups_dest_t *dest = 0;
 
+    http_t *connection = checkoutConnection();
+    if (!connection) {
+        return dest;
+    }
+
     if (instance.isEmpty()) {
-        dest = cupsGetNamedDest(m_connection, name.toUtf8(), NULL);
+        dest = cupsGetNamedDest(connection, name.toUtf8(), NULL);
     } else {
-        dest = cupsGetNamedDest(m_connection, name.toUtf8(), instance.toUtf8());
+        dest = cupsGetNamedDest(connection, name.toUtf8(), instance.toUtf8());
     }
+
+    checkinConnection(connection, dest || httpError(connection) == 0);
     return dest;
 }
 
+int IppClient::getDests(cups_dest_t **dests) const
+{
+    int num = 0;
+    *dests = 0;
+
+    http_t *connection = checkoutConnection();
+    if (!connection) {
+        return num;
+    }
+
+    num = cupsGetDests2(connection, dests);
+
+    checkinConnection(connection, num > 0 || httpError(connection) == 0);
+    return num;
+}
+
 ipp_t* IppClient::createPrinterDriversRequest(
     const QString &deviceId, const QString &language, const QString &makeModel,
     const QString &product, const QStringList &includeSchemes,
     const QStringList &excludeSchemes
 )
 {
-    Q_UNUSED(includeSchemes);
-    Q_UNUSED(excludeSchemes);
-
     ipp_t *request;
 
     request = ippNewRequest(CUPS_GET_PPDS);
@@ -989,14 +1136,17 @@ ipp_t* IppClient::createPrinterDriversRequest(
     if (!product.isEmpty())
     ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_TEXT, "ppd-product",
                  NULL, product.toUtf8());
+    if (!includeSchemes.isEmpty())
+    addSchemes(request, "include-schemes", includeSchemes);
+    if (!excludeSchemes.isEmpty())
+    addSchemes(request, "exclude-schemes", excludeSchemes);
 
     // Do the request and get return the response.
     const QString resourceChar = getResource(CupsResourceRoot);
-    return cupsDoRequest(m_connection, request,
-                         resourceChar.toUtf8());
+    return doRequest(request, resourceChar.toUtf8());
 }
 
-int IppClient::createSubscription()
+int IppClient::createSubscription(const bool pull, const int leaseDuration)
 {
     ipp_t *req;
     ipp_t *resp;
@@ -1008,13 +1158,17 @@ int IppClient::createSubscription()
                  "printer-uri", NULL, "/");
     ippAddString(req, IPP_TAG_SUBSCRIPTION, IPP_TAG_KEYWORD,
                  "notify-events", NULL, "all");
-    ippAddString(req, IPP_TAG_SUBSCRIPTION, IPP_TAG_URI,
-                 "notify-recipient-uri", NULL, "dbus://");
+    if (pull) {
+        ippAddString(req, IPP_TAG_SUBSCRIPTION, IPP_TAG_KEYWORD,
+                     "notify-pull-method", NULL, "ippget");
+    } else {
+        ippAddString(req, IPP_TAG_SUBSCRIPTION, IPP_TAG_URI,
+                     "notify-recipient-uri", NULL, "dbus://");
+    }
     ippAddInteger(req, IPP_TAG_SUBSCRIPTION, IPP_TAG_INTEGER,
-                  "notify-lease-duration", 0);
+                  "notify-lease-duration", leaseDuration);
 
-    resp = cupsDoRequest(m_connection, req,
-                         getResource(CupsResourceRoot).toUtf8());
+    resp = doRequest(req, getResource(CupsResourceRoot).toUtf8());
     if (!isReplyOk(resp, true)) {
         return subscriptionId;
     }
@@ -1048,8 +1202,7 @@ void IppClient::cancelSubscription(const int &subscriptionId)
     ippAddInteger(req, IPP_TAG_OPERATION, IPP_TAG_INTEGER,
                   "notify-subscription-id", subscriptionId);
 
-    resp = cupsDoRequest(m_connection, req,
-                         getResource(CupsResourceRoot).toUtf8());
+    resp = doRequest(req, getResource(CupsResourceRoot).toUtf8());
     if (!isReplyOk(resp, true)) {
         return;
     }
@@ -1057,6 +1210,49 @@ void IppClient::cancelSubscription(const int &subscriptionId)
     ippDelete(resp);
 }
 
+bool IppClient::renewSubscription(const int subscriptionId,
+                                  const int leaseDuration)
+{
+    ipp_t *req;
+    ipp_t *resp;
+
+    if (subscriptionId <= 0) {
+        return false;
+    }
+
+    req = ippNewRequest(IPP_RENEW_SUBSCRIPTION);
+    ippAddString(req, IPP_TAG_OPERATION, IPP_TAG_URI,
+                 "printer-uri", NULL, "/");
+    ippAddInteger(req, IPP_TAG_OPERATION, IPP_TAG_INTEGER,
+                  "notify-subscription-id", subscriptionId);
+    ippAddInteger(req, IPP_TAG_SUBSCRIPTION, IPP_TAG_INTEGER,
+                  "notify-lease-duration", leaseDuration);
+
+    resp = doRequest(req, getResource(CupsResourceRoot).toUtf8());
+    if (!isReplyOk(resp, true)) {
+        return false;
+    }
+
+    ippDelete(resp);
+    return true;
+}
+
+ipp_t* IppClient::getNotifications(const int subscriptionId,
+                                   const int sequenceNumber, const bool wait)
+{
+    ipp_t *req = ippNewRequest(IPP_GET_NOTIFICATIONS);
+    ippAddString(req, IPP_TAG_OPERATION, IPP_TAG_URI,
+                 "printer-uri", NULL, "/");
+    addRequestingUsername(req, NULL);
+    ippAddInteger(req, IPP_TAG_OPERATION, IPP_TAG_INTEGER,
+                  "notify-subscription-ids", subscriptionId);
+    ippAddInteger(req, IPP_TAG_OPERATION, IPP_TAG_INTEGER,
+                  "notify-sequence-numbers", sequenceNumber);
+    ippAddBoolean(req, IPP_TAG_OPERATION, "notify-wait", wait ? 1 : 0);
+
+    return doRequest(req, getResource(CupsResourceRoot).toUtf8());
+}
+
 QVariant IppClient::getAttributeValue(ipp_attribute_t *attr, int index) const
 {
     QVariant var;
@@ -1133,10 +1329,153 @@ QVariant IppClient::getAttributeValue(ipp_attribute_t *attr, int index) const
     return var;
 }
 
-bool IppClient::getDevices(cups_device_cb_t callback, void *context) const
+bool IppClient::getDevices(cups_device_cb_t callback, void *context,
+                           const QStringList &includeSchemes,
+                           const QStringList &excludeSchemes,
+                           const int timeout) const
 {
-    auto reply = cupsGetDevices(m_connection, CUPS_TIMEOUT_DEFAULT,
-                                CUPS_INCLUDE_ALL, CUPS_EXCLUDE_NONE, callback,
-                                context);
+    http_t *connection = checkoutConnection();
+    if (!connection) {
+        return false;
+    }
+
+    QByteArray include = includeSchemes.join(",").toUtf8();
+    QByteArray exclude = excludeSchemes.join(",").toUtf8();
+    auto reply = cupsGetDevices(
+        connection, timeout,
+        includeSchemes.isEmpty() ? CUPS_INCLUDE_ALL : include.constData(),
+        excludeSchemes.isEmpty() ? CUPS_EXCLUDE_NONE : exclude.constData(),
+        callback, context);
+
+    checkinConnection(connection, httpError(connection) == 0);
     return reply == IPP_OK;
 }
+
+http_t* IppClient::openConnection() const
+{
+    return httpConnectEncrypt(cupsServer(), ippPort(), cupsEncryption());
+}
+
+/* Returns an idle connection, opening a new one if there are none and the
+pool is not full yet. Otherwise waits for a connection to be checked in,
+and gives up after CONNECTION_CHECKOUT_TIMEOUT milliseconds. */
+http_t* IppClient::checkoutConnection() const
+{
+    QMutexLocker locker(&m_poolLock);
+    m_poolStats.checkouts++;
+
+    if (m_idleConnections.isEmpty() && m_openConnections >= m_maxConnections) {
+        QElapsedTimer timer;
+        timer.start();
+        m_poolStats.waits++;
+
+        while (m_idleConnections.isEmpty() && m_openConnections >= m_maxConnections) {
+            qint64 remaining = CONNECTION_CHECKOUT_TIMEOUT - timer.elapsed();
+            if (remaining <= 0 ||
+                    !m_connectionReleased.wait(&m_poolLock, remaining)) {
+                break;
+            }
+        }
+
+        qint64 waited = timer.elapsed();
+        m_poolStats.totalWaitTime += waited;
+        m_poolStats.maxWaitTime = qMax(m_poolStats.maxWaitTime, waited);
+
+        if (m_idleConnections.isEmpty() && m_openConnections >= m_maxConnections) {
+            m_poolStats.timeouts++;
+            qWarning() << "Timed out after" << waited
+                       << "ms waiting for a connection to cupsd.";
+            return Q_NULLPTR;
+        }
+    }
+
+    if (!m_idleConnections.isEmpty()) {
+        http_t *connection = m_idleConnections.takeLast();
+        m_busyConnections << connection;
+
+        // Reconnect if cupsd closed the connection while it was idle. The
+        // connection is ours now, so the lock need not be held meanwhile.
+        if (httpGetFd(connection) < 0 || httpError(connection) != 0) {
+            m_poolStats.reconnects++;
+            locker.unlock();
+            bool reconnected = httpReconnect2(
+                connection, CONNECTION_RECONNECT_TIMEOUT, NULL) == 0;
+            if (!reconnected) {
+                qWarning() << "Failed to reconnect to cupsd:"
+                           << strerror(httpError(connection));
+                checkinConnection(connection, false);
+                return Q_NULLPTR;
+            }
+        }
+        return connection;
+    }
+
+    // There is room for another connection. Count it as open before
+    // connecting, so the lock need not be held while connecting.
+    m_openConnections++;
+    locker.unlock();
+
+    http_t *connection = openConnection();
+    locker.relock();
+    if (!connection) {
+        qWarning("Failed to open a new connection to cupsd.");
+        m_openConnections--;
+        m_connectionReleased.wakeOne();
+    } else {
+        m_busyConnections << connection;
+    }
+    return connection;
+}
+
+/* Downloads the PPD of the printer, over a connection from the pool, into a
+temporary file which the caller unlinks. Returns a null string on failure. */
+QString IppClient::downloadPpd(const QString &name) const
+{
+    http_t *connection = checkoutConnection();
+    if (!connection) {
+        return QString();
+    }
+
+    const char *file = cupsGetPPD2(connection, name.toUtf8());
+    QString fileName = file ? QString::fromUtf8(file) : QString();
+
+    checkinConnection(connection, file || httpError(connection) == 0);
+    return fileName;
+}
+
+/* Gives a connection back to the pool. Connections that failed at the
+transport level are closed instead, and reopened on demand. */
+void IppClient::checkinConnection(http_t *connection, const bool healthy) const
+{
+    QMutexLocker locker(&m_poolLock);
+    m_busyConnections.removeOne(connection);
+
+    if (healthy && !m_abortedConnections.removeOne(connection)) {
+        m_idleConnections << connection;
+    } else {
+        m_abortedConnections.removeOne(connection);
+        httpClose(connection);
+        m_openConnections--;
+    }
+    m_connectionReleased.wakeOne();
+}
+
+ipp_t* IppClient::doRequest(ipp_t *request, const QByteArray &resource) const
+{
+    return doFileRequest(request, resource, NULL);
+}
+
+ipp_t* IppClient::doFileRequest(ipp_t *request, const QByteArray &resource,
+                                const char *file) const
+{
+    http_t *connection = checkoutConnection();
+    if (!connection) {
+        ippDelete(request);
+        return Q_NULLPTR;
+    }
+
+    ipp_t *reply = cupsDoFileRequest(connection, request, resource, file);
+
+    checkinConnection(connection, reply || httpError(connection) == 0);
+    return reply;
+}
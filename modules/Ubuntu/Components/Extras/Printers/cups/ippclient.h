@@ -17,6 +17,7 @@
 #ifndef USC_PRINTERS_CUPS_IPPCLIENT_H
 #define USC_PRINTERS_CUPS_IPPCLIENT_H
 
+#include "printers_global.h"
 #include "structs.h"
 
 #include <cups/adminutil.h>
@@ -25,9 +26,11 @@
 #include <cups/ipp.h>
 #include <cups/ppd.h>
 
+#include <QList>
 #include <QMutex>
 #include <QString>
 #include <QStringList>
+#include <QWaitCondition>
 
 /* From https://bugzilla.novell.com/show_bug.cgi?id=447444#c5
  * We need to define a maximum length for strings to avoid cups
@@ -35,12 +38,31 @@
  */
 #define CPH_STR_MAXLEN 512
 
-class IppClient
+class PRINTERS_DECL_EXPORT IppClient
 {
 public:
-    explicit IppClient();
+    // Statistics about the connections to cupsd, wait times in milliseconds.
+    struct ConnectionPoolStats
+    {
+        int openConnections = 0;
+        int idleConnections = 0;
+        int checkouts = 0;
+        int waits = 0;
+        int timeouts = 0;
+        int reconnects = 0;
+        qint64 totalWaitTime = 0;
+        qint64 maxWaitTime = 0;
+    };
+
+    explicit IppClient(const int maxConnections = 4);
     ~IppClient();
 
+    ConnectionPoolStats connectionPoolStats() const;
+
+    /* Makes the requests in progress on other threads fail promptly, by
+    shutting down their connections. */
+    void abortRequests();
+
     bool printerDelete(const QString &printerName);
     bool printerAdd(const QString &printerName,
                     const QString &printerUri,
@@ -67,12 +89,22 @@ public:
     ppd_file_t* getPpdFile(const QString &name, const QString &instance) const;
     cups_dest_t* getDest(const QString &name, const QString &instance) const;
 
+    /* Fetch all destinations with a single request. The caller frees them
+    with cupsFreeDests. Returns the number of destinations. */
+    int getDests(cups_dest_t **dests) const;
+
     // Fetch more attributes, as normally just a small subset is fetched.
     QMap<QString, QVariant> printerGetAttributes(const QString &printerName,
         const QStringList &attributes);
     QMap<QString, QVariant> printerGetJobAttributes(const QString &printerName,
                                                     const int jobId);
 
+    /* Fetch the given attributes of many jobs, of any printer, with a single
+    Get-Jobs request. The result maps job ids to their attributes; jobs that
+    cupsd did not return are missing from it. */
+    QMap<int, QMap<QString, QVariant>> printerGetJobsAttributes(
+        const QList<int> &jobIds, const QStringList &attributes);
+
     QString getLastError() const;
 
     // Note: This response needs to be free by the caller.
@@ -81,9 +113,26 @@ public:
         const QString &makeModel, const QString &product,
         const QStringList &includeSchemes, const QStringList &excludeSchemes
     );
-    int createSubscription();
+    /* A pull subscription keeps the events in cupsd until they are fetched
+    with getNotifications, instead of sending them to the D-Bus notifier.
+    leaseDuration is in seconds, 0 means forever. */
+    int createSubscription(const bool pull = false,
+                           const int leaseDuration = 0);
+    bool renewSubscription(const int subscriptionId, const int leaseDuration);
     void cancelSubscription(const int &subscriptionId);
-    bool getDevices(cups_device_cb_t callback, void *context) const;
+    /* Fetches the events of a pull subscription from sequenceNumber on. With
+    wait, cupsd may hold the request until there are events.
+    Note: This response needs to be free by the caller, it is returned
+    whatever its status. */
+    ipp_t* getNotifications(const int subscriptionId,
+                            const int sequenceNumber, const bool wait);
+    /* Runs the CUPS backends whose names are in includeSchemes, or all of
+    them if it is empty, except those in excludeSchemes. timeout is in
+    seconds. */
+    bool getDevices(cups_device_cb_t callback, void *context,
+                    const QStringList &includeSchemes = QStringList(),
+                    const QStringList &excludeSchemes = QStringList(),
+                    const int timeout = CUPS_TIMEOUT_DEFAULT) const;
 
 private:
     enum CupsResource
@@ -103,11 +152,14 @@ private:
     static const QString getResource(const CupsResource &resource);
     static bool isPrinterNameValid(const QString &name);
     static void addClassUri(ipp_t *request, const QString &name);
+    static void addSchemes(ipp_t *request, const char *name,
+                           const QStringList &schemes);
     static bool isStringValid(const QString &string,
                               const bool checkNull = false,
                               const int maxLength = 512);
     static bool isStringPrintable(const QString &string, const bool checkNull,
                                   const int maxLength);
+    QString downloadPpd(const QString &name) const;
     QString preparePpdForOptions(const QString &ppdfile,
                                  cups_option_t *options,
                                  int numOptions);
@@ -123,10 +175,26 @@ private:
     void setErrorFromReply(ipp_t *reply);
     QVariant getAttributeValue(ipp_attribute_t *attr, int index=-1) const;
 
-    http_t *m_connection;
+    /* Every request checks out a connection from the pool for its duration,
+    so that requests from different threads run in parallel instead of
+    sharing a single connection. */
+    http_t* openConnection() const;
+    http_t* checkoutConnection() const;
+    void checkinConnection(http_t *connection, const bool healthy) const;
+    ipp_t* doRequest(ipp_t *request, const QByteArray &resource) const;
+    ipp_t* doFileRequest(ipp_t *request, const QByteArray &resource,
+                         const char *file) const;
+
+    const int m_maxConnections;
+    mutable QList<http_t*> m_idleConnections;
+    mutable QList<http_t*> m_busyConnections;
+    mutable QList<http_t*> m_abortedConnections;
+    mutable int m_openConnections = 0;
+    mutable ConnectionPoolStats m_poolStats;
+    mutable QMutex m_poolLock;
+    mutable QWaitCondition m_connectionReleased;
     ipp_status_t m_lastStatus = IPP_OK;
     mutable QString m_internalStatus = QString::null;
-    QMutex m_thread_lock;
 };
 
 
@@ -20,18 +20,17 @@
 
 #include "printers/printers.h"
 
+#include <QCoreApplication>
 #include <QDBusConnection>
 #include <QPrinterInfo>
 
 class PrinterCupsBackend;
 JobLoader::JobLoader(PrinterBackend *backend,
-                     QString printerName,
-                     int jobId,
+                     const QList<QPair<QString, int>> &jobs,
                      QObject *parent)
     : QObject(parent)
     , m_backend(backend)
-    , m_job_id(jobId)
-    , m_printer_name(printerName)
+    , m_jobs(jobs)
 {
 }
 
@@ -41,10 +40,30 @@ JobLoader::~JobLoader()
 
 void JobLoader::load()
 {
-    QMap<QString, QVariant> map = m_backend->printerGetJobAttributes(
-        m_printer_name, m_job_id
-    );
+    QList<JobAttributes> jobs = m_backend->printerGetJobsAttributes(m_jobs);
 
-    Q_EMIT loaded(m_printer_name, m_job_id, map);
+    Q_EMIT loaded(jobs);
+    Q_EMIT finished();
+}
+
+JobListLoader::JobListLoader(PrinterBackend *backend, QObject *parent)
+    : QObject(parent)
+    , m_backend(backend)
+{
+}
+
+JobListLoader::~JobListLoader()
+{
+}
+
+void JobListLoader::load()
+{
+    QList<QSharedPointer<PrinterJob>> jobs = m_backend->printerGetJobs();
+
+    Q_FOREACH(auto job, jobs) {
+        job->moveToThread(QCoreApplication::instance()->thread());
+    }
+
+    Q_EMIT loaded(jobs);
     Q_EMIT finished();
 }
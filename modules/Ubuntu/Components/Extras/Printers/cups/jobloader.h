@@ -22,17 +22,19 @@
 
 #include <QList>
 #include <QObject>
+#include <QPair>
 #include <QSharedPointer>
 
+/* Loads the extended attributes of a batch of jobs, given as pairs of
+printer name and job id, and emits them all at once. */
 class JobLoader : public QObject
 {
     Q_OBJECT
     PrinterBackend *m_backend;
-    int m_job_id;
-    QString m_printer_name;
+    QList<QPair<QString, int>> m_jobs;
 public:
     explicit JobLoader(PrinterBackend *backend,
-                       QString printerName, int jobId,
+                       const QList<QPair<QString, int>> &jobs,
                        QObject *parent = Q_NULLPTR);
     ~JobLoader();
 
@@ -41,7 +43,25 @@ public Q_SLOTS:
 
 Q_SIGNALS:
     void finished();
-    void loaded(QString, int, QMap<QString, QVariant>);
+    void loaded(const QList<JobAttributes> &jobs);
+};
+
+/* Loads the jobs of all printers, without their extended attributes. */
+class JobListLoader : public QObject
+{
+    Q_OBJECT
+    PrinterBackend *m_backend;
+public:
+    explicit JobListLoader(PrinterBackend *backend,
+                           QObject *parent = Q_NULLPTR);
+    ~JobListLoader();
+
+public Q_SLOTS:
+    void load();
+
+Q_SIGNALS:
+    void finished();
+    void loaded(const QList<QSharedPointer<PrinterJob>> &jobs);
 };
 
 #endif // USC_PRINTERS_CUPS_JOBLOADER_H
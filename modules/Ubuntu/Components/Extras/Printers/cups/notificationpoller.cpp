@@ -0,0 +1,287 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cups/notificationpoller.h"
+
+#include <QDebug>
+#include <QStringList>
+
+// Default lease of the subscription, in seconds.
+#define NOTIFY_LEASE_DURATION 3600
+
+// Bounds of the time between polls, in milliseconds.
+#define NOTIFY_MIN_INTERVAL 500
+#define NOTIFY_MAX_INTERVAL 30000
+
+NotificationPoller::NotificationPoller(QObject *parent)
+    : QObject(parent)
+    , m_client(1)
+    , m_timer(this)
+    , m_interval(NOTIFY_MIN_INTERVAL)
+    , m_leaseDuration(NOTIFY_LEASE_DURATION)
+{
+    m_timer.setSingleShot(true);
+    connect(&m_timer, SIGNAL(timeout()), this, SLOT(poll()));
+}
+
+NotificationPoller::~NotificationPoller()
+{
+    m_client.cancelSubscription(m_subscriptionId);
+}
+
+void NotificationPoller::abort()
+{
+    m_aborted.storeRelease(1);
+    m_client.abortRequests();
+}
+
+void NotificationPoller::setLeaseDuration(const int leaseDuration)
+{
+    m_leaseDuration = leaseDuration;
+}
+
+void NotificationPoller::start()
+{
+    m_interval = NOTIFY_MIN_INTERVAL;
+    poll();
+}
+
+void NotificationPoller::poll()
+{
+    if (m_aborted.loadAcquire()) {
+        return;
+    }
+
+    if (m_subscriptionId <= 0 && !subscribe()) {
+        qWarning() << Q_FUNC_INFO << "unable to subscribe to cupsd events.";
+        schedule(NOTIFY_MAX_INTERVAL);
+        return;
+    }
+
+    if (m_leaseTimer.elapsed() > m_leaseDuration * 500
+            && m_client.renewSubscription(m_subscriptionId,
+                                          m_leaseDuration)) {
+        m_leaseTimer.restart();
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    ipp_t *response = m_client.getNotifications(m_subscriptionId,
+                                                m_sequenceNumber, true);
+    if (m_aborted.loadAcquire()) {
+        if (response) {
+            ippDelete(response);
+        }
+        return;
+    }
+
+    if (!response) {
+        qWarning() << Q_FUNC_INFO << "unable to get cupsd events.";
+        m_interval = nextInterval(m_interval, false, 0);
+        schedule(m_interval);
+        return;
+    }
+
+    if (ippGetStatusCode(response) == IPP_NOT_FOUND) {
+        // The subscription is gone, e.g. because cupsd restarted.
+        ippDelete(response);
+        m_subscriptionId = -1;
+        schedule(0);
+        return;
+    }
+
+    QList<CupsEvent> events;
+    int suggested = 0;
+    if (ippGetStatusCode(response) <= IPP_OK_CONFLICT) {
+        m_sequenceNumber = parseNotifications(response, m_sequenceNumber,
+                                              events, suggested);
+    } else {
+        qWarning() << Q_FUNC_INFO << "unable to get cupsd events:"
+                   << ippErrorString(ippGetStatusCode(response));
+    }
+    ippDelete(response);
+
+    if (!events.isEmpty()) {
+        Q_EMIT eventsReceived(events);
+    }
+
+    // A poll that cupsd held for a while counts as waiting already.
+    m_interval = nextInterval(m_interval, !events.isEmpty(), suggested);
+    schedule(qMax(0, m_interval - (int) timer.elapsed()));
+}
+
+bool NotificationPoller::subscribe()
+{
+    m_subscriptionId = m_client.createSubscription(true, m_leaseDuration);
+    m_sequenceNumber = 1;
+    m_leaseTimer.start();
+    return m_subscriptionId > 0;
+}
+
+void NotificationPoller::schedule(const int interval)
+{
+    if (!m_aborted.loadAcquire()) {
+        m_timer.start(interval);
+    }
+}
+
+int NotificationPoller::nextInterval(const int interval, const bool received,
+                                     const int suggested)
+{
+    if (received) {
+        return NOTIFY_MIN_INTERVAL;
+    }
+
+    int maximum = NOTIFY_MAX_INTERVAL;
+    if (suggested > 0) {
+        maximum = qBound(NOTIFY_MIN_INTERVAL, suggested * 1000,
+                         NOTIFY_MAX_INTERVAL);
+    }
+    return qBound(NOTIFY_MIN_INTERVAL, interval * 2, maximum);
+}
+
+/* Maps the events of cupsd to the signals of its D-Bus notifier. Returns
+false for events that have none. */
+static bool eventType(const QByteArray &name, CupsEvent::Type &type)
+{
+    if (name == "printer-added") {
+        type = CupsEvent::Type::PrinterAdded;
+    } else if (name == "printer-deleted") {
+        type = CupsEvent::Type::PrinterDeleted;
+    } else if (name == "printer-modified"
+               || name == "printer-config-changed") {
+        type = CupsEvent::Type::PrinterModified;
+    } else if (name == "printer-state-changed"
+               || name == "printer-stopped") {
+        type = CupsEvent::Type::PrinterStateChanged;
+    } else if (name == "job-created") {
+        type = CupsEvent::Type::JobCreated;
+    } else if (name == "job-completed") {
+        type = CupsEvent::Type::JobCompleted;
+    } else if (name == "job-state-changed" || name == "job-stopped"
+               || name == "job-progress" || name == "job-config-changed") {
+        type = CupsEvent::Type::JobState;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static QString joinStrings(ipp_attribute_t *attr)
+{
+    QStringList values;
+    for (int i = 0; i < ippGetCount(attr); i++) {
+        values << QString::fromUtf8(ippGetString(attr, i, NULL));
+    }
+    return values.join(",");
+}
+
+int NotificationPoller::parseNotifications(ipp_t *response,
+                                           const int sequenceNumber,
+                                           QList<CupsEvent> &events,
+                                           int &interval)
+{
+    int next = sequenceNumber;
+    interval = 0;
+
+    CupsEvent event;
+    int eventNumber = 0;
+    bool known = false;
+    bool started = false;
+    ipp_tag_t group = IPP_TAG_ZERO;
+
+    /* Every event is an event notification group. Groups are separated by
+    attributes without a name or by a change of group, and each starts with
+    the subscription id. */
+    for (ipp_attribute_t *attr = ippFirstAttribute(response); ;
+            attr = ippNextAttribute(response)) {
+        bool end = !attr || !ippGetName(attr)
+                || ippGetGroupTag(attr) != group
+                || QByteArray(ippGetName(attr)) == "notify-subscription-id";
+
+        if (end && started) {
+            // Events not numbered or already received are skipped.
+            if (eventNumber >= next) {
+                if (eventNumber > next) {
+                    qWarning() << Q_FUNC_INFO << "missed"
+                               << eventNumber - next << "cupsd events.";
+                }
+                if (known) {
+                    events << event;
+                }
+                next = eventNumber + 1;
+            }
+
+            event = CupsEvent();
+            eventNumber = 0;
+            known = false;
+            started = false;
+        }
+
+        if (!attr) {
+            break;
+        }
+
+        group = ippGetGroupTag(attr);
+        if (!ippGetName(attr)) {
+            continue;
+        }
+
+        QByteArray name(ippGetName(attr));
+        if (group == IPP_TAG_OPERATION) {
+            if (name == "notify-get-interval") {
+                interval = ippGetInteger(attr, 0);
+            }
+            continue;
+        }
+
+        if (group != IPP_TAG_EVENT_NOTIFICATION) {
+            continue;
+        }
+
+        started = true;
+        if (name == "notify-sequence-number") {
+            eventNumber = ippGetInteger(attr, 0);
+        } else if (name == "notify-subscribed-event") {
+            known = eventType(ippGetString(attr, 0, NULL), event.type);
+        } else if (name == "notify-text") {
+            event.text = QString::fromUtf8(ippGetString(attr, 0, NULL));
+        } else if (name == "notify-printer-uri") {
+            event.printerUri = QString::fromUtf8(ippGetString(attr, 0, NULL));
+        } else if (name == "printer-name") {
+            event.printerName = QString::fromUtf8(ippGetString(attr, 0, NULL));
+        } else if (name == "printer-state") {
+            event.printerState = ippGetInteger(attr, 0);
+        } else if (name == "printer-state-reasons") {
+            event.printerStateReasons = joinStrings(attr);
+        } else if (name == "printer-is-accepting-jobs") {
+            event.acceptingJobs = ippGetBoolean(attr, 0);
+        } else if (name == "notify-job-id") {
+            event.jobId = ippGetInteger(attr, 0);
+        } else if (name == "job-state") {
+            event.jobState = ippGetInteger(attr, 0);
+        } else if (name == "job-state-reasons") {
+            event.jobStateReasons = joinStrings(attr);
+        } else if (name == "job-name") {
+            event.jobName = QString::fromUtf8(ippGetString(attr, 0, NULL));
+        } else if (name == "job-impressions-completed") {
+            event.jobImpressionsCompleted = ippGetInteger(attr, 0);
+        }
+    }
+
+    return next;
+}
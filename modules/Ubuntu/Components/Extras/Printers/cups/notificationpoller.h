@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USC_PRINTERS_CUPS_NOTIFICATIONPOLLER_H
+#define USC_PRINTERS_CUPS_NOTIFICATIONPOLLER_H
+
+#include "cups/cupsnotifier.h"
+#include "cups/ippclient.h"
+#include "printers_global.h"
+
+#include <cups/ipp.h>
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QTimer>
+
+/* Pulls the events of cupsd with Get-Notifications, for when there is no
+system bus and so no D-Bus notifier.
+
+The poller holds a pull subscription, renewed before its lease runs out and
+made again if cupsd forgets it. Every poll asks for the events after the
+last one received, waiting for new ones if cupsd supports it. Polls follow
+each other quickly while there are events, and back off up to the interval
+suggested by cupsd while there are none. Its requests block, so it is meant
+for a thread of its own. */
+class PRINTERS_DECL_EXPORT NotificationPoller : public QObject
+{
+    Q_OBJECT
+public:
+    explicit NotificationPoller(QObject *parent = Q_NULLPTR);
+    ~NotificationPoller();
+
+    // Thread safe. Makes the poll in progress fail, and stops polling.
+    void abort();
+
+    /* The lease of the subscription in seconds, renewed halfway through.
+    Used from the next subscription or renewal on. */
+    void setLeaseDuration(const int leaseDuration);
+
+    /* Appends the events of a Get-Notifications response numbered from
+    sequenceNumber on to events, and returns the sequence number of the
+    next event. interval is set to the interval suggested by cupsd in
+    seconds, or 0. */
+    static int parseNotifications(ipp_t *response, const int sequenceNumber,
+                                  QList<CupsEvent> &events, int &interval);
+
+    /* The time to wait before the next poll in milliseconds, given the last
+    one, whether events were received, and the interval suggested by cupsd
+    in seconds. */
+    static int nextInterval(const int interval, const bool received,
+                            const int suggested);
+
+public Q_SLOTS:
+    void start();
+    void poll();
+
+Q_SIGNALS:
+    void eventsReceived(const QList<CupsEvent> &events);
+
+private:
+    bool subscribe();
+    void schedule(const int interval);
+
+    IppClient m_client;
+    QTimer m_timer;
+    QAtomicInt m_aborted;
+    int m_subscriptionId = -1;
+    int m_sequenceNumber = 1;
+    int m_interval;
+    int m_leaseDuration;
+    QElapsedTimer m_leaseTimer;
+};
+
+#endif // USC_PRINTERS_CUPS_NOTIFICATIONPOLLER_H
@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "cups/destinationsnapshot.h"
+#include "cups/printercache.h"
+
+#include <QCoreApplication>
+#include <QMutexLocker>
+#include <QPointer>
+#include <QStringList>
+
+/* How long entries are used without asking cupsd whether their printer
+changed, in milliseconds. PrinterModified notifications cut it short. */
+#define PRINTER_CACHE_TTL 60000
+
+static void closePpd(ppd_file_t *ppd)
+{
+    ppdClose(ppd);
+}
+
+static void freeDest(cups_dest_t *dest)
+{
+    cupsFreeDests(1, dest);
+}
+
+PrinterCache::PrinterCache(QObject *parent)
+    : QObject(parent)
+{
+}
+
+PrinterCache::~PrinterCache()
+{
+}
+
+PrinterCache* PrinterCache::instance()
+{
+    static QPointer<PrinterCache> cache;
+
+    if (!cache) {
+        cache = new PrinterCache(QCoreApplication::instance());
+    }
+    return cache;
+}
+
+QSharedPointer<ppd_file_t> PrinterCache::ppd(IppClient *client,
+                                             const QString &name,
+                                             const QString &instance)
+{
+    QString key = instance.isEmpty() ? name : name + "/" + instance;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        Entry *entry = recentEntry(key);
+        if (entry && entry->hasPpd) {
+            return entry->ppd;
+        }
+    }
+
+    qint64 changeTime = configChangeTime(client, name);
+    {
+        QMutexLocker locker(&m_mutex);
+        Entry *entry = validEntry(key, changeTime);
+        if (entry && entry->hasPpd) {
+            return entry->ppd;
+        }
+    }
+
+    // Downloading and parsing is done without holding the lock.
+    QSharedPointer<ppd_file_t> ppd;
+    ppd_file_t *file = client->getPpdFile(name, instance);
+    if (file) {
+        ppd = QSharedPointer<ppd_file_t>(file, closePpd);
+    }
+
+    QMutexLocker locker(&m_mutex);
+    Entry *entry = validEntry(key, changeTime);
+    if (!entry) {
+        entry = insertEntry(key, changeTime);
+    }
+    entry->hasPpd = true;
+    entry->ppd = ppd;
+    return ppd;
+}
+
+QSharedPointer<cups_dest_t> PrinterCache::dest(IppClient *client,
+                                               const QString &name,
+                                               const QString &instance)
+{
+    QString key = instance.isEmpty() ? name : name + "/" + instance;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        Entry *entry = recentEntry(key);
+        if (entry && entry->hasDest) {
+            return entry->dest;
+        }
+    }
+
+    qint64 changeTime = configChangeTime(client, name);
+    {
+        QMutexLocker locker(&m_mutex);
+        Entry *entry = validEntry(key, changeTime);
+        if (entry && entry->hasDest) {
+            return entry->dest;
+        }
+    }
+
+    cups_dest_t *d = DestinationSnapshot::instance()->copyDest(name, instance);
+
+    // The snapshot may predate the destination.
+    if (!d) {
+        d = client->getDest(name, instance);
+    }
+
+    QSharedPointer<cups_dest_t> dest;
+    if (d) {
+        dest = QSharedPointer<cups_dest_t>(d, freeDest);
+    }
+
+    QMutexLocker locker(&m_mutex);
+    Entry *entry = validEntry(key, changeTime);
+    if (!entry) {
+        entry = insertEntry(key, changeTime);
+    }
+    entry->hasDest = true;
+    entry->dest = dest;
+    return dest;
+}
+
+QMutex* PrinterCache::ppdLock()
+{
+    return &m_ppdMutex;
+}
+
+void PrinterCache::printerModified(const QString &text,
+                                   const QString &printerUri,
+                                   const QString &printerName,
+                                   uint printerState,
+                                   const QString &printerStateReason,
+                                   bool acceptingJobs)
+{
+    Q_UNUSED(text);
+    Q_UNUSED(printerUri);
+    Q_UNUSED(printerState);
+    Q_UNUSED(printerStateReason);
+    Q_UNUSED(acceptingJobs);
+
+    // Checked against the change time again on their next use.
+    QMutexLocker locker(&m_mutex);
+    QMutableMapIterator<QString, Entry> it(m_entries);
+    while (it.hasNext()) {
+        it.next();
+        if (it.key() == printerName
+                || it.key().startsWith(printerName + "/")) {
+            it.value().validated.invalidate();
+        }
+    }
+}
+
+void PrinterCache::printerDeleted(const QString &text,
+                                  const QString &printerUri,
+                                  const QString &printerName,
+                                  uint printerState,
+                                  const QString &printerStateReason,
+                                  bool acceptingJobs)
+{
+    Q_UNUSED(text);
+    Q_UNUSED(printerUri);
+    Q_UNUSED(printerState);
+    Q_UNUSED(printerStateReason);
+    Q_UNUSED(acceptingJobs);
+
+    QMutexLocker locker(&m_mutex);
+    QMutableMapIterator<QString, Entry> it(m_entries);
+    while (it.hasNext()) {
+        it.next();
+        if (it.key() == printerName
+                || it.key().startsWith(printerName + "/")) {
+            it.remove();
+        }
+    }
+}
+
+qint64 PrinterCache::configChangeTime(IppClient *client,
+                                      const QString &name) const
+{
+    auto attributes = client->printerGetAttributes(
+        name, QStringList({QStringLiteral("printer-config-change-time")}));
+
+    bool ok = false;
+    qint64 changeTime = attributes.value(
+        QStringLiteral("printer-config-change-time")).toLongLong(&ok);
+    return ok ? changeTime : -1;
+}
+
+/* Returns the entry of the printer if its change time was checked less
+than PRINTER_CACHE_TTL ago, and nothing has modified the printer since. */
+PrinterCache::Entry* PrinterCache::recentEntry(const QString &key)
+{
+    auto it = m_entries.find(key);
+    if (it == m_entries.end() || !it.value().validated.isValid()
+            || it.value().validated.elapsed() >= PRINTER_CACHE_TTL) {
+        return Q_NULLPTR;
+    }
+    return &it.value();
+}
+
+/* Returns the entry of the printer if it is still current, and drops it
+otherwise. Without a change time nothing is reused. */
+PrinterCache::Entry* PrinterCache::validEntry(const QString &key,
+                                              const qint64 changeTime)
+{
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        return Q_NULLPTR;
+    }
+
+    if (changeTime < 0 || it.value().changeTime != changeTime) {
+        m_entries.erase(it);
+        return Q_NULLPTR;
+    }
+    it.value().validated.start();
+    return &it.value();
+}
+
+PrinterCache::Entry* PrinterCache::insertEntry(const QString &key,
+                                               const qint64 changeTime)
+{
+    Entry fresh;
+    fresh.changeTime = changeTime;
+    fresh.validated.start();
+    return &m_entries.insert(key, fresh).value();
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef USC_PRINTERS_CUPS_PRINTERCACHE_H
+#define USC_PRINTERS_CUPS_PRINTERCACHE_H
+
+#include "cups/ippclient.h"
+
+#include <cups/cups.h>
+#include <cups/ppd.h>
+
+#include <QElapsedTimer>
+#include <QMap>
+#include <QMutex>
+#include <QObject>
+#include <QSharedPointer>
+#include <QString>
+
+/* Parsed PPDs and destinations, shared by all the backends.
+
+A backend is created every time a printer is loaded, so without this the
+PPD of a printer is downloaded and parsed again on every change to it.
+Cached entries are reused for as long as the printer-config-change-time of
+their printer stays the same. That is checked at most once a minute per
+printer, and again after cupsd reports the printer modified. Entries are
+reference counted, so a backend keeps using the PPD it got even after the
+cache has replaced it. PPDs and destinations handed out must be treated as
+read-only. May be used from any thread. */
+class PrinterCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PrinterCache(QObject *parent = Q_NULLPTR);
+    ~PrinterCache();
+
+    // The cache shared by all the backends.
+    static PrinterCache* instance();
+
+    // Null pointers are returned if the printer has no PPD or destination.
+    QSharedPointer<ppd_file_t> ppd(IppClient *client, const QString &name,
+                                   const QString &instance);
+    QSharedPointer<cups_dest_t> dest(IppClient *client, const QString &name,
+                                     const QString &instance);
+
+    /* The printer-config-change-time of the printer, which changes whenever
+    its PPD or options do, or -1 if it could not be fetched. */
+    qint64 configChangeTime(IppClient *client, const QString &name) const;
+
+    /* Even lookups in a PPD move the cursors of its arrays, so a PPD from
+    the cache is only read while holding this lock. */
+    QMutex* ppdLock();
+
+public Q_SLOTS:
+    void printerModified(const QString &text, const QString &printerUri,
+                         const QString &printerName, uint printerState,
+                         const QString &printerStateReason,
+                         bool acceptingJobs);
+    void printerDeleted(const QString &text, const QString &printerUri,
+                        const QString &printerName, uint printerState,
+                        const QString &printerStateReason,
+                        bool acceptingJobs);
+
+private:
+    struct Entry
+    {
+        qint64 changeTime = -1;
+        QElapsedTimer validated; // Since the change time was last checked.
+        bool hasPpd = false;
+        QSharedPointer<ppd_file_t> ppd;
+        bool hasDest = false;
+        QSharedPointer<cups_dest_t> dest;
+    };
+
+    Entry* recentEntry(const QString &key);
+    Entry* validEntry(const QString &key, const qint64 changeTime);
+    Entry* insertEntry(const QString &key, const qint64 changeTime);
+
+    QMutex m_mutex;
+    QMutex m_ppdMutex;
+    QMap<QString, Entry> m_entries; // Printer name (with instance), entry.
+};
+
+#endif // USC_PRINTERS_CUPS_PRINTERCACHE_H
@@ -14,8 +14,16 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "cups/drivercatalogue.h"
 #include "printerdriverloader.h"
 
+// The scheme of the drivers cupsd compiles from .drv files, of which there
+// are few, so that they are asked for before the others.
+#define DRIVER_FIRST_SCHEME "drv"
+
+// How many parsed drivers are emitted at a time.
+#define DRIVER_CHUNK_SIZE 1000
+
 PrinterDriverLoader::PrinterDriverLoader(
         const QString &deviceId, const QString &language,
         const QString &makeModel, const QString &product,
@@ -35,13 +43,76 @@ PrinterDriverLoader::~PrinterDriverLoader()
 
 void PrinterDriverLoader::process()
 {
-    m_running = true;
+    /* The full list of drivers is taken from the catalogue while the PPD
+    sources are unchanged, otherwise it is fetched and the catalogue is
+    rewritten. */
+    bool unfiltered = m_deviceId.isEmpty() && m_language.isEmpty()
+        && m_makeModel.isEmpty() && m_product.isEmpty()
+        && m_includeSchemes.isEmpty() && m_excludeSchemes.isEmpty();
+    QString server = QString::fromUtf8(cupsServer());
+    qint64 sourceStamp = unfiltered
+        ? DriverCatalogue::ppdSourceStamp(server) : -1;
+
+    /* The drivers point into the mapped catalogue rather than being copied
+    out of it, and are shared with earlier loads while it is unchanged. */
+    QList<PrinterDriver> drivers;
+    if (unfiltered && DriverCatalogue::load(DriverCatalogue::defaultPath(server),
+                                            sourceStamp, drivers)) {
+        Q_EMIT loaded(drivers);
+        Q_EMIT finished();
+        return;
+    }
+
+    /* CUPS-Get-PPDs cannot be paged, and cupsd takes a while to list all
+    its PPDs, so the drivers of one small scheme are asked for on their own
+    to show something early. The second request excludes that scheme, so
+    that no driver is listed twice. */
+    QSet<QByteArray> names;
+    const QString first = QStringLiteral(DRIVER_FIRST_SCHEME);
+    bool ok;
+    if (m_includeSchemes.isEmpty() && !m_excludeSchemes.contains(first)) {
+        ok = fetch(QStringList({first}), m_excludeSchemes, drivers, names)
+            && fetch(QStringList(), m_excludeSchemes + QStringList({first}),
+                     drivers, names);
+    } else {
+        ok = fetch(m_includeSchemes, m_excludeSchemes, drivers, names);
+    }
 
+    // A cancelled load is incomplete, and nobody waits for it.
+    if (m_cancelled.load()) {
+        Q_EMIT finished();
+        return;
+    }
+
+    if (ok) {
+        if (unfiltered && sourceStamp >= 0) {
+            DriverCatalogue::write(DriverCatalogue::defaultPath(server),
+                                   sourceStamp, drivers);
+        }
+        Q_EMIT loaded(drivers);
+    }
+    Q_EMIT finished();
+}
+
+/* Sends a CUPS-Get-PPDs request for the drivers of the given schemes and
+appends those of its response that are not in names yet, emitting them in
+chunks. Emits error() and returns false if the request fails. */
+bool PrinterDriverLoader::fetch(const QStringList &includeSchemes,
+                                const QStringList &excludeSchemes,
+                                QList<PrinterDriver> &drivers,
+                                QSet<QByteArray> &names)
+{
     ipp_t* response = client.createPrinterDriversRequest(
-        m_deviceId, m_language, m_makeModel, m_product, m_includeSchemes,
-        m_excludeSchemes
+        m_deviceId, m_language, m_makeModel, m_product, includeSchemes,
+        excludeSchemes
     );
 
+    if (m_cancelled.load()) {
+        if (response)
+            ippDelete(response);
+        return false;
+    }
+
     // Note: if the response somehow fails, we return.
     if (!response || ippGetStatusCode(response) > IPP_OK_CONFLICT) {
         QString err(cupsLastErrorString());
@@ -51,8 +122,7 @@ void PrinterDriverLoader::process()
             ippDelete(response);
 
         Q_EMIT error(err);
-        Q_EMIT finished();
-        return;
+        return false;
     }
 
     ipp_attribute_t *attr;
@@ -61,9 +131,9 @@ void PrinterDriverLoader::process()
     QByteArray ppdMakeModel;
     QByteArray ppdName;
 
-    QList<PrinterDriver> drivers;
+    int chunkStart = drivers.size();
 
-    for (attr = ippFirstAttribute(response); attr != NULL && m_running; attr = ippNextAttribute(response)) {
+    for (attr = ippFirstAttribute(response); attr != NULL && !m_cancelled.load(); attr = ippNextAttribute(response)) {
 
         while (attr != NULL && ippGetGroupTag(attr) != IPP_TAG_PRINTER)
             attr = ippNextAttribute(response);
@@ -99,7 +169,7 @@ void PrinterDriverLoader::process()
 
         // See if we have everything needed...
         if (ppdLanguage.isEmpty() || ppdMakeModel.isEmpty() ||
-            ppdName.isEmpty()) {
+            ppdName.isEmpty() || names.contains(ppdName)) {
             if (attr == NULL)
                 break;
             else
@@ -112,16 +182,25 @@ void PrinterDriverLoader::process()
         m.makeModel = ppdMakeModel;
         m.language = ppdLanguage;
 
+        names << ppdName;
         drivers.append(m);
+
+        if (drivers.size() - chunkStart >= DRIVER_CHUNK_SIZE) {
+            Q_EMIT chunkLoaded(drivers.mid(chunkStart));
+            chunkStart = drivers.size();
+        }
     }
 
     ippDelete(response);
 
-    Q_EMIT loaded(drivers);
-    Q_EMIT finished();
+    if (drivers.size() > chunkStart && !m_cancelled.load()) {
+        Q_EMIT chunkLoaded(drivers.mid(chunkStart));
+    }
+    return !m_cancelled.load();
 }
 
 void PrinterDriverLoader::cancel()
 {
-    m_running = false;
+    m_cancelled.store(1);
+    client.abortRequests();
 }
@@ -20,10 +20,15 @@
 #include "ippclient.h"
 #include "structs.h"
 
+#include <QAtomicInt>
 #include <QObject>
+#include <QSet>
 #include <QString>
 #include <QStringList>
 
+/* Loads the drivers known to CUPS. Drivers are emitted in chunks with
+chunkLoaded() as they are parsed, and all of them with loaded() at the end.
+cancel() may be called from any thread, and aborts the request in progress. */
 class PrinterDriverLoader : public QObject
 {
     Q_OBJECT
@@ -43,10 +48,15 @@ public Q_SLOTS:
 
 Q_SIGNALS:
     void finished();
+    void chunkLoaded(const QList<PrinterDriver> &drivers);
     void loaded(const QList<PrinterDriver> &drivers);
     void error(const QString &error);
 
 private:
+    bool fetch(const QStringList &includeSchemes,
+               const QStringList &excludeSchemes,
+               QList<PrinterDriver> &drivers, QSet<QByteArray> &names);
+
     QString m_deviceId = QString::null;
     QString m_language = QString::null;
     QString m_makeModel = QString::null;
@@ -54,7 +64,7 @@ private:
     QStringList m_includeSchemes;
     QStringList m_excludeSchemes;
 
-    bool m_running = false;
+    QAtomicInt m_cancelled;
     IppClient client;
 };
 
@@ -19,12 +19,11 @@
 #include "printerloader.h"
 
 #include <QApplication>
-#include <QPrinterInfo>
 
 class PrinterCupsBackend;
 PrinterLoader::PrinterLoader(const QString &printerName,
                              IppClient *client,
-                             OrgCupsCupsdNotifierInterface* notifier,
+                             CupsNotifier* notifier,
                              QObject *parent)
     : QObject(parent)
     , m_printerName(printerName)
@@ -39,18 +38,126 @@ PrinterLoader::~PrinterLoader()
 
 void PrinterLoader::load()
 {
-    QPrinterInfo info = QPrinterInfo::printerInfo(m_printerName);
-    auto backend = new PrinterCupsBackend(m_client, info, m_notifier);
-
-    // Dest or PPD was null, but we know it's name so we will use it.
-    if (info.printerName().isEmpty()) {
-        backend->setPrinterNameInternal(m_printerName);
-    }
-
+    auto backend = new PrinterCupsBackend(m_client, m_printerName, m_notifier);
     auto p = QSharedPointer<Printer>(new Printer(backend));
 
+    /* The backend goes with the printer, as the attributes it loads on
+    demand are delivered to it. */
     p->moveToThread(QApplication::instance()->thread());
+    backend->moveToThread(QApplication::instance()->thread());
 
     Q_EMIT loaded(p);
     Q_EMIT finished();
 }
+
+PrinterStateLoader::PrinterStateLoader(const QString &printerName,
+                                       IppClient *client,
+                                       QObject *parent)
+    : QObject(parent)
+    , m_printerName(printerName)
+    , m_client(client)
+{
+}
+
+PrinterStateLoader::~PrinterStateLoader()
+{
+}
+
+void PrinterStateLoader::load()
+{
+    auto attributes = m_client->printerGetAttributes(m_printerName, QStringList({
+        QStringLiteral("printer-state"),
+        QStringLiteral("printer-state-reasons"),
+        QStringLiteral("printer-state-message"),
+        QStringLiteral("printer-is-accepting-jobs"),
+        QStringLiteral("printer-state-change-time"),
+        QStringLiteral("printer-config-change-time"),
+    }));
+
+    Q_EMIT loaded(fromAttributes(m_printerName, attributes));
+    Q_EMIT finished();
+}
+
+PrinterStateAttributes PrinterStateLoader::fromAttributes(
+        const QString &printerName, const QMap<QString, QVariant> &attributes)
+{
+    PrinterStateAttributes state;
+    state.printerName = printerName;
+
+    // The same mapping as QPrinterInfo::state().
+    switch (attributes.value(QStringLiteral("printer-state")).toInt()) {
+    case IPP_PSTATE_IDLE:
+        state.state = PrinterEnum::State::IdleState;
+        break;
+    case IPP_PSTATE_PROCESSING:
+        state.state = PrinterEnum::State::ActiveState;
+        break;
+    default:
+        state.state = PrinterEnum::State::ErrorState;
+        break;
+    }
+
+    // Several reasons come as a list, a single one as a string.
+    QVariant reasons = attributes.value(QStringLiteral("printer-state-reasons"));
+    if (reasons.type() == QVariant::List) {
+        Q_FOREACH(const QVariant &reason, reasons.toList()) {
+            state.stateReasons << reason.toString();
+        }
+    } else if (!reasons.toString().isEmpty()) {
+        state.stateReasons << reasons.toString();
+    }
+
+    state.stateMessage = attributes.value(
+        QStringLiteral("printer-state-message")).toString();
+    state.acceptJobs = attributes.value(
+        QStringLiteral("printer-is-accepting-jobs")).toBool();
+
+    bool ok;
+    auto stateTime = QStringLiteral("printer-state-change-time");
+    if (attributes.contains(stateTime)) {
+        state.stateChangeTime = attributes.value(stateTime).toLongLong(&ok);
+        if (!ok) {
+            state.stateChangeTime = -1;
+        }
+    }
+    auto configTime = QStringLiteral("printer-config-change-time");
+    if (attributes.contains(configTime)) {
+        state.configChangeTime = attributes.value(configTime).toLongLong(&ok);
+        if (!ok) {
+            state.configChangeTime = -1;
+        }
+    }
+    return state;
+}
+
+PrinterOptionsLoader::PrinterOptionsLoader(const QString &printerName,
+                                           const QStringList &options,
+                                           IppClient *client,
+                                           CupsNotifier* notifier,
+                                           QObject *parent)
+    : QObject(parent)
+    , m_printerName(printerName)
+    , m_options(options)
+    , m_client(client)
+    , m_notifier(notifier)
+{
+}
+
+PrinterOptionsLoader::~PrinterOptionsLoader()
+{
+}
+
+void PrinterOptionsLoader::load()
+{
+    PrinterCupsBackend backend(m_client, m_printerName, m_notifier);
+    auto values = backend.printerGetOptions(m_printerName, m_options);
+
+    // Handed to the backend of the printer, which would load them again.
+    PrinterCapabilities capabilities;
+    if (backend.loadedCapabilities(&capabilities)) {
+        Q_EMIT capabilitiesLoaded(capabilities);
+    }
+
+    Q_EMIT loaded(m_printerName, m_options, values);
+    Q_EMIT finished();
+}
@@ -17,24 +17,28 @@
 #ifndef USC_PRINTERS_CUPS_PRINTERLOADER_H
 #define USC_PRINTERS_CUPS_PRINTERLOADER_H
 
+#include "backend/capabilitycache.h"
+#include "cups/cupsnotifier.h"
 #include "cups/ippclient.h"
-#include "cupsdnotifier.h" // Note: this file was generated.
 #include "printer/printer.h"
 
 #include <QList>
+#include <QMap>
 #include <QObject>
 #include <QSharedPointer>
+#include <QStringList>
+#include <QVariant>
 
 class PrinterLoader : public QObject
 {
     Q_OBJECT
     const QString m_printerName;
     IppClient *m_client;
-    OrgCupsCupsdNotifierInterface *m_notifier;
+    CupsNotifier *m_notifier;
 public:
     explicit PrinterLoader(const QString &printerName,
                            IppClient *client,
-                           OrgCupsCupsdNotifierInterface* notifier,
+                           CupsNotifier* notifier,
                            QObject *parent = Q_NULLPTR);
     ~PrinterLoader();
 
@@ -46,4 +50,57 @@ Q_SIGNALS:
     void loaded(QSharedPointer<Printer> printer);
 };
 
+/* Loads the state and change times of a printer, with a single small
+request. */
+class PrinterStateLoader : public QObject
+{
+    Q_OBJECT
+    const QString m_printerName;
+    IppClient *m_client;
+public:
+    explicit PrinterStateLoader(const QString &printerName,
+                                IppClient *client,
+                                QObject *parent = Q_NULLPTR);
+    ~PrinterStateLoader();
+
+    // Converts the printer attributes of cupsd.
+    static PrinterStateAttributes fromAttributes(
+        const QString &printerName, const QMap<QString, QVariant> &attributes);
+
+public Q_SLOTS:
+    void load();
+
+Q_SIGNALS:
+    void finished();
+    void loaded(const PrinterStateAttributes &attributes);
+};
+
+/* Loads some options of a printer, with a backend of its own so that the
+backend of the printer is only ever used from the thread it lives in. */
+class PrinterOptionsLoader : public QObject
+{
+    Q_OBJECT
+    const QString m_printerName;
+    const QStringList m_options;
+    IppClient *m_client;
+    CupsNotifier *m_notifier;
+public:
+    explicit PrinterOptionsLoader(const QString &printerName,
+                                  const QStringList &options,
+                                  IppClient *client,
+                                  CupsNotifier* notifier,
+                                  QObject *parent = Q_NULLPTR);
+    ~PrinterOptionsLoader();
+
+public Q_SLOTS:
+    void load();
+
+Q_SIGNALS:
+    void finished();
+    void loaded(const QString &printerName, const QStringList &options,
+                const QMap<QString, QVariant> &values);
+    // Emitted before loaded, if the options needed the capabilities.
+    void capabilitiesLoaded(const PrinterCapabilities &capabilities);
+};
+
 #endif // USC_PRINTERS_CUPS_PRINTERLOADER_H
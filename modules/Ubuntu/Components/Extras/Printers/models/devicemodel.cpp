@@ -104,10 +104,12 @@ void DeviceModel::deviceLoaded(const Device &device)
         return;
     }
 
-    if (!m_devices.contains(device)) {
+    QString key = device.key();
+    if (!m_keys.contains(key)) {
         int i = m_devices.size();
         beginInsertRows(QModelIndex(), i, i);
         m_devices.append(device);
+        m_keys << key;
         endInsertRows();
 
         Q_EMIT countChanged();
@@ -124,6 +126,7 @@ void DeviceModel::clear()
 {
     beginResetModel();
     m_devices.clear();
+    m_keys.clear();
     endResetModel();
 }
 
@@ -135,9 +138,10 @@ void DeviceModel::load()
     } else {
         clear();
         if (m_backend->type() == PrinterEnum::PrinterType::CupsType) {
-            ((PrinterCupsBackend*) m_backend)->searchForDevices();
+            // Cached results may arrive, and finish, right away.
             m_isSearching = true;
             Q_EMIT searchingChanged();
+            ((PrinterCupsBackend*) m_backend)->searchForDevices();
         }
     }
 }
@@ -25,6 +25,7 @@
 #include <QList>
 #include <QModelIndex>
 #include <QObject>
+#include <QSet>
 #include <QVariant>
 
 class PRINTERS_DECL_EXPORT DeviceModel : public QAbstractListModel
@@ -72,6 +73,7 @@ private:
 
     PrinterBackend *m_backend;
     QList<Device> m_devices;
+    QSet<QString> m_keys; // Device::key() of m_devices.
     bool m_isSearching;
 };
 
@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "models/driverindex.h"
+
+#include <QtAlgorithms>
+
+#include <algorithm>
+
+DriverIndex::DriverIndex()
+{
+}
+
+DriverIndex::DriverIndex(const QList<PrinterDriver> &drivers)
+{
+    m_haystacks.reserve(drivers.size());
+    m_words.reserve(drivers.size());
+
+    for (int i = 0; i < drivers.size(); i++) {
+        QByteArray haystack = drivers.at(i).makeModel.toLower();
+        m_haystacks << haystack;
+
+        QList<QByteArray> words;
+        Q_FOREACH(const QByteArray &word, haystack.simplified().split(' ')) {
+            if (!word.isEmpty()) {
+                words << word;
+            }
+        }
+        m_words << words;
+
+        for (int j = 0; j + 3 <= haystack.size(); j++) {
+            QVector<int> &postings = m_trigrams[trigram(haystack.constData() + j)];
+
+            // Drivers are added in order, so the lists stay sorted.
+            if (postings.isEmpty() || postings.last() != i) {
+                postings << i;
+            }
+        }
+    }
+}
+
+int DriverIndex::size() const
+{
+    return m_haystacks.size();
+}
+
+QList<int> DriverIndex::search(const QString &pattern) const
+{
+    QList<QByteArray> needles;
+    Q_FOREACH(const QString &part, pattern.toLower().split(" ")) {
+        if (!part.isEmpty()) {
+            needles << part.toUtf8();
+        }
+    }
+
+    QList<int> result;
+    if (needles.isEmpty()) {
+        for (int i = 0; i < size(); i++) {
+            result << i;
+        }
+        return result;
+    }
+
+    // Gather the posting lists of all trigrams, shortest first.
+    QList<const QVector<int>*> lists;
+    Q_FOREACH(const QByteArray &needle, needles) {
+        for (int j = 0; j + 3 <= needle.size(); j++) {
+            auto it = m_trigrams.constFind(trigram(needle.constData() + j));
+            if (it == m_trigrams.constEnd()) {
+                return result;
+            }
+            lists << &it.value();
+        }
+    }
+    std::sort(lists.begin(), lists.end(),
+              [](const QVector<int> *a, const QVector<int> *b) {
+                  return a->size() < b->size();
+              });
+
+    QVector<int> candidates;
+    if (lists.isEmpty()) {
+        // Only words shorter than a trigram; every driver is a candidate.
+        candidates.reserve(size());
+        for (int i = 0; i < size(); i++) {
+            candidates << i;
+        }
+    } else {
+        candidates = *lists.first();
+        for (int i = 1; i < lists.size() && !candidates.isEmpty(); i++) {
+            candidates = intersect(candidates, *lists.at(i));
+        }
+    }
+
+    struct Match
+    {
+        int driver;
+        int score;
+        int firstMatch;
+    };
+    QVector<Match> matches;
+
+    Q_FOREACH(const int driver, candidates) {
+        // Trigrams do not guarantee that the whole word is contained.
+        bool found = true;
+        Q_FOREACH(const QByteArray &needle, needles) {
+            if (!m_haystacks.at(driver).contains(needle)) {
+                found = false;
+                break;
+            }
+        }
+
+        if (found) {
+            Match match;
+            match.driver = driver;
+            match.score = score(driver, needles, &match.firstMatch);
+            matches << match;
+        }
+    }
+
+    std::stable_sort(matches.begin(), matches.end(),
+                     [](const Match &a, const Match &b) {
+                         if (a.score != b.score)
+                             return a.score > b.score;
+                         return a.firstMatch < b.firstMatch;
+                     });
+
+    result.reserve(matches.size());
+    Q_FOREACH(const Match &match, matches) {
+        result << match.driver;
+    }
+    return result;
+}
+
+quint32 DriverIndex::trigram(const char *s)
+{
+    return (quint32((uchar) s[0]) << 16) | (quint32((uchar) s[1]) << 8)
+        | quint32((uchar) s[2]);
+}
+
+QVector<int> DriverIndex::intersect(const QVector<int> &a,
+                                    const QVector<int> &b)
+{
+    QVector<int> result;
+    result.reserve(qMin(a.size(), b.size()));
+    std::set_intersection(a.constBegin(), a.constEnd(),
+                          b.constBegin(), b.constEnd(),
+                          std::back_inserter(result));
+    return result;
+}
+
+/* Whole words count three, prefixes of words two, and other substrings
+one. firstMatch is the position of the first word that matched. */
+int DriverIndex::score(const int driver, const QList<QByteArray> &needles,
+                       int *firstMatch) const
+{
+    const QList<QByteArray> &words = m_words.at(driver);
+    int total = 0;
+    *firstMatch = words.size();
+
+    Q_FOREACH(const QByteArray &needle, needles) {
+        int best = 1;
+        for (int i = 0; i < words.size() && best < 3; i++) {
+            int points = 0;
+            if (words.at(i) == needle) {
+                points = 3;
+            } else if (words.at(i).startsWith(needle)) {
+                points = 2;
+            }
+
+            if (points > best) {
+                best = points;
+            }
+            if (points > 0 && i < *firstMatch) {
+                *firstMatch = i;
+            }
+        }
+        total += best;
+    }
+    return total;
+}
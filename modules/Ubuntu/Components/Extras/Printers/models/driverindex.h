@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef USC_PRINTERS_DRIVERINDEX_H
+#define USC_PRINTERS_DRIVERINDEX_H
+
+#include "printers_global.h"
+#include "structs.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+/* Search index over the make and model of drivers.
+
+A driver matches a query when every word of the query is contained in its
+lowercased make and model. Candidates are found by intersecting the posting
+lists of the trigrams of the words, so that only a few drivers have to be
+compared, whatever the query. Matches are ranked by how many words match
+whole words of the make and model, then by how early they match. */
+class PRINTERS_DECL_EXPORT DriverIndex
+{
+public:
+    DriverIndex();
+    explicit DriverIndex(const QList<PrinterDriver> &drivers);
+
+    int size() const;
+
+    // The positions in the indexed list of the matching drivers, best first.
+    QList<int> search(const QString &pattern) const;
+
+private:
+    static quint32 trigram(const char *s);
+    static QVector<int> intersect(const QVector<int> &a, const QVector<int> &b);
+
+    int score(const int driver, const QList<QByteArray> &needles,
+              int *firstMatch) const;
+
+    QVector<QByteArray> m_haystacks; // Lowercased make and model.
+    QVector<QList<QByteArray>> m_words;
+    QHash<quint32, QVector<int>> m_trigrams; // Trigram, sorted drivers.
+};
+
+#endif // USC_PRINTERS_DRIVERINDEX_H
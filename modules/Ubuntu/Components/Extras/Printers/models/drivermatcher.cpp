@@ -0,0 +1,293 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "models/drivermatcher.h"
+
+#include <QMap>
+#include <QSet>
+
+#include <algorithm>
+
+// Scores of the different kinds of matches.
+#define MATCH_EXACT 100
+#define MATCH_MODEL 90
+#define MATCH_MODEL_PREFIX 80
+#define MATCH_MODEL_WORDS 20
+#define MATCH_GENERIC 5
+
+DriverMatcher::DriverMatcher()
+{
+}
+
+DriverMatcher::DriverMatcher(const QList<PrinterDriver> &drivers)
+{
+    m_models.reserve(drivers.size());
+    m_modelWords.reserve(drivers.size());
+    m_recommended.reserve(drivers.size());
+
+    for (int i = 0; i < drivers.size(); i++) {
+        const PrinterDriver &driver = drivers.at(i);
+        QString makeModel = QString::fromUtf8(driver.makeModel);
+
+        QString manufacturer;
+        QString model;
+        splitMakeModel(makeModel, &manufacturer, &model);
+
+        QStringList words = model.split(' ', QString::SkipEmptyParts);
+        words.removeDuplicates();
+
+        QStringList manufacturers({manufacturer});
+        DeviceId id = parseDeviceId(QString::fromUtf8(driver.deviceId));
+        if (!id.manufacturer.isEmpty() && !id.model.isEmpty()) {
+            m_exact[id.manufacturer + "\n" + id.model] << i;
+            if (id.manufacturer != manufacturer) {
+                manufacturers << id.manufacturer;
+            }
+        }
+
+        Q_FOREACH(const QString &mfg, manufacturers) {
+            Q_FOREACH(const QString &word, words) {
+                m_words[mfg + "\n" + word] << i;
+            }
+        }
+        m_models << model;
+        m_modelWords << words;
+        m_recommended << makeModel.contains(QStringLiteral("recommended"),
+                                            Qt::CaseInsensitive);
+
+        QString normalised = normalise(makeModel);
+        if (normalised.contains(QStringLiteral("generic postscript"))) {
+            m_genericPostScript << i;
+        } else if (normalised.contains(QStringLiteral("generic pcl"))) {
+            m_genericPcl << i;
+        }
+    }
+}
+
+QList<int> DriverMatcher::match(const QString &deviceId,
+                                const QString &makeModel) const
+{
+    DeviceId id = parseDeviceId(deviceId);
+    if (id.manufacturer.isEmpty() || id.model.isEmpty()) {
+        splitMakeModel(makeModel, &id.manufacturer, &id.model);
+    }
+
+    QHash<int, int> scores;
+    auto add = [&scores](const int driver, const int score) {
+        if (scores.value(driver, 0) < score) {
+            scores[driver] = score;
+        }
+    };
+
+    if (!id.manufacturer.isEmpty() && !id.model.isEmpty()) {
+        Q_FOREACH(const int driver,
+                  m_exact.value(id.manufacturer + "\n" + id.model)) {
+            add(driver, MATCH_EXACT);
+        }
+    }
+
+    if (!id.manufacturer.isEmpty() && !id.model.isEmpty()) {
+        QStringList words = id.model.split(' ');
+
+        // Model numbers have to match; "LaserJet 1020" is no "LaserJet 1022".
+        QStringList numbers;
+        Q_FOREACH(const QString &word, words) {
+            if (isNumber(word)) {
+                numbers << word;
+            }
+        }
+
+        /* Every driver that scores shares a word with the model, and has all
+        its numbers, so the candidates are those of the rarest number, or of
+        any word when there is no number. */
+        QVector<int> candidates;
+        if (!numbers.isEmpty()) {
+            bool first = true;
+            Q_FOREACH(const QString &number, numbers) {
+                QVector<int> postings = m_words.value(
+                    id.manufacturer + "\n" + number);
+                if (first || postings.size() < candidates.size()) {
+                    candidates = postings;
+                    first = false;
+                }
+            }
+        } else {
+            QSet<int> unique;
+            Q_FOREACH(const QString &word, words) {
+                Q_FOREACH(const int driver, m_words.value(
+                              id.manufacturer + "\n" + word)) {
+                    unique << driver;
+                }
+            }
+            candidates.reserve(unique.size());
+            Q_FOREACH(const int driver, unique) {
+                candidates << driver;
+            }
+        }
+
+        Q_FOREACH(const int driver, candidates) {
+            const QString &model = m_models.at(driver);
+
+            if (model == id.model) {
+                add(driver, MATCH_MODEL);
+            } else if (model.startsWith(id.model + " ")) {
+                add(driver, MATCH_MODEL_PREFIX);
+            } else {
+                const QStringList &driverWords = m_modelWords.at(driver);
+                bool numbersMatch = true;
+                Q_FOREACH(const QString &number, numbers) {
+                    if (!driverWords.contains(number)) {
+                        numbersMatch = false;
+                        break;
+                    }
+                }
+                if (!numbersMatch) {
+                    continue;
+                }
+
+                int common = 0;
+                Q_FOREACH(const QString &word, words) {
+                    if (driverWords.contains(word)) {
+                        common++;
+                    }
+                }
+                if (common > 0) {
+                    add(driver, MATCH_MODEL_WORDS
+                        + (MATCH_MODEL_PREFIX - MATCH_MODEL_WORDS - 1)
+                        * common / words.size());
+                }
+            }
+        }
+    }
+
+    // Fall back to generic drivers for the languages the device speaks.
+    Q_FOREACH(const QString &command, id.commandSets) {
+        if (command.contains(QStringLiteral("postscript"))
+                || command == QStringLiteral("ps")
+                || command == QStringLiteral("br script")) {
+            Q_FOREACH(const int driver, m_genericPostScript) {
+                add(driver, MATCH_GENERIC);
+            }
+        } else if (command.startsWith(QStringLiteral("pcl"))) {
+            Q_FOREACH(const int driver, m_genericPcl) {
+                add(driver, MATCH_GENERIC);
+            }
+        }
+    }
+
+    QList<int> result = scores.keys();
+    std::sort(result.begin(), result.end(),
+              [this, &scores](const int a, const int b) {
+                  int scoreA = scores.value(a) + (m_recommended.at(a) ? 1 : 0);
+                  int scoreB = scores.value(b) + (m_recommended.at(b) ? 1 : 0);
+                  if (scoreA != scoreB)
+                      return scoreA > scoreB;
+                  return a < b;
+              });
+    return result;
+}
+
+DriverMatcher::DeviceId DriverMatcher::parseDeviceId(const QString &deviceId)
+{
+    DeviceId id;
+
+    // Of format "KEY:VAL;…KEYN:VALN;", like Device::toString expects.
+    Q_FOREACH(const QString &pair, deviceId.split(';')) {
+        int colon = pair.indexOf(':');
+        if (colon < 0) {
+            continue;
+        }
+
+        QString key = pair.left(colon).trimmed().toUpper();
+        QString value = pair.mid(colon + 1);
+
+        if (key == QStringLiteral("MFG") || key == QStringLiteral("MANUFACTURER")) {
+            id.manufacturer = manufacturerAlias(normalise(value));
+        } else if (key == QStringLiteral("MDL") || key == QStringLiteral("MODEL")) {
+            id.model = normalise(value);
+        } else if (key == QStringLiteral("CMD") || key == QStringLiteral("COMMAND SET")) {
+            Q_FOREACH(const QString &command, value.split(',')) {
+                QString normalised = normalise(command);
+                if (!normalised.isEmpty()) {
+                    id.commandSets << normalised;
+                }
+            }
+        }
+    }
+
+    // Strip the manufacturer when models repeat it, e.g. "MDL:HP LaserJet".
+    if (!id.manufacturer.isEmpty()
+            && id.model.startsWith(id.manufacturer + " ")) {
+        id.model = id.model.mid(id.manufacturer.size() + 1);
+    }
+    return id;
+}
+
+QString DriverMatcher::normalise(const QString &value)
+{
+    QString normalised = value.toLower();
+    for (int i = 0; i < normalised.size(); i++) {
+        if (!normalised.at(i).isLetterOrNumber()) {
+            normalised[i] = ' ';
+        }
+    }
+    return normalised.simplified();
+}
+
+bool DriverMatcher::isNumber(const QString &word)
+{
+    return std::any_of(word.constBegin(), word.constEnd(),
+                       [](const QChar &c) { return c.isDigit(); });
+}
+
+QString DriverMatcher::manufacturerAlias(const QString &manufacturer)
+{
+    static const QMap<QString, QString> aliases({
+        {QStringLiteral("hewlett packard"), QStringLiteral("hp")},
+        {QStringLiteral("kyocera mita"), QStringLiteral("kyocera")},
+        {QStringLiteral("fuji xerox"), QStringLiteral("xerox")},
+        {QStringLiteral("konica minolta"), QStringLiteral("minolta")},
+        {QStringLiteral("oki data"), QStringLiteral("oki")},
+        {QStringLiteral("okidata"), QStringLiteral("oki")},
+    });
+    return aliases.value(manufacturer, manufacturer);
+}
+
+/* Splits a normalised make and model into manufacturer and model, resolving
+manufacturers with two words. */
+void DriverMatcher::splitMakeModel(const QString &makeModel,
+                                   QString *manufacturer, QString *model)
+{
+    QStringList words = normalise(makeModel).split(' ', QString::SkipEmptyParts);
+    if (words.isEmpty()) {
+        *manufacturer = QString();
+        *model = QString();
+        return;
+    }
+
+    if (words.size() > 1) {
+        QString two = words.at(0) + " " + words.at(1);
+        if (manufacturerAlias(two) != two) {
+            *manufacturer = manufacturerAlias(two);
+            *model = QStringList(words.mid(2)).join(' ');
+            return;
+        }
+    }
+
+    *manufacturer = manufacturerAlias(words.at(0));
+    *model = QStringList(words.mid(1)).join(' ');
+}
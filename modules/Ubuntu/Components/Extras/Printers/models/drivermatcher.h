@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef USC_PRINTERS_DRIVERMATCHER_H
+#define USC_PRINTERS_DRIVERMATCHER_H
+
+#include "printers_global.h"
+#include "structs.h"
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/* Finds the drivers suitable for a device, from its IEEE 1284 device id.
+
+Drivers are indexed by the manufacturer and model in their own device id,
+and by each word of their model within the manufacturer their make and
+model starts with. A lookup only scores the drivers of the device's
+manufacturer that have its model numbers, or if it has none, that share a
+word with its model, so it costs as much as the drivers of that model
+rather than all drivers of the manufacturer. Manufacturer and model are
+compared normalised: lowercased, with punctuation removed and common
+aliases (like Hewlett-Packard for HP) resolved. */
+class PRINTERS_DECL_EXPORT DriverMatcher
+{
+public:
+    DriverMatcher();
+    explicit DriverMatcher(const QList<PrinterDriver> &drivers);
+
+    /* The positions in the indexed list of the drivers for the device,
+    best first. makeModel is used when the device id lacks MFG or MDL. */
+    QList<int> match(const QString &deviceId,
+                     const QString &makeModel = QString()) const;
+
+    // Normalised MFG, MDL and CMD values of a device id.
+    struct DeviceId
+    {
+        QString manufacturer;
+        QString model;
+        QStringList commandSets;
+    };
+    static DeviceId parseDeviceId(const QString &deviceId);
+    static QString normalise(const QString &value);
+
+private:
+    static QString manufacturerAlias(const QString &manufacturer);
+    static void splitMakeModel(const QString &makeModel,
+                               QString *manufacturer, QString *model);
+    static bool isNumber(const QString &word);
+
+    QHash<QString, QVector<int>> m_exact; // "mfg\nmdl", drivers.
+    QHash<QString, QVector<int>> m_words; // "mfg\nword", drivers.
+    QVector<QString> m_models; // Normalised model of each driver.
+    QVector<QStringList> m_modelWords; // Words of each model.
+    QVector<bool> m_recommended;
+    QVector<int> m_genericPostScript;
+    QVector<int> m_genericPcl;
+};
+
+#endif // USC_PRINTERS_DRIVERMATCHER_H
@@ -18,19 +18,30 @@
 #include "models/drivermodel.h"
 
 #include <QDebug>
+#include <QHash>
+#include <QVector>
 #include <QtConcurrent>
 
+// How many rows are fetched at a time.
+#define DRIVER_PAGE_SIZE 200
+
 DriverModel::DriverModel(PrinterBackend *backend, QObject *parent)
     : QAbstractListModel(parent)
     , m_backend(backend)
 {
+    connect(m_backend, SIGNAL(printerDriversChunkLoaded(const QList<PrinterDriver>&)),
+            this, SLOT(printerDriversChunkLoaded(const QList<PrinterDriver>&)));
     connect(m_backend, SIGNAL(printerDriversLoaded(const QList<PrinterDriver>&)),
             this, SLOT(printerDriversLoaded(const QList<PrinterDriver>&)));
 
     QObject::connect(&m_watcher,
-                     &QFutureWatcher<PrinterDriver>::finished,
+                     &QFutureWatcher<QSharedPointer<DriverIndex>>::finished,
+                     this,
+                     &DriverModel::indexFinished);
+    QObject::connect(&m_matcherWatcher,
+                     &QFutureWatcher<QSharedPointer<DriverMatcher>>::finished,
                      this,
-                     &DriverModel::filterFinished);
+                     &DriverModel::matcherFinished);
 
 }
 
@@ -47,7 +58,27 @@ int DriverModel::rowCount(const QModelIndex &parent) const
 
 int DriverModel::count() const
 {
-    return rowCount();
+    return m_results.size();
+}
+
+bool DriverModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return false;
+    return m_drivers.size() < m_results.size();
+}
+
+void DriverModel::fetchMore(const QModelIndex &parent)
+{
+    if (!canFetchMore(parent))
+        return;
+
+    int first = m_drivers.size();
+    int last = qMin(first + DRIVER_PAGE_SIZE, m_results.size()) - 1;
+
+    beginInsertRows(QModelIndex(), first, last);
+    m_drivers.append(m_results.mid(first, last - first + 1));
+    endInsertRows();
 }
 
 QVariant DriverModel::data(const QModelIndex &index, int role) const
@@ -97,45 +128,19 @@ QHash<int, QByteArray> DriverModel::roleNames() const
 
 void DriverModel::setFilter(const QString& pattern)
 {
-    QList<QByteArray> needles;
-    Q_FOREACH(const QString patternPart, pattern.toLower().split(" ")) {
-        needles.append(patternPart.toUtf8());
-    }
-    QList<PrinterDriver> list;
-
-    if (m_watcher.isRunning())
-        m_watcher.cancel();
+    m_filter = pattern;
 
     if (pattern.isEmpty()) {
         setModel(m_originalDrivers);
-        m_filter = pattern;
         return;
     }
 
-    if (!m_filter.isEmpty() && !m_drivers.isEmpty() &&
-            pattern.startsWith(m_filter))
-        list = m_drivers; // search in the smaller list
-    else
-        list = m_originalDrivers; //search in the whole list
-
-    m_filter = pattern;
-
-    QFuture<PrinterDriver> future(QtConcurrent::filtered(list,
-            [needles] (const PrinterDriver &driver) {
-                QByteArray haystack = driver.makeModel.toLower();
-                Q_FOREACH(const QByteArray needle, needles) {
-                    if (!haystack.contains(needle)) {
-                        return false;
-                    }
-                }
-                return true;
-            }
-        )
-    );
-
     Q_EMIT filterBegin();
 
-    m_watcher.setFuture(future);
+    // Otherwise the filter is applied once the index is built.
+    if (m_index) {
+        applyFilter();
+    }
 }
 
 QString DriverModel::filter() const
@@ -143,33 +148,234 @@ QString DriverModel::filter() const
     return m_filter;
 }
 
-void DriverModel::filterFinished()
+/* The index of a previous load never gets here, as setFuture() stops
+watching it. */
+void DriverModel::indexFinished()
+{
+    m_index = m_watcher.result();
+    if (!m_filter.isEmpty()) {
+        applyFilter();
+    }
+}
+
+void DriverModel::matcherFinished()
+{
+    m_matcher = m_matcherWatcher.result();
+    Q_EMIT recommendationsChanged();
+}
+
+QList<PrinterDriver> DriverModel::recommendedDrivers(
+        const QString &deviceId, const QString &makeModel) const
 {
-    setModel(m_watcher.future().results());
+    QList<PrinterDriver> list;
+    if (m_matcher) {
+        Q_FOREACH(const int i, m_matcher->match(deviceId, makeModel)) {
+            list << m_originalDrivers.at(i);
+        }
+    }
+    return list;
+}
+
+void DriverModel::applyFilter()
+{
+    QList<PrinterDriver> list;
+    Q_FOREACH(const int i, m_index->search(m_filter)) {
+        list << m_originalDrivers.at(i);
+    }
+    setModel(list);
 }
 
 void DriverModel::load()
 {
+    m_timeToFirstResult = -1;
+    m_loadTimer.start();
+    m_loadingDrivers.clear();
     m_backend->requestPrinterDrivers();
 }
 
 void DriverModel::cancel()
 {
-    if (m_watcher.isRunning())
-        m_watcher.cancel();
+    /* The index is left to finish: a future of QtConcurrent::run cannot be
+    stopped, and the drivers it indexes stay in the model. */
+    m_backend->cancelPrinterDrivers();
+}
+
+qint64 DriverModel::timeToFirstResult() const
+{
+    return m_timeToFirstResult;
+}
+
+void DriverModel::firstResult()
+{
+    if (m_timeToFirstResult < 0 && m_loadTimer.isValid()) {
+        m_timeToFirstResult = m_loadTimer.elapsed();
+    }
+}
+
+/* Appends drivers while they load. They are kept apart from
+m_originalDrivers, which the index and matcher refer to, until all of them
+have loaded. Filtering waits for that too. */
+void DriverModel::printerDriversChunkLoaded(const QList<PrinterDriver> &drivers)
+{
+    if (drivers.isEmpty())
+        return;
+
+    firstResult();
+    m_loadingDrivers.append(drivers);
+    if (!m_filter.isEmpty())
+        return;
+
+    // The rows of a previous load, or of a filter, are replaced instead.
+    if (m_results.size() + drivers.size() != m_loadingDrivers.size()) {
+        setModel(m_loadingDrivers);
+        return;
+    }
+
+    m_results.append(drivers);
+    Q_EMIT countChanged();
+
+    if (m_drivers.size() < DRIVER_PAGE_SIZE) {
+        int first = m_drivers.size();
+        int last = qMin(DRIVER_PAGE_SIZE, m_results.size()) - 1;
+
+        beginInsertRows(QModelIndex(), first, last);
+        m_drivers.append(m_results.mid(first, last - first + 1));
+        endInsertRows();
+    }
 }
 
 void DriverModel::printerDriversLoaded(const QList<PrinterDriver> &drivers)
 {
+    if (!drivers.isEmpty())
+        firstResult();
+
+    // Rows appended from chunks stay, as the drivers come in the same order.
+    m_loadingDrivers.clear();
     m_originalDrivers = drivers;
     setModel(m_originalDrivers);
+
+    m_index.reset();
+    m_watcher.setFuture(QtConcurrent::run([drivers] {
+        return QSharedPointer<DriverIndex>(new DriverIndex(drivers));
+    }));
+
+    m_matcher.reset();
+    m_matcherWatcher.setFuture(QtConcurrent::run([drivers] {
+        return QSharedPointer<DriverMatcher>(new DriverMatcher(drivers));
+    }));
+    Q_EMIT recommendationsChanged();
 }
 
 void DriverModel::setModel(const QList<PrinterDriver> &drivers)
 {
-    beginResetModel();
-    m_drivers = drivers;
-    endResetModel();
+    int oldCount = m_results.size();
+    m_results = drivers;
+
+    // Keep as many rows fetched as before, so views keep their position.
+    int rows = qMin(m_results.size(), qMax(m_drivers.size(), DRIVER_PAGE_SIZE));
+    updateRows(m_results.mid(0, rows));
 
+    if (oldCount != m_results.size()) {
+        Q_EMIT countChanged();
+    }
     Q_EMIT filterComplete();
 }
+
+/* Changes the rows into the given ones by removing and inserting ranges of
+rows, so that views keep the delegates of the rows that stay. Drivers are
+identified by name, make and model, and device ID; the rows that stay take
+the new values. If the rows that stay change order, the model is reset
+instead. */
+void DriverModel::updateRows(const QList<PrinterDriver> &drivers)
+{
+    QHash<QByteArray, int> wanted;
+    Q_FOREACH(const PrinterDriver &driver, drivers) {
+        wanted[driverKey(driver)]++;
+    }
+
+    // Remove the rows that go, last first, in contiguous ranges.
+    QHash<QByteArray, int> kept;
+    QVector<bool> keep(m_drivers.size());
+    for (int i = 0; i < m_drivers.size(); i++) {
+        QByteArray key = driverKey(m_drivers.at(i));
+        if (kept.value(key) < wanted.value(key)) {
+            kept[key]++;
+            keep[i] = true;
+        }
+    }
+    for (int last = m_drivers.size() - 1; last >= 0; last--) {
+        if (keep[last])
+            continue;
+
+        int first = last;
+        while (first > 0 && !keep[first - 1])
+            first--;
+
+        beginRemoveRows(QModelIndex(), first, last);
+        for (int i = last; i >= first; i--)
+            m_drivers.removeAt(i);
+        endRemoveRows();
+
+        last = first;
+    }
+
+    // The rows that stay must be in the new order.
+    QVector<bool> existing(drivers.size());
+    int pos = 0;
+    for (int i = 0; i < drivers.size(); i++) {
+        QByteArray key = driverKey(drivers.at(i));
+        if (kept.value(key) > 0) {
+            kept[key]--;
+            existing[i] = true;
+
+            if (pos >= m_drivers.size() || driverKey(m_drivers.at(pos)) != key) {
+                beginResetModel();
+                m_drivers = drivers;
+                endResetModel();
+                return;
+            }
+            pos++;
+        }
+    }
+
+    // Insert the new rows in contiguous ranges.
+    pos = 0;
+    for (int i = 0; i < drivers.size(); i++) {
+        if (existing[i]) {
+            pos++;
+            continue;
+        }
+
+        int last = i;
+        while (last + 1 < drivers.size() && !existing[last + 1])
+            last++;
+
+        beginInsertRows(QModelIndex(), pos, pos + last - i);
+        for (int j = i; j <= last; j++)
+            m_drivers.insert(pos++, drivers.at(j));
+        endInsertRows();
+
+        i = last;
+    }
+
+    // The rows that stayed may differ in anything but their identity.
+    for (int i = 0; i < drivers.size(); i++) {
+        if (!existing[i])
+            continue;
+
+        int last = i;
+        while (last + 1 < drivers.size() && existing[last + 1])
+            last++;
+
+        for (int j = i; j <= last; j++)
+            m_drivers[j] = drivers.at(j);
+        Q_EMIT dataChanged(index(i), index(last));
+
+        i = last;
+    }
+}
+
+QByteArray DriverModel::driverKey(const PrinterDriver &driver)
+{
+    return driver.name + '\n' + driver.makeModel + '\n' + driver.deviceId;
+}
@@ -19,12 +19,16 @@
 
 #include "printers_global.h"
 
+#include "models/driverindex.h"
+#include "models/drivermatcher.h"
 #include "structs.h"
 
 #include <QAbstractListModel>
+#include <QElapsedTimer>
 #include <QFutureWatcher>
 #include <QModelIndex>
 #include <QObject>
+#include <QSharedPointer>
 #include <QVariant>
 
 class PRINTERS_DECL_EXPORT DriverModel : public QAbstractListModel
@@ -48,12 +52,24 @@ public:
     virtual int rowCount(const QModelIndex &parent = QModelIndex()) const override;
     virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
     virtual QHash<int, QByteArray> roleNames() const override;
+    virtual bool canFetchMore(const QModelIndex &parent) const override;
+    virtual void fetchMore(const QModelIndex &parent) override;
 
+    // The number of matching drivers, of which rowCount() are fetched.
     int count() const;
 
     QString filter() const;
     void setFilter(const QString& pattern);
 
+    /* The drivers suitable for a device, best first. Empty until the
+    drivers are loaded and matched. */
+    QList<PrinterDriver> recommendedDrivers(const QString &deviceId,
+                                            const QString &makeModel) const;
+
+    /* Milliseconds from load() to the first drivers arriving, or -1 if
+    none have arrived yet. */
+    qint64 timeToFirstResult() const;
+
 public Q_SLOTS:
     // Start loading the model.
     void load();
@@ -62,21 +78,41 @@ public Q_SLOTS:
     void cancel();
 
 private Q_SLOTS:
+    void printerDriversChunkLoaded(const QList<PrinterDriver> &drivers);
     void printerDriversLoaded(const QList<PrinterDriver> &drivers);
-    void filterFinished();
+    void indexFinished();
+    void matcherFinished();
 
 Q_SIGNALS:
     void countChanged();
     void filterBegin();
     void filterComplete();
+    void recommendationsChanged();
 
 private:
     void setModel(const QList<PrinterDriver> &drivers);
+    void updateRows(const QList<PrinterDriver> &drivers);
+    static QByteArray driverKey(const PrinterDriver &driver);
+    void applyFilter();
+    void firstResult();
     PrinterBackend *m_backend;
+
+    // The drivers matching the filter, of which the first m_drivers are
+    // exposed as rows.
+    QList<PrinterDriver> m_results;
     QList<PrinterDriver> m_drivers;
     QList<PrinterDriver> m_originalDrivers;
+    QList<PrinterDriver> m_loadingDrivers;
     QString m_filter;
-    QFutureWatcher<PrinterDriver> m_watcher;
+
+    QElapsedTimer m_loadTimer;
+    qint64 m_timeToFirstResult = -1;
+
+    // Built in the background when drivers load; null until then.
+    QSharedPointer<DriverIndex> m_index;
+    QFutureWatcher<QSharedPointer<DriverIndex>> m_watcher;
+    QSharedPointer<DriverMatcher> m_matcher;
+    QFutureWatcher<QSharedPointer<DriverMatcher>> m_matcherWatcher;
 };
 
 #endif // USC_PRINTER_DRIVERMODEL_H
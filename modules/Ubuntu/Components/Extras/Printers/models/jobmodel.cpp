@@ -22,6 +22,9 @@
 
 #include <QDebug>
 
+// How many of the initial jobs are inserted per event loop iteration.
+#define JOB_INSERT_CHUNK 100
+
 JobModel::JobModel(QObject *parent) : QAbstractListModel(parent)
 {
 }
@@ -31,29 +34,36 @@ JobModel::JobModel(PrinterBackend *backend,
     : QAbstractListModel(parent)
     , m_backend(backend)
 {
-    QObject::connect(m_backend, &PrinterBackend::jobCreated,
+    m_eventBus.connectTo(m_backend);
+    QObject::connect(&m_eventBus, &NotifierEventBus::jobCreated,
                      this, &JobModel::jobCreated);
-    QObject::connect(m_backend, &PrinterBackend::jobState,
+    QObject::connect(&m_eventBus, &NotifierEventBus::jobState,
                      this, &JobModel::jobState);
-    QObject::connect(m_backend, &PrinterBackend::jobCompleted,
+    QObject::connect(&m_eventBus, &NotifierEventBus::jobCompleted,
                      this, &JobModel::jobCompleted);
 
     connect(m_backend, SIGNAL(jobLoaded(QString, int, QMap<QString, QVariant>)),
             this, SLOT(updateJob(QString, int, QMap<QString, QVariant>)));
+    connect(m_backend, SIGNAL(jobsLoaded(const QList<JobAttributes>&)),
+            this, SLOT(updateJobs(const QList<JobAttributes>&)));
 
     // Impressions completed happens via printer state changed
-    QObject::connect(m_backend, &PrinterBackend::printerStateChanged,
-                     &m_signalHandler, &SignalRateLimiter::onPrinterStateChanged);
-
-    QObject::connect(&m_signalHandler, SIGNAL(printerModified(const QString&)),
-                     this, SLOT(jobSignalPrinterModified(const QString&)));
-
-    // Add already existing jobs
-    // TODO: even this should probably be in a background thread?
-    // so that it doesn't block startup?
-    Q_FOREACH(auto job, m_backend->printerGetJobs()) {
-        addJob(job);
-    }
+    QObject::connect(&m_eventBus, &NotifierEventBus::printerStateChanged,
+                     this, [this](const QString &, const QString &,
+                                  const QString &printerName, uint,
+                                  const QString &, bool) {
+        jobSignalPrinterModified(printerName);
+    });
+
+    connect(m_backend, SIGNAL(jobListLoaded(const QList<QSharedPointer<PrinterJob>>&)),
+            this, SLOT(jobListLoaded(const QList<QSharedPointer<PrinterJob>>&)));
+
+    m_insertTimer.setInterval(0);
+    connect(&m_insertTimer, SIGNAL(timeout()), this, SLOT(insertPendingJobs()));
+
+    // Add already existing jobs, they are loaded in the background.
+    m_loading = true;
+    m_backend->requestJobs();
 }
 
 JobModel::~JobModel()
@@ -103,12 +113,17 @@ void JobModel::jobState(
     Q_UNUSED(job_name);
 
     QSharedPointer<PrinterJob> job = getJob(printer_name, job_id);
+    int pending = job ? -1 : pendingIndexOf(printer_name, job_id);
 
     if (job) {
         job->setImpressionsCompleted(job_impressions_completed);
         job->setState(static_cast<PrinterEnum::JobState>(job_state));
 
         updateJob(job);
+    } else if (pending > -1) {
+        job = m_pendingJobs.at(pending);
+        job->setImpressionsCompleted(job_impressions_completed);
+        job->setState(static_cast<PrinterEnum::JobState>(job_state));
     } else {
         qWarning() << "JobModel::jobState for unknown job: " << job_name << " ("
                    << job_id << ") for " << printer_name;
@@ -133,9 +148,17 @@ void JobModel::jobCompleted(
     Q_UNUSED(job_impressions_completed);
 
     auto job = getJob(printer_name, job_id);
+    int pending = job ? -1 : pendingIndexOf(printer_name, job_id);
+
+    if (m_loading) {
+        m_completedWhileLoading << QPair<QString, int>(printer_name, job_id);
+    }
+
     if (job) {
         removeJob(job);
-    } else {
+    } else if (pending > -1) {
+        m_pendingJobs.removeAt(pending);
+    } else if (!m_loading) {
         qWarning() << "JobModel::jobCompleted for unknown job: " << job_name << " ("
                    << job_id << ") for " << printer_name;
     }
@@ -143,24 +166,32 @@ void JobModel::jobCompleted(
 
 void JobModel::jobSignalPrinterModified(const QString &printerName)
 {
-    // Find the active or pending job and force a refresh
+    // Find the active or pending jobs and force a refresh
     // We force refresh pending jobs incase there is a flood of signals
     // meaning that the jobStateChanged signal might not have happened yet
+    QList<int> jobIds;
     Q_FOREACH(auto job, m_jobs) {
         if (job->printerName() == printerName
                 && (job->state() == PrinterEnum::JobState::Processing
                         || job->state() == PrinterEnum::JobState::Pending)) {
-            Q_EMIT forceJobRefresh(printerName, job->jobId());
+            jobIds << job->jobId();
         }
     }
+
+    if (!jobIds.isEmpty()) {
+        Q_EMIT forceJobsRefresh(printerName, jobIds);
+    }
 }
 
 void JobModel::addJob(QSharedPointer<PrinterJob> job)
 {
     int i = m_jobs.size();
+    QPair<QString, int> key(job->printerName(), job->jobId());
 
     beginInsertRows(QModelIndex(), i, i);
     m_jobs.append(job);
+    if (!m_jobIndex.contains(key))
+        m_jobIndex.insert(key, i);
     endInsertRows();
 
     Q_EMIT countChanged();
@@ -168,10 +199,17 @@ void JobModel::addJob(QSharedPointer<PrinterJob> job)
 
 void JobModel::removeJob(QSharedPointer<PrinterJob> job)
 {
-    int i = m_jobs.indexOf(job);
+    int i = rowOf(job);
+    if (i < 0)
+        return;
+
+    QPair<QString, int> key(job->printerName(), job->jobId());
 
     beginRemoveRows(QModelIndex(), i, i);
     m_jobs.removeAt(i);
+    if (m_jobIndex.value(key, -1) == i)
+        m_jobIndex.remove(key);
+    reindexFrom(i);
     endRemoveRows();
 
     Q_EMIT countChanged();
@@ -180,7 +218,7 @@ void JobModel::removeJob(QSharedPointer<PrinterJob> job)
 // This is used by JobModel::jobState as it has modified an existing job
 void JobModel::updateJob(QSharedPointer<PrinterJob> job)
 {
-    int i = m_jobs.indexOf(job);
+    int i = rowOf(job);
     QModelIndex idx = index(i);
     Q_EMIT dataChanged(idx, idx);
 }
@@ -190,13 +228,11 @@ void JobModel::updateJob(QSharedPointer<PrinterJob> job)
 void JobModel::updateJob(QString printerName, int jobId,
                          QMap<QString, QVariant> attributes)
 {
-    QSharedPointer<PrinterJob> job = getJob(printerName, jobId);
-
-    int i = m_jobs.indexOf(job);
+    int i = m_jobIndex.value(QPair<QString, int>(printerName, jobId), -1);
     QModelIndex idx = index(i);
 
     if (i > -1) {
-        job->loadAttributes(attributes);
+        m_jobs.at(i)->loadAttributes(attributes);
 
         Q_EMIT dataChanged(idx, idx);
     } else {
@@ -204,14 +240,118 @@ void JobModel::updateJob(QString printerName, int jobId,
     }
 }
 
+// This is used by JobLoader when the attributes of many jobs were loaded at
+// once, it emits a single dataChanged for all of them.
+void JobModel::updateJobs(const QList<JobAttributes> &jobs)
+{
+    int first = -1;
+    int last = -1;
+
+    Q_FOREACH(const JobAttributes &attributes, jobs) {
+        int i = m_jobIndex.value(QPair<QString, int>(attributes.printerName,
+                                                     attributes.jobId), -1);
+
+        if (i > -1) {
+            m_jobs.at(i)->loadAttributes(attributes.attributes);
+
+            first = first < 0 ? i : qMin(first, i);
+            last = qMax(last, i);
+        } else {
+            qWarning() << "Tried to updateJob which doesn't exist:"
+                       << attributes.printerName << attributes.jobId;
+        }
+    }
+
+    if (first > -1) {
+        Q_EMIT dataChanged(index(first), index(last));
+    }
+}
+
+void JobModel::jobListLoaded(const QList<QSharedPointer<PrinterJob>> &jobs)
+{
+    // The list was taken before these jobs completed.
+    Q_FOREACH(auto job, jobs) {
+        QPair<QString, int> key(job->printerName(), job->jobId());
+        if (!m_completedWhileLoading.contains(key)) {
+            m_pendingJobs << job;
+        }
+    }
+    m_completedWhileLoading.clear();
+
+    insertPendingJobs();
+}
+
+/* Inserts the next chunk of the initial jobs, and keeps doing so on the
+following event loop iterations until all of them are in the model. */
+void JobModel::insertPendingJobs()
+{
+    QList<QSharedPointer<PrinterJob>> chunk;
+    while (!m_pendingJobs.isEmpty() && chunk.size() < JOB_INSERT_CHUNK) {
+        auto job = m_pendingJobs.takeFirst();
+
+        // Jobs created while loading are already in the model.
+        if (!getJob(job->printerName(), job->jobId())) {
+            chunk << job;
+        }
+    }
+
+    if (!chunk.isEmpty()) {
+        int first = m_jobs.size();
+
+        beginInsertRows(QModelIndex(), first, first + chunk.size() - 1);
+        Q_FOREACH(auto job, chunk) {
+            QPair<QString, int> key(job->printerName(), job->jobId());
+            if (!m_jobIndex.contains(key))
+                m_jobIndex.insert(key, m_jobs.size());
+            m_jobs.append(job);
+        }
+        endInsertRows();
+
+        Q_EMIT countChanged();
+    }
+
+    if (m_pendingJobs.isEmpty()) {
+        m_insertTimer.stop();
+
+        if (m_loading) {
+            m_loading = false;
+            m_completedWhileLoading.clear();
+            Q_EMIT loadingChanged();
+        }
+    } else if (!m_insertTimer.isActive()) {
+        m_insertTimer.start();
+    }
+}
+
+int JobModel::pendingIndexOf(const QString &printerName, const int jobId) const
+{
+    for (int i = 0; i < m_pendingJobs.size(); i++) {
+        if (m_pendingJobs.at(i)->printerName() == printerName
+                && m_pendingJobs.at(i)->jobId() == jobId) {
+            return i;
+        }
+    }
+    return -1;
+}
+
 void JobModel::updateJobPrinter(QSharedPointer<PrinterJob> job, QSharedPointer<Printer> printer)
 {
-    int i = m_jobs.indexOf(job);
+    int i = rowOf(job);
     QModelIndex idx = index(i);
 
     if (i > -1) {
+        QPair<QString, int> oldKey(job->printerName(), job->jobId());
         job->setPrinter(printer);
 
+        // The printer name is part of the key of the job.
+        QPair<QString, int> newKey(job->printerName(), job->jobId());
+        if (newKey != oldKey) {
+            if (m_jobIndex.value(oldKey, -1) == i)
+                m_jobIndex.remove(oldKey);
+            if (!m_jobIndex.contains(newKey))
+                m_jobIndex.insert(newKey, i);
+        }
+
         Q_EMIT dataChanged(idx, idx);
     } else {
         qWarning() << "Tried to updateJobPrinter which doesn't exist:" << printer->name() << job->jobId();
@@ -229,6 +369,11 @@ int JobModel::count() const
     return rowCount();
 }
 
+bool JobModel::loading() const
+{
+    return m_loading;
+}
+
 QVariant JobModel::data(const QModelIndex &index, int role) const
 {
     QVariant ret;
@@ -386,14 +531,42 @@ QVariantMap JobModel::get(const int row) const
 
 QSharedPointer<PrinterJob> JobModel::getJob(const QString &printerName, const int &id)
 {
-    Q_FOREACH(auto job, m_jobs) {
-        if (job->printerName() == printerName && job->jobId() == id) {
-            return job;
-        }
+    int i = m_jobIndex.value(QPair<QString, int>(printerName, id), -1);
+    if (i > -1) {
+        return m_jobs.at(i);
     }
     return QSharedPointer<PrinterJob>(Q_NULLPTR);
 }
 
+int JobModel::rowOf(QSharedPointer<PrinterJob> job) const
+{
+    if (!job) {
+        return -1;
+    }
+
+    int i = m_jobIndex.value(QPair<QString, int>(job->printerName(),
+                                                 job->jobId()), -1);
+    if (i > -1 && m_jobs.at(i) != job) {
+        i = m_jobs.indexOf(job);
+    }
+    return i;
+}
+
+/* Updates the index for the rows from the given one on, after a row was
+removed before them. Only the first job with a given key is indexed, so a
+duplicate takes over the key when that one goes away. */
+void JobModel::reindexFrom(const int row)
+{
+    for (int i = row; i < m_jobs.size(); i++) {
+        QPair<QString, int> key(m_jobs.at(i)->printerName(),
+                                m_jobs.at(i)->jobId());
+        int indexed = m_jobIndex.value(key, -1);
+        if (indexed == i + 1 || indexed < 0) {
+            m_jobIndex.insert(key, i);
+        }
+    }
+}
+
 
 JobFilter::JobFilter(QObject *parent) : QSortFilterProxyModel(parent)
 {
@@ -20,12 +20,14 @@
 #include "printers_global.h"
 #include "backend/backend.h"
 #include "printer/printerjob.h"
-#include "printer/signalratelimiter.h"
+#include "printer/notifiereventbus.h"
 
 #include <QAbstractListModel>
 #include <QByteArray>
+#include <QHash>
 #include <QModelIndex>
 #include <QObject>
+#include <QSet>
 #include <QSharedPointer>
 #include <QSortFilterProxyModel>
 #include <QTimer>
@@ -38,6 +40,7 @@ class PRINTERS_DECL_EXPORT JobModel : public QAbstractListModel
     Q_OBJECT
 
     Q_PROPERTY(int count READ count NOTIFY countChanged)
+    Q_PROPERTY(bool loading READ loading NOTIFY loadingChanged)
 public:
     explicit JobModel(QObject *parent = Q_NULLPTR);
     explicit JobModel(PrinterBackend *backend,
@@ -77,6 +80,7 @@ public:
     virtual QHash<int, QByteArray> roleNames() const override;
 
     int count() const;
+    bool loading() const;
 
     Q_INVOKABLE QVariantMap get(const int row) const;
     QSharedPointer<PrinterJob> getJob(const QString &printerName, const int &id);
@@ -86,11 +90,24 @@ private:
     void addJob(QSharedPointer<PrinterJob> job);
     void removeJob(QSharedPointer<PrinterJob> job);
     void updateJob(QSharedPointer<PrinterJob> Job);
+    int rowOf(QSharedPointer<PrinterJob> job) const;
+    void reindexFrom(const int row);
+    int pendingIndexOf(const QString &printerName, const int jobId) const;
 
     PrinterBackend *m_backend;
 
     QList<QSharedPointer<PrinterJob>> m_jobs;
-    SignalRateLimiter m_signalHandler;
+    // (printer name, job id) to row in m_jobs, kept in step with it.
+    QHash<QPair<QString, int>, int> m_jobIndex;
+
+    // The initial jobs, which are inserted a chunk at a time.
+    QList<QSharedPointer<PrinterJob>> m_pendingJobs;
+    QTimer m_insertTimer;
+    bool m_loading = false;
+    /* Jobs that completed while the initial jobs were being loaded, which
+    the loaded list may still have. */
+    QSet<QPair<QString, int>> m_completedWhileLoading;
+    NotifierEventBus m_eventBus;
 private Q_SLOTS:
     void jobCreated(const QString &text, const QString &printer_uri,
                     const QString &printer_name, uint printer_state,
@@ -115,10 +132,15 @@ private Q_SLOTS:
                       uint job_impressions_completed);
     void jobSignalPrinterModified(const QString &printerName);
     void updateJob(QString printerName, int jobId, QMap<QString, QVariant> attributes);
+    void updateJobs(const QList<JobAttributes> &jobs);
+    void jobListLoaded(const QList<QSharedPointer<PrinterJob>> &jobs);
+    void insertPendingJobs();
 
 Q_SIGNALS:
     void countChanged();
-    void forceJobRefresh(const QString &printerName, const int jobId);
+    void loadingChanged();
+    // The active jobs of a printer whose state changed.
+    void forceJobsRefresh(const QString &printerName, const QList<int> &jobIds);
 };
 
 class PRINTERS_DECL_EXPORT JobFilter : public QSortFilterProxyModel
@@ -29,19 +29,18 @@ PrinterModel::PrinterModel(PrinterBackend *backend, QObject *parent)
     , m_backend(backend)
 {
 
-    QObject::connect(m_backend, &PrinterBackend::printerAdded,
+    m_eventBus.connectTo(m_backend);
+    QObject::connect(&m_eventBus, &NotifierEventBus::printerAdded,
                      this, &PrinterModel::printerAdded);
-    QObject::connect(m_backend, &PrinterBackend::printerModified,
-                     &m_signalHandler, &SignalRateLimiter::onPrinterModified);
-    QObject::connect(m_backend, &PrinterBackend::printerStateChanged,
-                     &m_signalHandler, &SignalRateLimiter::onPrinterModified);
-    QObject::connect(m_backend, &PrinterBackend::printerDeleted,
+    QObject::connect(&m_eventBus, &NotifierEventBus::printerDeleted,
                      this, &PrinterModel::printerDeleted);
 
-    connect(&m_signalHandler, SIGNAL(printerModified(const QString&)),
+    connect(&m_eventBus, SIGNAL(printerChanged(const QString&)),
             this, SLOT(printerModified(const QString&)));
     connect(m_backend, SIGNAL(printerLoaded(QSharedPointer<Printer>)),
             this, SLOT(printerLoaded(QSharedPointer<Printer>)));
+    connect(m_backend, SIGNAL(printerStateLoaded(const PrinterStateAttributes&)),
+            this, SLOT(printerStateLoaded(const PrinterStateAttributes&)));
 
     // Create printer proxies for every printerName.
     Q_FOREACH(auto printerName, m_backend->availablePrinterNames()) {
@@ -78,11 +77,57 @@ void PrinterModel::printerLoaded(QSharedPointer<Printer> printer)
     }
 }
 
+void PrinterModel::printerStateLoaded(const PrinterStateAttributes &attributes)
+{
+    auto printer = getPrinterByName(attributes.printerName);
+    if (!printer || printer->type() == PrinterEnum::PrinterType::ProxyType)
+        return;
+
+    /* Anything but the state may have changed with the configuration, or
+    we could not tell; so load the whole printer again. */
+    if (attributes.configChangeTime < 0
+            || attributes.configChangeTime != printer->configChangeTime()) {
+        m_backend->requestPrinter(attributes.printerName);
+        return;
+    }
+
+    if (attributes.stateChangeTime > -1
+            && attributes.stateChangeTime == printer->stateChangeTime()) {
+        return;
+    }
+
+    QVector<int> roles;
+    if (printer->state() != attributes.state) {
+        roles << StateRole << EnabledRole;
+    }
+    if (printer->lastMessage() != attributes.stateMessage) {
+        roles << LastMessageRole;
+    }
+    if (printer->acceptJobs() != attributes.acceptJobs) {
+        roles << AcceptJobsRole;
+    }
+
+    printer->updateState(attributes);
+
+    if (!roles.isEmpty()) {
+        QModelIndex idx = index(rowOf(printer));
+        Q_EMIT dataChanged(idx, idx, roles);
+    }
+}
+
 void PrinterModel::printerModified(const QString &printerName)
 {
     // These signals might be emitted of a now deleted printer.
-    if (getPrinterByName(printerName))
+    auto printer = getPrinterByName(printerName);
+    if (!printer)
+        return;
+
+    /* A printer that is not loaded yet is loaded in full. Otherwise its state
+    is loaded first, and the rest only if its configuration changed. */
+    if (printer->type() == PrinterEnum::PrinterType::ProxyType)
         m_backend->requestPrinter(printerName);
+    else
+        m_backend->requestPrinterState(printerName);
 }
 
 void PrinterModel::printerAdded(
@@ -124,18 +169,66 @@ void PrinterModel::printerDeleted(
 
 QSharedPointer<Printer> PrinterModel::getPrinterByName(const QString &printerName)
 {
-    Q_FOREACH(auto p, m_printers) {
-        if (p->name() == printerName)
-            return p;
-    }
+    int i = m_printerIndex.value(printerName, -1);
+    if (i > -1)
+        return m_printers.at(i);
     return QSharedPointer<Printer>(Q_NULLPTR);
 }
 
+int PrinterModel::rowOf(QSharedPointer<Printer> printer) const
+{
+    int i = m_printerIndex.value(printer->name(), -1);
+    if (i > -1 && m_printers.at(i) != printer)
+        i = m_printers.indexOf(printer);
+    return i;
+}
+
+void PrinterModel::printerAttributesLoaded(Printer *printer,
+                                           const QVector<int> &roles)
+{
+    int i = m_printerIndex.value(printer->name(), -1);
+    if (i < 0 || m_printers.at(i).data() != printer) {
+        i = -1;
+        for (int j = 0; j < m_printers.size(); j++) {
+            if (m_printers.at(j).data() == printer) {
+                i = j;
+                break;
+            }
+        }
+    }
+
+    if (i > -1) {
+        QModelIndex idx = index(i);
+        Q_EMIT dataChanged(idx, idx, roles);
+    }
+}
+
+/* Updates the index for the rows from the given one on, after a row was
+removed before them. Only the first printer with a given name is indexed,
+so a duplicate takes over the name when that one goes away. */
+void PrinterModel::reindexFrom(const int row)
+{
+    for (int i = row; i < m_printers.size(); i++) {
+        QString name = m_printers.at(i)->name();
+        int indexed = m_printerIndex.value(name, -1);
+        if (indexed == i + 1 || indexed < 0)
+            m_printerIndex.insert(name, i);
+    }
+}
+
 void PrinterModel::removePrinter(QSharedPointer<Printer> printer, const CountChangeSignal &notify)
 {
-    int idx = m_printers.indexOf(printer);
+    int idx = rowOf(printer);
+    if (idx < 0)
+        return;
+
+    printer->disconnect(this);
+
     beginRemoveRows(QModelIndex(), idx, idx);
     m_printers.removeAt(idx);
+    if (m_printerIndex.value(printer->name(), -1) == idx)
+        m_printerIndex.remove(printer->name());
+    reindexFrom(idx);
     endRemoveRows();
 
     if (notify == CountChangeSignal::Emit)
@@ -145,7 +238,7 @@ void PrinterModel::removePrinter(QSharedPointer<Printer> printer, const CountCha
 void PrinterModel::updatePrinter(QSharedPointer<Printer> old,
                                   QSharedPointer<Printer> newPrinter)
 {
-    int i = m_printers.indexOf(old);
+    int i = rowOf(old);
     QModelIndex idx = index(i);
     old->updateFrom(newPrinter);
     Q_EMIT dataChanged(idx, idx);
@@ -153,9 +246,32 @@ void PrinterModel::updatePrinter(QSharedPointer<Printer> old,
 
 void PrinterModel::addPrinter(QSharedPointer<Printer> printer, const CountChangeSignal &notify)
 {
+    // Attributes loaded in the background change these roles.
+    Printer *p = printer.data();
+    connect(p, &Printer::stateAttributesChanged, this, [this, p]() {
+        printerAttributesLoaded(p, QVector<int>({
+            AcceptJobsRole, LastMessageRole,
+        }));
+    });
+    connect(p, &Printer::capabilitiesChanged, this, [this, p]() {
+        printerAttributesLoaded(p, QVector<int>({
+            ColorModelRole, SupportedColorModelsRole,
+            PrintQualityRole, SupportedPrintQualitiesRole,
+            DuplexRole, SupportedDuplexModesRole,
+            PageSizeRole, SupportedPageSizesRole,
+        }));
+    });
+    connect(p, &Printer::extendedAttributesChanged, this, [this, p]() {
+        printerAttributesLoaded(p, QVector<int>({
+            DeviceUriRole, HostNameRole, CopiesRole, SharedRole,
+        }));
+    });
+
     int i = m_printers.size();
     beginInsertRows(QModelIndex(), i, i);
     m_printers.append(printer);
+    if (!m_printerIndex.contains(printer->name()))
+        m_printerIndex.insert(printer->name(), i);
     endInsertRows();
 
     if (notify == CountChangeSignal::Emit)
@@ -194,7 +310,8 @@ QVariant PrinterModel::data(const QModelIndex &index, int role) const
             case IsLoadedRole:
                 break; // All of these can be inferred from the name (lazily).
             default:
-                m_backend->requestPrinter(printer->name());
+                m_backend->requestPrinter(printer->name(),
+                                          TaskScheduler::Priority::Visible);
             }
         }
 
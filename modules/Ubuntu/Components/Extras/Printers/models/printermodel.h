@@ -21,14 +21,16 @@
 
 #include "models/jobmodel.h"
 #include "printer/printer.h"
-#include "printer/signalratelimiter.h"
+#include "printer/notifiereventbus.h"
 
 #include <QAbstractListModel>
 #include <QByteArray>
+#include <QHash>
 #include <QModelIndex>
 #include <QObject>
 #include <QSortFilterProxyModel>
 #include <QVariant>
+#include <QVector>
 
 class PRINTERS_DECL_EXPORT PrinterModel : public QAbstractListModel
 {
@@ -101,13 +103,19 @@ private:
         const CountChangeSignal &notify = CountChangeSignal::Defer);
     void updatePrinter(QSharedPointer<Printer> old,
                        QSharedPointer<Printer> newPrinter);
+    int rowOf(QSharedPointer<Printer> printer) const;
+    void printerAttributesLoaded(Printer *printer, const QVector<int> &roles);
+    void reindexFrom(const int row);
     PrinterBackend *m_backend;
 
     QList<QSharedPointer<Printer>> m_printers;
-    SignalRateLimiter m_signalHandler;
+    // Printer name to row in m_printers, kept in step with it.
+    QHash<QString, int> m_printerIndex;
+    NotifierEventBus m_eventBus;
 
 private Q_SLOTS:
     void printerLoaded(QSharedPointer<Printer> printer);
+    void printerStateLoaded(const PrinterStateAttributes &attributes);
     void printerModified(const QString &printerName);
     void printerAdded(const QString &text, const QString &printerUri,
         const QString &printerName, uint printerState,
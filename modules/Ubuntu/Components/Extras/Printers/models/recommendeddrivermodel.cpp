@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "models/recommendeddrivermodel.h"
+
+RecommendedDriverModel::RecommendedDriverModel(DriverModel *drivers,
+                                               const QString &deviceId,
+                                               const QString &makeModel,
+                                               QObject *parent)
+    : QAbstractListModel(parent)
+    , m_source(drivers)
+    , m_deviceId(deviceId)
+    , m_makeModel(makeModel)
+{
+    connect(drivers, SIGNAL(recommendationsChanged()), this, SLOT(update()));
+    update();
+}
+
+RecommendedDriverModel::~RecommendedDriverModel()
+{
+}
+
+int RecommendedDriverModel::rowCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent);
+    return m_drivers.size();
+}
+
+int RecommendedDriverModel::count() const
+{
+    return rowCount();
+}
+
+QVariant RecommendedDriverModel::data(const QModelIndex &index, int role) const
+{
+    QVariant ret;
+
+    if ((0 <= index.row()) && (index.row() < m_drivers.size())) {
+
+        auto driver = m_drivers[index.row()];
+
+        switch (role) {
+        case Qt::DisplayRole:
+            ret = driver.toString();
+            break;
+        case DriverModel::NameRole:
+            ret = driver.name;
+            break;
+        case DriverModel::DeviceIdRole:
+            ret = driver.deviceId;
+            break;
+        case DriverModel::LanguageRole:
+            ret = driver.language;
+            break;
+        case DriverModel::MakeModelRole:
+            ret = driver.makeModel;
+            break;
+        }
+    }
+
+    return ret;
+}
+
+QHash<int, QByteArray> RecommendedDriverModel::roleNames() const
+{
+    return m_source ? m_source->roleNames() : QHash<int, QByteArray>();
+}
+
+void RecommendedDriverModel::update()
+{
+    if (!m_source) {
+        return;
+    }
+
+    beginResetModel();
+    m_drivers = m_source->recommendedDrivers(m_deviceId, m_makeModel);
+    endResetModel();
+
+    Q_EMIT countChanged();
+}
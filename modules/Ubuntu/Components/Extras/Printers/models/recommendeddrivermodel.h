@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef USC_PRINTERS_RECOMMENDEDDRIVERMODEL_H
+#define USC_PRINTERS_RECOMMENDEDDRIVERMODEL_H
+
+#include "printers_global.h"
+
+#include "models/drivermodel.h"
+#include "structs.h"
+
+#include <QAbstractListModel>
+#include <QModelIndex>
+#include <QObject>
+#include <QPointer>
+#include <QVariant>
+
+/* The drivers of a DriverModel that suit one device, best first. Follows
+the DriverModel as drivers are loaded. */
+class PRINTERS_DECL_EXPORT RecommendedDriverModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+public:
+    explicit RecommendedDriverModel(DriverModel *drivers,
+                                    const QString &deviceId,
+                                    const QString &makeModel,
+                                    QObject *parent = Q_NULLPTR);
+    ~RecommendedDriverModel();
+
+    virtual int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    virtual QHash<int, QByteArray> roleNames() const override;
+
+    int count() const;
+
+private Q_SLOTS:
+    void update();
+
+Q_SIGNALS:
+    void countChanged();
+
+private:
+    QPointer<DriverModel> m_source;
+    const QString m_deviceId;
+    const QString m_makeModel;
+    QList<PrinterDriver> m_drivers;
+};
+
+#endif // USC_PRINTERS_RECOMMENDEDDRIVERMODEL_H
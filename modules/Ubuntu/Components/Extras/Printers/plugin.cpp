@@ -17,6 +17,7 @@
 #include "plugin.h"
 
 #include "enums.h"
+#include "backend/capabilitycache.h"
 #include "i18n.h"
 #include "structs.h"
 
@@ -55,6 +56,10 @@ void UbuntuComponentsExtrasPrintersPlugin::registerTypes(const char *uri)
     qmlRegisterUncreatableType<PrinterEnum>(uri, 0, 1, "PrinterEnum", "Is an enum");
     qRegisterMetaType<QList<PrinterDriver>>("QList<PrinterDriver>");
     qRegisterMetaType<QSharedPointer<PrinterJob>>("QSharedPointer<PrinterJob>");
+    qRegisterMetaType<QList<QSharedPointer<PrinterJob>>>("QList<QSharedPointer<PrinterJob>>");
     qRegisterMetaType<QList<QSharedPointer<Printer>>>("QList<QSharedPointer<Printer>>");
     qRegisterMetaType<Device>("Device");
+    qRegisterMetaType<QList<JobAttributes>>("QList<JobAttributes>");
+    qRegisterMetaType<PrinterStateAttributes>("PrinterStateAttributes");
+    qRegisterMetaType<PrinterCapabilities>("PrinterCapabilities");
 }
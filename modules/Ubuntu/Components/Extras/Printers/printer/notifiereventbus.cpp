@@ -0,0 +1,332 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "backend/backend.h"
+#include "printer/notifiereventbus.h"
+
+NotifierEventBus::PrinterEvent NotifierEventBus::makePrinterEvent(
+    const QString &text, const QString &printerUri,
+    const QString &printerName, uint printerState,
+    const QString &printerStateReason, bool acceptingJobs)
+{
+    NotifierEventBus::PrinterEvent event;
+    event.text = text;
+    event.printerUri = printerUri;
+    event.printerName = printerName;
+    event.printerState = printerState;
+    event.printerStateReason = printerStateReason;
+    event.acceptingJobs = acceptingJobs;
+    return event;
+}
+
+NotifierEventBus::NotifierEventBus(const int minLatency, const int maxLatency,
+                                   QObject *parent)
+    : QObject(parent)
+    , m_minLatency(minLatency)
+    , m_maxLatency(maxLatency)
+{
+    m_clock.start();
+    m_timer.setSingleShot(true);
+    connect(&m_timer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+NotifierEventBus::~NotifierEventBus()
+{
+}
+
+void NotifierEventBus::connectTo(PrinterBackend *backend)
+{
+    QObject::connect(backend, &PrinterBackend::printerAdded,
+                     this, &NotifierEventBus::onPrinterAdded);
+    QObject::connect(backend, &PrinterBackend::printerModified,
+                     this, &NotifierEventBus::onPrinterModified);
+    QObject::connect(backend, &PrinterBackend::printerStateChanged,
+                     this, &NotifierEventBus::onPrinterStateChanged);
+    QObject::connect(backend, &PrinterBackend::printerDeleted,
+                     this, &NotifierEventBus::onPrinterDeleted);
+    QObject::connect(backend, &PrinterBackend::jobCreated,
+                     this, &NotifierEventBus::onJobCreated);
+    QObject::connect(backend, &PrinterBackend::jobState,
+                     this, &NotifierEventBus::onJobState);
+    QObject::connect(backend, &PrinterBackend::jobCompleted,
+                     this, &NotifierEventBus::onJobCompleted);
+}
+
+int NotifierEventBus::minLatency() const
+{
+    return m_minLatency;
+}
+
+void NotifierEventBus::setMinLatency(const int minLatency)
+{
+    m_minLatency = minLatency;
+}
+
+int NotifierEventBus::maxLatency() const
+{
+    return m_maxLatency;
+}
+
+void NotifierEventBus::setMaxLatency(const int maxLatency)
+{
+    m_maxLatency = maxLatency;
+}
+
+bool NotifierEventBus::hasPending() const
+{
+    return !m_printers.isEmpty() || !m_jobs.isEmpty();
+}
+
+NotifierEventBus::Stats NotifierEventBus::stats() const
+{
+    return m_stats;
+}
+
+/* Nothing is waiting, and the last updates were dispatched long enough ago
+that dispatching another one now does not make a burst. */
+bool NotifierEventBus::isIdle() const
+{
+    return !hasPending() && (m_lastDispatch < 0
+        || m_clock.elapsed() - m_lastDispatch >= m_minLatency);
+}
+
+void NotifierEventBus::schedule()
+{
+    qint64 now = m_clock.elapsed();
+    if (m_firstPending < 0) {
+        m_firstPending = now;
+    }
+
+    qint64 delay = qMin<qint64>(m_minLatency,
+                                m_firstPending + m_maxLatency - now);
+    m_timer.start(qMax<qint64>(0, delay));
+}
+
+void NotifierEventBus::flush()
+{
+    m_timer.stop();
+    m_firstPending = -1;
+    m_lastDispatch = m_clock.elapsed();
+
+    // Take the events first, as the receivers may send more.
+    QList<QString> printerOrder = m_printerOrder;
+    QHash<QString, PendingPrinter> printers = m_printers;
+    QList<JobKey> jobOrder = m_jobOrder;
+    QHash<JobKey, JobEvent> jobs = m_jobs;
+    m_printerOrder.clear();
+    m_printers.clear();
+    m_jobOrder.clear();
+    m_jobs.clear();
+
+    Q_FOREACH(const QString &printerName, printerOrder) {
+        dispatchPrinter(printerName, printers.value(printerName));
+    }
+    Q_FOREACH(const JobKey &key, jobOrder) {
+        dispatchJob(jobs.value(key));
+    }
+}
+
+void NotifierEventBus::dispatchPrinter(const QString &printerName,
+                                       const PendingPrinter &pending)
+{
+    if (pending.modified) {
+        const PrinterEvent &e = pending.modifiedEvent;
+        m_stats.dispatched++;
+        Q_EMIT printerModified(e.text, e.printerUri, e.printerName,
+                               e.printerState, e.printerStateReason,
+                               e.acceptingJobs);
+    }
+    if (pending.stateChanged) {
+        const PrinterEvent &e = pending.stateEvent;
+        m_stats.dispatched++;
+        Q_EMIT printerStateChanged(e.text, e.printerUri, e.printerName,
+                                   e.printerState, e.printerStateReason,
+                                   e.acceptingJobs);
+    }
+    Q_EMIT printerChanged(printerName);
+}
+
+void NotifierEventBus::dispatchJob(const JobEvent &event)
+{
+    const PrinterEvent &p = event.printer;
+    m_stats.dispatched++;
+    Q_EMIT jobState(p.text, p.printerUri, p.printerName, p.printerState,
+                    p.printerStateReason, p.acceptingJobs, event.jobId,
+                    event.jobState, event.jobStateReason, event.jobName,
+                    event.jobImpressionsCompleted);
+}
+
+void NotifierEventBus::onPrinterAdded(
+    const QString &text, const QString &printerUri,
+    const QString &printerName, uint printerState,
+    const QString &printerStateReason, bool acceptingJobs)
+{
+    m_stats.received++;
+    m_stats.dispatched++;
+    Q_EMIT printerAdded(text, printerUri, printerName, printerState,
+                        printerStateReason, acceptingJobs);
+}
+
+void NotifierEventBus::onPrinterModified(
+    const QString &text, const QString &printerUri,
+    const QString &printerName, uint printerState,
+    const QString &printerStateReason, bool acceptingJobs)
+{
+    m_stats.received++;
+
+    PendingPrinter pending;
+    pending.modified = true;
+    pending.modifiedEvent = makePrinterEvent(text, printerUri, printerName,
+                                             printerState, printerStateReason,
+                                             acceptingJobs);
+
+    if (isIdle()) {
+        m_lastDispatch = m_clock.elapsed();
+        dispatchPrinter(printerName, pending);
+        return;
+    }
+
+    if (!m_printers.contains(printerName)) {
+        m_printerOrder << printerName;
+    }
+    PendingPrinter &entry = m_printers[printerName];
+    if (entry.modified) {
+        m_stats.coalesced++;
+    }
+    entry.modified = true;
+    entry.modifiedEvent = pending.modifiedEvent;
+    schedule();
+}
+
+void NotifierEventBus::onPrinterStateChanged(
+    const QString &text, const QString &printerUri,
+    const QString &printerName, uint printerState,
+    const QString &printerStateReason, bool acceptingJobs)
+{
+    m_stats.received++;
+
+    PendingPrinter pending;
+    pending.stateChanged = true;
+    pending.stateEvent = makePrinterEvent(text, printerUri, printerName,
+                                          printerState, printerStateReason,
+                                          acceptingJobs);
+
+    if (isIdle()) {
+        m_lastDispatch = m_clock.elapsed();
+        dispatchPrinter(printerName, pending);
+        return;
+    }
+
+    if (!m_printers.contains(printerName)) {
+        m_printerOrder << printerName;
+    }
+    PendingPrinter &entry = m_printers[printerName];
+    if (entry.stateChanged) {
+        m_stats.coalesced++;
+    }
+    entry.stateChanged = true;
+    entry.stateEvent = pending.stateEvent;
+    schedule();
+}
+
+void NotifierEventBus::onPrinterDeleted(
+    const QString &text, const QString &printerUri,
+    const QString &printerName, uint printerState,
+    const QString &printerStateReason, bool acceptingJobs)
+{
+    m_stats.received++;
+
+    if (m_printers.contains(printerName)) {
+        PendingPrinter pending = m_printers.take(printerName);
+        m_printerOrder.removeOne(printerName);
+        m_stats.dropped += (pending.modified ? 1 : 0)
+            + (pending.stateChanged ? 1 : 0);
+    }
+
+    m_stats.dispatched++;
+    Q_EMIT printerDeleted(text, printerUri, printerName, printerState,
+                          printerStateReason, acceptingJobs);
+}
+
+void NotifierEventBus::onJobCreated(
+    const QString &text, const QString &printerUri,
+    const QString &printerName, uint printerState,
+    const QString &printerStateReason, bool acceptingJobs, uint jobId,
+    uint jobState, const QString &jobStateReason, const QString &jobName,
+    uint jobImpressionsCompleted)
+{
+    m_stats.received++;
+    m_stats.dispatched++;
+    Q_EMIT jobCreated(text, printerUri, printerName, printerState,
+                      printerStateReason, acceptingJobs, jobId, jobState,
+                      jobStateReason, jobName, jobImpressionsCompleted);
+}
+
+void NotifierEventBus::onJobState(
+    const QString &text, const QString &printerUri,
+    const QString &printerName, uint printerState,
+    const QString &printerStateReason, bool acceptingJobs, uint jobId,
+    uint jobState, const QString &jobStateReason, const QString &jobName,
+    uint jobImpressionsCompleted)
+{
+    m_stats.received++;
+
+    JobEvent event;
+    event.printer = makePrinterEvent(text, printerUri, printerName,
+                                     printerState, printerStateReason,
+                                     acceptingJobs);
+    event.jobId = jobId;
+    event.jobState = jobState;
+    event.jobStateReason = jobStateReason;
+    event.jobName = jobName;
+    event.jobImpressionsCompleted = jobImpressionsCompleted;
+
+    if (isIdle()) {
+        m_lastDispatch = m_clock.elapsed();
+        dispatchJob(event);
+        return;
+    }
+
+    JobKey key(printerName, jobId);
+    if (m_jobs.contains(key)) {
+        m_stats.coalesced++;
+    } else {
+        m_jobOrder << key;
+    }
+    m_jobs.insert(key, event);
+    schedule();
+}
+
+void NotifierEventBus::onJobCompleted(
+    const QString &text, const QString &printerUri,
+    const QString &printerName, uint printerState,
+    const QString &printerStateReason, bool acceptingJobs, uint jobId,
+    uint jobState, const QString &jobStateReason, const QString &jobName,
+    uint jobImpressionsCompleted)
+{
+    m_stats.received++;
+
+    JobKey key(printerName, jobId);
+    if (m_jobs.remove(key) > 0) {
+        m_jobOrder.removeOne(key);
+        m_stats.dropped++;
+    }
+
+    m_stats.dispatched++;
+    Q_EMIT jobCompleted(text, printerUri, printerName, printerState,
+                        printerStateReason, acceptingJobs, jobId, jobState,
+                        jobStateReason, jobName, jobImpressionsCompleted);
+}
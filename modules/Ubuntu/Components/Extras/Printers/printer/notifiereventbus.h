@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USC_PRINTERS_NOTIFIEREVENTBUS_H
+#define USC_PRINTERS_NOTIFIEREVENTBUS_H
+
+#include "printers_global.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPair>
+#include <QString>
+#include <QTimer>
+
+class PrinterBackend;
+
+/* Sits between the CUPS notifier signals of a backend and a consumer, and
+merges bursts of them.
+
+Events are keyed by the printer, or by the printer and job id. Updates,
+which are printer modified, printer state changed and job state, are
+merged per key into the latest one. An update arriving while the bus is
+idle is dispatched at once; later ones wait until no update arrived for
+minLatency milliseconds, but no longer than maxLatency milliseconds after
+the first one waiting. Printers added and deleted, and jobs created and
+completed, are always dispatched at once; a deletion or completion drops
+the updates waiting for its printer or job. */
+class PRINTERS_DECL_EXPORT NotifierEventBus : public QObject
+{
+    Q_OBJECT
+public:
+    struct Stats
+    {
+        int received = 0;
+        int dispatched = 0;
+        int coalesced = 0; // Updates replaced by a later one.
+        int dropped = 0; // Updates made moot by a deletion or completion.
+    };
+
+    explicit NotifierEventBus(const int minLatency = 500,
+                              const int maxLatency = 2000,
+                              QObject *parent = Q_NULLPTR);
+    ~NotifierEventBus();
+
+    // Routes all the notifier signals of the backend through this bus.
+    void connectTo(PrinterBackend *backend);
+
+    int minLatency() const;
+    void setMinLatency(const int minLatency);
+    int maxLatency() const;
+    void setMaxLatency(const int maxLatency);
+
+    bool hasPending() const;
+    Stats stats() const;
+
+public Q_SLOTS:
+    // Dispatches the waiting updates now.
+    void flush();
+
+    void onPrinterAdded(
+        const QString &text, const QString &printerUri,
+        const QString &printerName, uint printerState,
+        const QString &printerStateReason, bool acceptingJobs
+    );
+    void onPrinterModified(
+        const QString &text, const QString &printerUri,
+        const QString &printerName, uint printerState,
+        const QString &printerStateReason, bool acceptingJobs
+    );
+    void onPrinterStateChanged(
+        const QString &text, const QString &printerUri,
+        const QString &printerName, uint printerState,
+        const QString &printerStateReason, bool acceptingJobs
+    );
+    void onPrinterDeleted(
+        const QString &text, const QString &printerUri,
+        const QString &printerName, uint printerState,
+        const QString &printerStateReason, bool acceptingJobs
+    );
+    void onJobCreated(
+        const QString &text, const QString &printerUri,
+        const QString &printerName, uint printerState,
+        const QString &printerStateReason, bool acceptingJobs, uint jobId,
+        uint jobState, const QString &jobStateReason, const QString &jobName,
+        uint jobImpressionsCompleted
+    );
+    void onJobState(
+        const QString &text, const QString &printerUri,
+        const QString &printerName, uint printerState,
+        const QString &printerStateReason, bool acceptingJobs, uint jobId,
+        uint jobState, const QString &jobStateReason, const QString &jobName,
+        uint jobImpressionsCompleted
+    );
+    void onJobCompleted(
+        const QString &text, const QString &printerUri,
+        const QString &printerName, uint printerState,
+        const QString &printerStateReason, bool acceptingJobs, uint jobId,
+        uint jobState, const QString &jobStateReason, const QString &jobName,
+        uint jobImpressionsCompleted
+    );
+
+Q_SIGNALS:
+    void printerAdded(
+        const QString &text, const QString &printerUri,
+        const QString &printerName, uint printerState,
+        const QString &printerStateReason, bool acceptingJobs
+    );
+    void printerModified(
+        const QString &text, const QString &printerUri,
+        const QString &printerName, uint printerState,
+        const QString &printerStateReason, bool acceptingJobs
+    );
+    void printerStateChanged(
+        const QString &text, const QString &printerUri,
+        const QString &printerName, uint printerState,
+        const QString &printerStateReason, bool acceptingJobs
+    );
+    void printerDeleted(
+        const QString &text, const QString &printerUri,
+        const QString &printerName, uint printerState,
+        const QString &printerStateReason, bool acceptingJobs
+    );
+    void jobCreated(
+        const QString &text, const QString &printerUri,
+        const QString &printerName, uint printerState,
+        const QString &printerStateReason, bool acceptingJobs, uint jobId,
+        uint jobState, const QString &jobStateReason, const QString &jobName,
+        uint jobImpressionsCompleted
+    );
+    void jobState(
+        const QString &text, const QString &printerUri,
+        const QString &printerName, uint printerState,
+        const QString &printerStateReason, bool acceptingJobs, uint jobId,
+        uint jobState, const QString &jobStateReason, const QString &jobName,
+        uint jobImpressionsCompleted
+    );
+    void jobCompleted(
+        const QString &text, const QString &printerUri,
+        const QString &printerName, uint printerState,
+        const QString &printerStateReason, bool acceptingJobs, uint jobId,
+        uint jobState, const QString &jobStateReason, const QString &jobName,
+        uint jobImpressionsCompleted
+    );
+
+    // Once per dispatch of printerModified and/or printerStateChanged.
+    void printerChanged(const QString &printerName);
+
+private:
+    struct PrinterEvent
+    {
+        QString text;
+        QString printerUri;
+        QString printerName;
+        uint printerState = 0;
+        QString printerStateReason;
+        bool acceptingJobs = false;
+    };
+    struct JobEvent
+    {
+        PrinterEvent printer;
+        uint jobId = 0;
+        uint jobState = 0;
+        QString jobStateReason;
+        QString jobName;
+        uint jobImpressionsCompleted = 0;
+    };
+    struct PendingPrinter
+    {
+        bool modified = false;
+        PrinterEvent modifiedEvent;
+        bool stateChanged = false;
+        PrinterEvent stateEvent;
+    };
+    typedef QPair<QString, uint> JobKey;
+
+    static PrinterEvent makePrinterEvent(
+        const QString &text, const QString &printerUri,
+        const QString &printerName, uint printerState,
+        const QString &printerStateReason, bool acceptingJobs
+    );
+    bool isIdle() const;
+    void schedule();
+    void dispatchPrinter(const QString &printerName,
+                         const PendingPrinter &pending);
+    void dispatchJob(const JobEvent &event);
+
+    int m_minLatency;
+    int m_maxLatency;
+    QElapsedTimer m_clock;
+    qint64 m_firstPending = -1;
+    qint64 m_lastDispatch = -1;
+    QTimer m_timer;
+
+    QList<QString> m_printerOrder;
+    QHash<QString, PendingPrinter> m_printers;
+    QList<JobKey> m_jobOrder;
+    QHash<JobKey, JobEvent> m_jobs;
+
+    Stats m_stats;
+};
+
+#endif // USC_PRINTERS_NOTIFIEREVENTBUS_H
@@ -27,13 +27,17 @@ Printer::Printer(PrinterBackend *backend, QObject *parent)
     : QObject(parent)
     , m_backend(backend)
 {
-    loadAttributes();
+    for (int i = 0; i < AttributeGroupCount; i++) {
+        m_loadStates[i] = LoadState::NotLoaded;
+    }
+
+    // Unlike the attributes, this is a single small request.
+    m_configChangeTime = m_backend->configChangeTime();
 
     m_jobs.setParent(this);
     m_jobs.filterOnPrinterName(name());
 
-    QObject::connect(m_backend, &PrinterBackend::printerStateChanged,
-                     this, &Printer::onPrinterStateChanged);
+    connectBackend();
 }
 
 Printer::~Printer()
@@ -102,52 +106,152 @@ void Printer::updateShared(const QMap<QString, QVariant> &serverAttrs)
     m_shared = serverAttrs.value(QStringLiteral("Shared")).toBool();
 }
 
-void Printer::loadAttributes()
+void Printer::connectBackend()
+{
+    QObject::connect(m_backend, &PrinterBackend::printerStateChanged,
+                     this, &Printer::onPrinterStateChanged);
+    QObject::connect(m_backend, &PrinterBackend::printerOptionsLoaded,
+                     this, &Printer::onPrinterOptionsLoaded);
+}
+
+QStringList Printer::groupOptions(const AttributeGroup group)
+{
+    switch (group) {
+    case StateAttributes:
+        return QStringList({
+            QStringLiteral("AcceptJobs"),
+            QStringLiteral("StateMessage"),
+        });
+    case Capabilities:
+        return QStringList({
+            QStringLiteral("DefaultColorModel"),
+            QStringLiteral("SupportedColorModels"),
+            QStringLiteral("DefaultPrintQuality"),
+            QStringLiteral("SupportedPrintQualities"),
+        });
+    case ExtendedAttributes:
+        return QStringList({
+            QStringLiteral("DeviceUri"),
+            QStringLiteral("Copies"),
+            QStringLiteral("Shared"),
+        });
+    default:
+        return QStringList();
+    }
+}
+
+bool Printer::isLoaded(const AttributeGroup group) const
 {
-    auto opts = QStringList({
-        QStringLiteral("AcceptJobs"),
-        QStringLiteral("DefaultColorModel"),
-        QStringLiteral("SupportedColorModels"),
-        QStringLiteral("DefaultPrintQuality"),
-        QStringLiteral("SupportedPrintQualities"),
-        QStringLiteral("StateMessage"),
-        QStringLiteral("DeviceUri"),
-        QStringLiteral("Copies"),
-        QStringLiteral("Shared"),
-    });
-    auto result = m_backend->printerGetOptions(name(), opts);
+    return m_loadStates[group] == LoadState::Loaded;
+}
 
-    updateAcceptJobs(result);
-    updateColorModel(result);
-    updatePrintQualities(result);
-    updateLastMessage(result);
-    updateDeviceUri(result);
-    updateCopies(result);
-    updateShared(result);
+void Printer::ensureLoaded(const AttributeGroup group) const
+{
+    if (m_loadStates[group] == LoadState::NotLoaded) {
+        const_cast<Printer*>(this)->load(group);
+    }
+}
+
+void Printer::load(const AttributeGroup group)
+{
+    m_loadStates[group] = LoadState::Loading;
+
+    m_requesting = true;
+    m_backend->requestPrinterOptions(name(), groupOptions(group));
+    m_requesting = false;
+}
+
+void Printer::refreshBackend()
+{
+    m_backend->refresh();
+
+    // The backend has dropped the capabilities, so they load again.
+    if (m_loadStates[Capabilities] != LoadState::NotLoaded) {
+        m_loadStates[Capabilities] = LoadState::NotLoaded;
+        load(Capabilities);
+    }
+}
+
+void Printer::onPrinterOptionsLoaded(const QString &printerName,
+                                     const QStringList &options,
+                                     const QMap<QString, QVariant> &values)
+{
+    if (printerName != name()) {
+        return;
+    }
+
+    // Whoever asked already has the attributes if they loaded right away.
+    bool notify = !m_requesting;
+
+    for (int i = 0; i < AttributeGroupCount; i++) {
+        auto group = static_cast<AttributeGroup>(i);
+        if (groupOptions(group) != options) {
+            continue;
+        }
+
+        m_loadStates[group] = LoadState::Loaded;
+
+        switch (group) {
+        case StateAttributes:
+            updateAcceptJobs(values);
+            updateLastMessage(values);
+            if (notify) {
+                Q_EMIT stateAttributesChanged();
+            }
+            break;
+        case Capabilities:
+            updateColorModel(values);
+            updatePrintQualities(values);
+            if (notify) {
+                Q_EMIT capabilitiesChanged();
+            }
+            break;
+        case ExtendedAttributes:
+            updateDeviceUri(values);
+            updateCopies(values);
+            updateShared(values);
+            if (notify) {
+                Q_EMIT extendedAttributesChanged();
+            }
+            break;
+        default:
+            break;
+        }
+        return;
+    }
 }
 
 ColorModel Printer::defaultColorModel() const
 {
+    ensureLoaded(Capabilities);
     return m_defaultColorModel;
 }
 
 QList<ColorModel> Printer::supportedColorModels() const
 {
+    ensureLoaded(Capabilities);
     return m_supportedColorModels;
 }
 
 PrintQuality Printer::defaultPrintQuality() const
 {
+    ensureLoaded(Capabilities);
     return m_defaultPrintQuality;
 }
 
 QList<PrintQuality> Printer::supportedPrintQualities() const
 {
+    ensureLoaded(Capabilities);
     return m_supportedPrintQualities;
 }
 
 QList<PrinterEnum::DuplexMode> Printer::supportedDuplexModes() const
 {
+    // The backend has these once the capabilities are loaded.
+    ensureLoaded(Capabilities);
+    if (!isLoaded(Capabilities)) {
+        return QList<PrinterEnum::DuplexMode>();
+    }
     return m_backend->supportedDuplexModes();
 }
 
@@ -162,6 +266,10 @@ QStringList Printer::supportedDuplexStrings() const
 
 PrinterEnum::DuplexMode Printer::defaultDuplexMode() const
 {
+    ensureLoaded(Capabilities);
+    if (!isLoaded(Capabilities)) {
+        return PrinterEnum::DuplexMode::DuplexNone;
+    }
     return m_backend->defaultDuplexMode();
 }
 
@@ -180,6 +288,7 @@ QString Printer::name() const
 
 QString Printer::deviceUri() const
 {
+    ensureLoaded(ExtendedAttributes);
     return m_deviceUri;
 }
 
@@ -200,11 +309,19 @@ QString Printer::location() const
 
 QPageSize Printer::defaultPageSize() const
 {
+    ensureLoaded(Capabilities);
+    if (!isLoaded(Capabilities)) {
+        return QPageSize();
+    }
     return m_backend->defaultPageSize();
 }
 
 QList<QPageSize> Printer::supportedPageSizes() const
 {
+    ensureLoaded(Capabilities);
+    if (!isLoaded(Capabilities)) {
+        return QList<QPageSize>();
+    }
     return m_backend->supportedPageSizes();
 }
 
@@ -230,11 +347,13 @@ PrinterEnum::State Printer::state() const
 
 bool Printer::shared() const
 {
+    ensureLoaded(ExtendedAttributes);
     return m_shared;
 }
 
 bool Printer::acceptJobs() const
 {
+    ensureLoaded(StateAttributes);
     return m_acceptJobs;
 }
 
@@ -255,9 +374,20 @@ PrinterEnum::PrinterType Printer::type() const
 
 int Printer::copies() const
 {
+    ensureLoaded(ExtendedAttributes);
     return m_copies;
 }
 
+qint64 Printer::configChangeTime() const
+{
+    return m_configChangeTime;
+}
+
+qint64 Printer::stateChangeTime() const
+{
+    return m_stateChangeTime;
+}
+
 void Printer::setDefaultColorModel(const ColorModel &colorModel)
 {
     if (defaultColorModel() == colorModel) {
@@ -286,7 +416,7 @@ void Printer::setDefaultDuplexMode(const PrinterEnum::DuplexMode &duplexMode)
         return;
     }
 
-    if (!m_backend->supportedDuplexModes().contains(duplexMode)) {
+    if (!supportedDuplexModes().contains(duplexMode)) {
         qWarning() << Q_FUNC_INFO << "duplex mode not supported" << duplexMode;
         return;
     }
@@ -302,13 +432,15 @@ void Printer::setEnabled(const bool enabled)
         if (!reply.isEmpty()) {
             qWarning() << Q_FUNC_INFO << "failed to set enabled:" << reply;
         }
-        m_backend->refresh();
+        refreshBackend();
     }
 }
 
 void Printer::setAcceptJobs(const bool accepting)
 {
-    if (this->acceptJobs() != accepting) {
+    // Not compared with the default of an attribute that is still loading.
+    ensureLoaded(StateAttributes);
+    if (!isLoaded(StateAttributes) || this->acceptJobs() != accepting) {
         QString reply = m_backend->printerSetAcceptJobs(name(), accepting);
         if (!reply.isEmpty()) {
             qWarning() << Q_FUNC_INFO << "failed to set accepting:" << reply;
@@ -318,7 +450,8 @@ void Printer::setAcceptJobs(const bool accepting)
 
 void Printer::setShared(const bool shared)
 {
-    if (this->shared() != shared) {
+    ensureLoaded(ExtendedAttributes);
+    if (!isLoaded(ExtendedAttributes) || this->shared() != shared) {
         QString reply = m_backend->printerSetShared(name(), shared);
         if (!reply.isEmpty()) {
             qWarning() << Q_FUNC_INFO << "failed to set shared:" << reply;
@@ -347,7 +480,7 @@ void Printer::setDefaultPageSize(const QPageSize &pageSize)
         return;
     }
 
-    if (!m_backend->supportedPageSizes().contains(pageSize)) {
+    if (!supportedPageSizes().contains(pageSize)) {
         qWarning() << Q_FUNC_INFO << "pagesize not supported.";
         return;
     }
@@ -359,12 +492,13 @@ void Printer::setDefaultPageSize(const QPageSize &pageSize)
 
     QStringList vals({pageSize.key()});
     m_backend->printerAddOption(name(), "PageSize", vals);
-    m_backend->refresh();
+    refreshBackend();
 }
 
 void Printer::setCopies(const int &copies)
 {
-    if (this->copies() == copies) {
+    ensureLoaded(ExtendedAttributes);
+    if (isLoaded(ExtendedAttributes) && this->copies() == copies) {
         return;
     }
 
@@ -373,6 +507,7 @@ void Printer::setCopies(const int &copies)
 
 QString Printer::lastMessage() const
 {
+    ensureLoaded(StateAttributes);
     return m_stateMessage;
 }
 
@@ -385,41 +520,105 @@ QAbstractItemModel* Printer::jobs()
 
 bool Printer::deepCompare(QSharedPointer<Printer> other) const
 {
-    // Return true if they are the same
-    return defaultColorModel() == other->defaultColorModel()
-            && defaultPrintQuality() == other->defaultPrintQuality()
+    /* Return true if they are the same. Only the attribute groups loaded by
+    both printers are compared, and comparing never loads any; a changed
+    configuration tells that those loaded here may be out of date. */
+    bool same = m_configChangeTime == other->m_configChangeTime
             && description() == other->description()
-            && defaultDuplexMode() == other->defaultDuplexMode()
-            && defaultPageSize() == other->defaultPageSize()
             && type() == other->type()
-            && acceptJobs() == other->acceptJobs()
             && enabled() == other->enabled()
             && state() == other->state()
-            && lastMessage() == other->lastMessage()
-            && deviceUri() == other->deviceUri()
-            && shared() == other->shared()
-            && copies() == other->copies()
             && isRemote() == other->isRemote();
+
+    if (same && isLoaded(StateAttributes) && other->isLoaded(StateAttributes)) {
+        same = m_acceptJobs == other->m_acceptJobs
+                && m_stateMessage == other->m_stateMessage;
+    }
+
+    if (same && isLoaded(Capabilities) && other->isLoaded(Capabilities)) {
+        same = m_defaultColorModel == other->m_defaultColorModel
+                && m_defaultPrintQuality == other->m_defaultPrintQuality
+                && defaultDuplexMode() == other->defaultDuplexMode()
+                && defaultPageSize() == other->defaultPageSize();
+    }
+
+    if (same && isLoaded(ExtendedAttributes) && other->isLoaded(ExtendedAttributes)) {
+        same = m_deviceUri == other->m_deviceUri
+                && m_shared == other->m_shared
+                && m_copies == other->m_copies;
+    }
+    return same;
 }
 
 void Printer::updateFrom(QSharedPointer<Printer> other)
 {
     PrinterBackend *tmp = m_backend;
 
+    // Attributes loading in the background follow their backend.
+    QObject::disconnect(m_backend, Q_NULLPTR, this, Q_NULLPTR);
+    QObject::disconnect(other->m_backend, Q_NULLPTR, other.data(), Q_NULLPTR);
+
     // Copy values from other printer which has been loaded in another thread
-    // Note: do not use loadAttributes otherwise can cause UI block
-    m_acceptJobs = other->m_acceptJobs;
+    // Note: do not load attributes here otherwise can cause UI block
     m_backend = other->m_backend;
-    m_copies = other->m_copies;
-    m_defaultColorModel = other->m_defaultColorModel;
-    m_defaultPrintQuality = other->m_defaultPrintQuality;
-    m_deviceUri = other->m_deviceUri;
-    m_shared = other->m_shared;
-    m_stateMessage = other->m_stateMessage;
-    m_supportedColorModels = other->m_supportedColorModels;
-    m_supportedPrintQualities = other->m_supportedPrintQualities;
+    m_configChangeTime = other->m_configChangeTime;
+    m_stateChangeTime = other->m_stateChangeTime;
 
     other->m_backend = tmp;
+
+    connectBackend();
+    other->connectBackend();
+
+    /* Take the attribute groups the other printer has, and load again those
+    that were asked for here but not there. */
+    QList<AttributeGroup> reload;
+    for (int i = 0; i < AttributeGroupCount; i++) {
+        auto group = static_cast<AttributeGroup>(i);
+        LoadState otherState = other->m_loadStates[group];
+        other->m_loadStates[group] = LoadState::NotLoaded;
+
+        if (otherState == LoadState::Loaded) {
+            switch (group) {
+            case StateAttributes:
+                m_acceptJobs = other->m_acceptJobs;
+                m_stateMessage = other->m_stateMessage;
+                break;
+            case Capabilities:
+                m_defaultColorModel = other->m_defaultColorModel;
+                m_defaultPrintQuality = other->m_defaultPrintQuality;
+                m_supportedColorModels = other->m_supportedColorModels;
+                m_supportedPrintQualities = other->m_supportedPrintQualities;
+                break;
+            case ExtendedAttributes:
+                m_copies = other->m_copies;
+                m_deviceUri = other->m_deviceUri;
+                m_shared = other->m_shared;
+                break;
+            default:
+                break;
+            }
+            m_loadStates[group] = LoadState::Loaded;
+        } else if (otherState == LoadState::Loading) {
+            // Arrives here, through the backend taken over.
+            m_loadStates[group] = LoadState::Loading;
+        } else if (m_loadStates[group] != LoadState::NotLoaded) {
+            m_loadStates[group] = LoadState::NotLoaded;
+            reload << group;
+        }
+    }
+
+    Q_FOREACH(const AttributeGroup group, reload) {
+        load(group);
+    }
+}
+
+void Printer::updateState(const PrinterStateAttributes &attributes)
+{
+    m_acceptJobs = attributes.acceptJobs;
+    m_stateChangeTime = attributes.stateChangeTime;
+    m_stateMessage = attributes.stateMessage;
+    m_loadStates[StateAttributes] = LoadState::Loaded;
+    m_backend->setStateInternal(attributes.state);
 }
 
 void Printer::onPrinterStateChanged(
@@ -28,16 +28,28 @@
 #include <QObject>
 #include <QPageSize>
 #include <QList>
+#include <QMap>
 #include <QScopedPointer>
 #include <QSortFilterProxyModel>
 #include <QString>
 #include <QStringList>
+#include <QVariant>
 
 class PrinterBackend;
 class PrinterJob;
+/* The attributes that cost a request to cupsd or parsing the PPD are loaded
+in groups, when one of the group is first asked for, so that listing the
+printers does not pay for what is never shown. Backends that talk to cupsd
+load them in the background; until then the getters return defaults, and
+the group's change signal is emitted once the attributes have arrived. */
 class PRINTERS_DECL_EXPORT Printer : public QObject
 {
     Q_OBJECT
+    Q_PROPERTY(bool acceptJobs READ acceptJobs NOTIFY stateAttributesChanged)
+    Q_PROPERTY(QString lastMessage READ lastMessage NOTIFY stateAttributesChanged)
+    Q_PROPERTY(QString deviceUri READ deviceUri NOTIFY extendedAttributesChanged)
+    Q_PROPERTY(int copies READ copies NOTIFY extendedAttributesChanged)
+    Q_PROPERTY(bool shared READ shared NOTIFY extendedAttributesChanged)
 public:
     explicit Printer(PrinterBackend *backend, QObject *parent = nullptr);
     ~Printer();
@@ -67,6 +79,8 @@ public:
     QString lastMessage() const;
     QAbstractItemModel* jobs();
     int copies() const;
+    qint64 configChangeTime() const;
+    qint64 stateChangeTime() const;
 
     PrinterEnum::PrinterType type() const;
 
@@ -83,7 +97,17 @@ public:
 
     bool deepCompare(QSharedPointer<Printer> other) const;
     void updateFrom(QSharedPointer<Printer> other);
-
+    /* Patches in the state, without loading anything else again. Does not
+    emit stateAttributesChanged, the caller knows what it changed. */
+    void updateState(const PrinterStateAttributes &attributes);
+
+Q_SIGNALS:
+    // Acceptance of jobs and the state message.
+    void stateAttributesChanged();
+    // Color models, print qualities, page sizes and duplex modes.
+    void capabilitiesChanged();
+    // Device URI, copies and sharing.
+    void extendedAttributesChanged();
 
 public Q_SLOTS:
     int printFile(const QString &filepath, const PrinterJob *options);
@@ -94,8 +118,34 @@ private Q_SLOTS:
         const QString &printerName, uint printerState,
         const QString &printerStateReason, bool acceptingJobs
     );
+    void onPrinterOptionsLoaded(const QString &printerName,
+                                const QStringList &options,
+                                const QMap<QString, QVariant> &values);
 
 private:
+    enum AttributeGroup
+    {
+        StateAttributes = 0,
+        Capabilities,
+        ExtendedAttributes,
+        AttributeGroupCount,
+    };
+
+    enum class LoadState
+    {
+        NotLoaded,
+        Loading,
+        Loaded,
+    };
+
+    static QStringList groupOptions(const AttributeGroup group);
+    bool isLoaded(const AttributeGroup group) const;
+    // Getters are const, but may have to load what they return.
+    void ensureLoaded(const AttributeGroup group) const;
+    void load(const AttributeGroup group);
+    void refreshBackend();
+    void connectBackend();
+
     void updateAcceptJobs(const QMap<QString, QVariant> &serverAttrs);
     void updateColorModel(const QMap<QString, QVariant> &serverAttrs);
     void updatePrintQualities(const QMap<QString, QVariant> &serverAttrs);
@@ -103,7 +153,6 @@ private:
     void updateDeviceUri(const QMap<QString, QVariant> &serverAttrs);
     void updateCopies(const QMap<QString, QVariant> &serverAttrs);
     void updateShared(const QMap<QString, QVariant> &serverAttrs);
-    void loadAttributes();
 
     JobFilter m_jobs;
     PrinterBackend *m_backend;
@@ -111,12 +160,18 @@ private:
     QList<ColorModel> m_supportedColorModels;
     PrintQuality m_defaultPrintQuality;
     QList<PrintQuality> m_supportedPrintQualities;
-    bool m_acceptJobs;
-    bool m_shared;
+    bool m_acceptJobs = false;
+    bool m_shared = false;
     QString m_deviceUri;
-    int m_copies;
+    int m_copies = 1;
+    qint64 m_configChangeTime = -1;
+    qint64 m_stateChangeTime = -1;
 
     QString m_stateMessage;
+
+    LoadState m_loadStates[AttributeGroupCount];
+    // Set while a load is requested, to tell loads that finish right away.
+    bool m_requesting = false;
 };
 
 #endif // USC_PRINTERS_PRINTER_H
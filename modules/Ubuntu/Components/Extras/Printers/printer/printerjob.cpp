@@ -390,8 +390,16 @@ void PrinterJob::setPrinter(QSharedPointer<Printer> printer)
 {
    if (m_printer != printer) {
         Q_EMIT printerAboutToChange(m_printer, printer);
+        if (m_printer) {
+            disconnect(m_printer.data(), &Printer::capabilitiesChanged,
+                       this, &PrinterJob::loadDefaults);
+        }
         m_printer = printer;
 
+        // The defaults come with the capabilities, which may still be loading.
+        connect(m_printer.data(), &Printer::capabilitiesChanged,
+                this, &PrinterJob::loadDefaults);
+
         if (printer->name() != m_printerName) {
             m_printerName = printer->name();
             Q_EMIT printerNameChanged();
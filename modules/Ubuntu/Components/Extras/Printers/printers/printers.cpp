@@ -15,18 +15,20 @@
  */
 
 #include "backend/backend_cups.h"
+#include "cups/cupsnotifier.h"
 #include "i18n.h"
+#include "models/recommendeddrivermodel.h"
 #include "printers/printers.h"
-#include "cupsdnotifier.h" // Note: this file was generated.
 
+#include <QCoreApplication>
 #include <QDBusConnection>
-#include <QPrinterInfo>
 #include <QQmlEngine>
 
 Printers::Printers(QObject *parent)
-    : Printers(new PrinterCupsBackend(new IppClient(), QPrinterInfo(),
-        new OrgCupsCupsdNotifierInterface("", CUPSD_NOTIFIER_DBUS_PATH,
-                                          QDBusConnection::systemBus())),
+    : Printers(new PrinterCupsBackend(new IppClient(), QString(),
+        new CupsNotifier(CUPSD_NOTIFIER_DBUS_PATH,
+                         QDBusConnection::systemBus(),
+                         QCoreApplication::instance())),
        parent)
 {
 }
@@ -54,22 +56,26 @@ Printers::Printers(PrinterBackend *backend, QObject *parent)
     connect(&m_drivers, SIGNAL(filterComplete()),
             this, SIGNAL(driverFilterChanged()));
 
+    // The initial jobs are inserted many rows at a time.
     connect(&m_jobs, &QAbstractItemModel::rowsInserted, [this](
-            const QModelIndex &parent, int first, int) {
-        int jobId = m_jobs.data(m_jobs.index(first, 0, parent),
-                                JobModel::Roles::IdRole).toInt();
-        QString printerName = m_jobs.data(
-            m_jobs.index(first, 0, parent),
-            JobModel::Roles::PrinterNameRole
-        ).toString();
-
-        jobAdded(m_jobs.getJob(printerName, jobId));
+            const QModelIndex &parent, int first, int last) {
+        for (int i = first; i <= last; i++) {
+            int jobId = m_jobs.data(m_jobs.index(i, 0, parent),
+                                    JobModel::Roles::IdRole).toInt();
+            QString printerName = m_jobs.data(
+                m_jobs.index(i, 0, parent),
+                JobModel::Roles::PrinterNameRole
+            ).toString();
+
+            jobAdded(m_jobs.getJob(printerName, jobId));
+        }
     });
 
-    // If the jobModel forces a refresh, load extended attributes for the job
-    connect(&m_jobs, &JobModel::forceJobRefresh, [this](
-            const QString &printerName, const int jobId) {
-       jobAdded(m_jobs.getJob(printerName, jobId));
+    // If the jobModel forces a refresh, reload the extended attributes of
+    // the jobs, which the backend batches.
+    connect(&m_jobs, &JobModel::forceJobsRefresh, [this](
+            const QString &printerName, const QList<int> &jobIds) {
+       m_backend->refreshJobs(printerName, jobIds);
     });
 
     connect(&m_model, &QAbstractItemModel::rowsInserted, [this](
@@ -107,7 +113,8 @@ Printers::Printers(PrinterBackend *backend, QObject *parent)
 
     // Eagerly load the default printer.
     if (!m_backend->defaultPrinterName().isEmpty())
-        m_backend->requestPrinter(m_backend->defaultPrinterName());
+        m_backend->requestPrinter(m_backend->defaultPrinterName(),
+                                  TaskScheduler::Priority::DefaultPrinter);
 }
 
 Printers::~Printers()
@@ -223,6 +230,13 @@ QAbstractItemModel* Printers::createJobFilter()
     return filter;
 }
 
+QAbstractItemModel* Printers::createRecommendedDriverModel(
+        const QString &deviceId, const QString &makeModel)
+{
+    // Note: If called by QML, it gains ownership of the model.
+    return new RecommendedDriverModel(&m_drivers, deviceId, makeModel);
+}
+
 void Printers::cancelJob(const QString &printerName, const int jobId)
 {
     m_backend->cancelJob(printerName, jobId);
@@ -368,7 +382,7 @@ void Printers::loadPrinter(const QString &name)
     }
 
     if (printer->type() == PrinterEnum::PrinterType::ProxyType) {
-        m_backend->requestPrinter(name);
+        m_backend->requestPrinter(name, TaskScheduler::Priority::Visible);
     }
 }
 
@@ -71,6 +71,12 @@ public Q_SLOTS:
     PrinterJob* createJob(const QString &printerName);
     QAbstractItemModel* createJobFilter();
 
+    /* The drivers suitable for a device of the devices model, given its
+    IEEE 1284 device id and make and model. Drivers have to be loaded,
+    see prepareToAddPrinter. */
+    QAbstractItemModel* createRecommendedDriverModel(const QString &deviceId,
+                                                     const QString &makeModel);
+
     void cancelJob(const QString &printerName, const int jobId);
     void holdJob(const QString &printerName, const int jobId);
     void releaseJob(const QString &printerName, const int jobId);
@@ -23,6 +23,8 @@
 #include <QtCore/QMap>
 #include <QDebug>
 #include <QMetaType>
+#include <QStringList>
+#include <QUrl>
 
 struct ColorModel
 {
@@ -157,6 +159,24 @@ public:
         return QString("%1 %2").arg(mfg).arg(mdl);
     }
 
+    /* Identifies a device across searches and CUPS backends. This is the
+    URI, with the scheme and host in lower case and without a trailing slash,
+    and the device ID without the trailing ";". */
+    QString key() const
+    {
+        QUrl url(uri, QUrl::StrictMode);
+        QString normalisedUri = url.isValid()
+            ? url.adjusted(QUrl::StripTrailingSlash | QUrl::NormalizePathSegments).toString()
+            : uri;
+
+        QString normalisedId = id.trimmed();
+        while (normalisedId.endsWith(";")) {
+            normalisedId.chop(1);
+        }
+
+        return normalisedUri + QLatin1Char('\n') + normalisedId;
+    }
+
     bool operator==(const Device &other)
     {
         return ((cls == other.cls) && (id == other.id) && (info == other.info) &&
@@ -166,6 +186,29 @@ public:
 };
 
 
+// Extended attributes of a job, as loaded by the backend.
+struct JobAttributes
+{
+public:
+    QString printerName;
+    int jobId = -1;
+    QMap<QString, QVariant> attributes;
+};
+
+/* The attributes of a printer that change while it is in use, which are
+loaded again whenever the printer changes. Times are as reported by cupsd,
+-1 if unknown. */
+struct PrinterStateAttributes
+{
+public:
+    QString printerName;
+    PrinterEnum::State state = PrinterEnum::State::IdleState;
+    QString stateMessage;
+    QStringList stateReasons;
+    bool acceptJobs = false;
+    qint64 stateChangeTime = -1;
+    qint64 configChangeTime = -1;
+};
 
 Q_DECLARE_TYPEINFO(ColorModel, Q_PRIMITIVE_TYPE);
 Q_DECLARE_METATYPE(ColorModel)
@@ -180,4 +223,11 @@ Q_DECLARE_METATYPE(QList<PrinterDriver>)
 Q_DECLARE_TYPEINFO(Device, Q_MOVABLE_TYPE);
 Q_DECLARE_METATYPE(Device)
 
+Q_DECLARE_TYPEINFO(JobAttributes, Q_MOVABLE_TYPE);
+Q_DECLARE_METATYPE(JobAttributes)
+Q_DECLARE_METATYPE(QList<JobAttributes>)
+
+Q_DECLARE_TYPEINFO(PrinterStateAttributes, Q_MOVABLE_TYPE);
+Q_DECLARE_METATYPE(PrinterStateAttributes)
+
 #endif // USC_PRINTERS_STRUCTS_H
@@ -105,6 +105,15 @@ public:
         quality.originalOption = optionName;
         return quality;
     }
+
+    // Resolution choices look like "300dpi" or "600x300dpi", in which case
+    // the horizontal resolution is taken, as QPrinterInfo does.
+    static int parsePpdResolution(const QString &choice)
+    {
+        QString res = choice;
+        res.remove(QStringLiteral("dpi"));
+        return res.section(QLatin1Char('x'), 0, 0).toInt();
+    }
 };
 
 #endif // USC_PRINTERS_UTILS_H
@@ -19,8 +19,11 @@
 #include "components.h"
 #include "example/example-model.h"
 
+#include "photoeditor/photo-batch-processor.h"
 #include "photoeditor/photo-data.h"
 #include "photoeditor/photo-image-provider.h"
+#include "photoeditor/photo-preview.h"
+#include "photoeditor/photo-tile-provider.h"
 #include "photoeditor/file-utils.h"
 
 #include "tabsbar/drag-helper.h"
@@ -32,6 +35,8 @@ void Components::registerTypes(const char *uri)
 
     // PhotoEditor component
     qmlRegisterType<PhotoData>(uri, 0, 2, "PhotoData");
+    qmlRegisterType<PhotoPreview>(uri, 0, 2, "PhotoPreview");
+    qmlRegisterType<PhotoBatchProcessor>(uri, 0, 2, "PhotoBatchProcessor");
     qmlRegisterSingletonType<FileUtils>(uri, 0, 2, "FileUtils",
                                         exportFileUtilsSingleton);
 
@@ -46,6 +51,10 @@ void Components::initializeEngine(QQmlEngine *engine, const char *uri)
     PhotoImageProvider* provider = new PhotoImageProvider();
     engine->addImageProvider(PhotoImageProvider::PROVIDER_ID,
                              provider);
+
+    PhotoTileProvider* tileProvider = new PhotoTileProvider();
+    engine->addImageProvider(PhotoTileProvider::PROVIDER_ID,
+                             tileProvider);
 }
 
 QObject* Components::exportFileUtilsSingleton(QQmlEngine *engine,
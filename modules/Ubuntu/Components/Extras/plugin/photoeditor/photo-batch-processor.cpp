@@ -0,0 +1,519 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "photo-batch-processor.h"
+#include "photo-edit-thread.h"
+
+// medialoader
+#include "photo-metadata.h"
+
+#include <QBuffer>
+#include <QDebug>
+#include <QFile>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThreadPool>
+
+Q_GLOBAL_STATIC(QThreadPool, ioPool)
+Q_GLOBAL_STATIC(QThreadPool, cpuPool)
+
+/*!
+ * \brief The PhotoBatchJob struct holds the state of one photo while it
+ * moves through the stages of a batch
+ */
+struct PhotoBatchJob
+{
+    enum Stage {
+        READ,
+        PROCESS,
+        WRITE,
+        DONE
+    };
+
+    QString path;
+    QString format;
+    Orientation orientation;
+    QByteArray data;
+    QImage image;
+    Stage stage;
+    bool failed;
+
+    PhotoBatchJob(const QString& path)
+        : path(path),
+          orientation(TOP_LEFT_ORIGIN),
+          stage(READ),
+          failed(false) {
+    }
+};
+
+/*!
+ * \brief The PhotoBatchTask class runs the current stage of a job on a
+ * pool thread, and reports back to the processor on its own thread
+ */
+class PhotoBatchTask : public QRunnable
+{
+public:
+    PhotoBatchTask(PhotoBatchProcessor* processor, int index, PhotoBatchJob* job)
+        : m_processor(processor), m_index(index), m_job(job) {
+    }
+
+    void run() Q_DECL_OVERRIDE {
+        if (!m_processor->m_canceled.load()) {
+            if (m_job->stage == PhotoBatchJob::READ)
+                m_processor->readPhoto(m_job);
+            else if (m_job->stage == PhotoBatchJob::PROCESS)
+                m_processor->processPhoto(m_job);
+            else if (m_job->stage == PhotoBatchJob::WRITE)
+                m_processor->writePhoto(m_job);
+        }
+
+        QMetaObject::invokeMethod(m_processor, "stageFinished",
+                                  Qt::QueuedConnection, Q_ARG(int, m_index));
+        m_processor->taskFinished();
+    }
+
+private:
+    PhotoBatchProcessor* m_processor;
+    int m_index;
+    PhotoBatchJob* m_job;
+};
+
+/*!
+ * \brief PhotoBatchProcessor::PhotoBatchProcessor
+ */
+PhotoBatchProcessor::PhotoBatchProcessor(QObject* parent)
+    : QObject(parent),
+      m_metadataRotation(false),
+      m_nextJob(0),
+      m_inFlight(0),
+      m_processed(0),
+      m_failed(0),
+      m_running(false),
+      m_canceled(0),
+      m_activeTasks(0)
+{
+}
+
+PhotoBatchProcessor::~PhotoBatchProcessor()
+{
+    // Tasks already running keep a pointer to this object and to their job,
+    // so wait for them before going away.
+    cancel();
+
+    QMutexLocker locker(&m_tasksMutex);
+    while (m_activeTasks > 0)
+        m_tasksDone.wait(&m_tasksMutex);
+    locker.unlock();
+
+    qDeleteAll(m_jobs);
+}
+
+/*!
+ * \brief PhotoBatchProcessor::ioThreads
+ * \return the number of threads reading and writing files, shared by all
+ * the batch processors
+ */
+int PhotoBatchProcessor::ioThreads()
+{
+    return ioPool()->maxThreadCount();
+}
+
+void PhotoBatchProcessor::setIoThreads(int ioThreads)
+{
+    ioPool()->setMaxThreadCount(qMax(1, ioThreads));
+}
+
+/*!
+ * \brief PhotoBatchProcessor::cpuThreads
+ * \return the number of threads decoding, editing and encoding pixels,
+ * shared by all the batch processors
+ */
+int PhotoBatchProcessor::cpuThreads()
+{
+    return cpuPool()->maxThreadCount();
+}
+
+void PhotoBatchProcessor::setCpuThreads(int cpuThreads)
+{
+    cpuPool()->setMaxThreadCount(qMax(1, cpuThreads));
+}
+
+bool PhotoBatchProcessor::running() const
+{
+    return m_running;
+}
+
+int PhotoBatchProcessor::total() const
+{
+    return m_jobs.size();
+}
+
+/*!
+ * \brief PhotoBatchProcessor::processed
+ * \return the number of photos that were edited successfully so far
+ */
+int PhotoBatchProcessor::processed() const
+{
+    return m_processed;
+}
+
+int PhotoBatchProcessor::failed() const
+{
+    return m_failed;
+}
+
+/*!
+ * \brief PhotoBatchProcessor::progress
+ * \return the fraction of the photos that are done, between 0.0 and 1.0
+ */
+qreal PhotoBatchProcessor::progress() const
+{
+    if (m_jobs.isEmpty())
+        return 0.0;
+    return (qreal)(m_processed + m_failed) / m_jobs.size();
+}
+
+/*!
+ * \brief PhotoBatchProcessor::throughput
+ * \return the number of photos edited per second since the batch started
+ */
+qreal PhotoBatchProcessor::throughput() const
+{
+    if (!m_timer.isValid() || m_timer.elapsed() == 0)
+        return 0.0;
+    return m_processed * 1000.0 / m_timer.elapsed();
+}
+
+/*!
+ * \brief PhotoBatchProcessor::start begins editing the photos in background
+ * \param paths the photos to edit
+ * \param commands the edits to apply to each photo, in order
+ * \return false if another batch is running or the commands are invalid
+ */
+bool PhotoBatchProcessor::start(const QStringList& paths, const QVariantList& commands)
+{
+    if (m_running) {
+        qWarning() << "Can't start a batch while another one is running.";
+        return false;
+    }
+
+    QList<PhotoEditCommand> parsed;
+    if (!parseCommands(commands, &parsed))
+        return false;
+
+    qDeleteAll(m_jobs);
+    m_jobs.clear();
+    Q_FOREACH(const QString& path, paths) {
+        m_jobs.append(new PhotoBatchJob(path));
+    }
+
+    m_commands = parsed;
+    m_metadataRotation = onlyRotations(parsed);
+    m_nextJob = 0;
+    m_inFlight = 0;
+    m_processed = 0;
+    m_failed = 0;
+    m_canceled.store(0);
+    m_timer.start();
+
+    m_running = true;
+    Q_EMIT runningChanged();
+    Q_EMIT progressChanged();
+
+    scheduleMore();
+    if (m_inFlight == 0)
+        finishBatch();
+
+    return true;
+}
+
+/*!
+ * \brief PhotoBatchProcessor::cancel stops the batch as soon as the stages
+ * currently running are done. Photos already written are left edited.
+ */
+void PhotoBatchProcessor::cancel()
+{
+    if (!m_running || m_canceled.load())
+        return;
+
+    m_canceled.store(1);
+    if (m_inFlight == 0)
+        finishBatch();
+}
+
+void PhotoBatchProcessor::stageFinished(int index)
+{
+    PhotoBatchJob* job = m_jobs.at(index);
+
+    if (m_canceled.load() || job->failed || job->stage == PhotoBatchJob::WRITE ||
+        job->stage == PhotoBatchJob::DONE) {
+        finishJob(index);
+        return;
+    }
+
+    if (job->stage == PhotoBatchJob::READ)
+        job->stage = PhotoBatchJob::PROCESS;
+    else if (job->stage == PhotoBatchJob::PROCESS)
+        job->stage = PhotoBatchJob::WRITE;
+    schedule(index);
+}
+
+/*!
+ * \brief PhotoBatchProcessor::parseCommands converts the commands given from
+ * QML to edit commands
+ * \return false if any of the commands is not known
+ */
+bool PhotoBatchProcessor::parseCommands(const QVariantList& commands,
+                                        QList<PhotoEditCommand>* parsed)
+{
+    Q_FOREACH(const QVariant& item, commands) {
+        PhotoEditCommand command;
+
+        if (item.type() == QVariant::String) {
+            QString name = item.toString();
+            if (name == "rotateRight" || name == "rotateLeft") {
+                command.type = EDIT_ROTATE;
+                command.orientation = OrientationCorrection::rotateOrientation(
+                            TOP_LEFT_ORIGIN, name == "rotateLeft");
+            } else if (name == "autoEnhance") {
+                command.type = EDIT_ENHANCE;
+            }
+        } else {
+            QVariantMap map = item.toMap();
+            if (map.contains("exposureCompensation")) {
+                command.type = EDIT_COMPENSATE_EXPOSURE;
+                command.exposureCompensation = map.value("exposureCompensation").toReal();
+            } else if (map.contains("crop")) {
+                command.type = EDIT_CROP;
+                command.crop_rectangle = map.value("crop").toRectF();
+            }
+        }
+
+        if (command.type == EDIT_NONE) {
+            qWarning() << "Unknown batch edit command" << item;
+            return false;
+        }
+        parsed->append(command);
+    }
+    return true;
+}
+
+bool PhotoBatchProcessor::onlyRotations(const QList<PhotoEditCommand>& commands)
+{
+    Q_FOREACH(const PhotoEditCommand& command, commands) {
+        if (command.type != EDIT_ROTATE)
+            return false;
+    }
+    return !commands.isEmpty();
+}
+
+/*!
+ * \brief PhotoBatchProcessor::scheduleMore starts new photos while there is
+ * room for them. Only enough photos to keep all threads busy are in flight,
+ * since each one holds its encoded data or decoded pixels in memory.
+ */
+void PhotoBatchProcessor::scheduleMore()
+{
+    int maxInFlight = ioThreads() + 2 * cpuThreads();
+    while (!m_canceled.load() && m_nextJob < m_jobs.size() &&
+           m_inFlight < maxInFlight) {
+        m_inFlight++;
+        schedule(m_nextJob++);
+    }
+}
+
+void PhotoBatchProcessor::schedule(int index)
+{
+    PhotoBatchJob* job = m_jobs.at(index);
+    QThreadPool* pool = (job->stage == PhotoBatchJob::PROCESS) ? cpuPool() : ioPool();
+
+    m_tasksMutex.lock();
+    m_activeTasks++;
+    m_tasksMutex.unlock();
+    pool->start(new PhotoBatchTask(this, index, job));
+}
+
+/*!
+ * \brief PhotoBatchProcessor::taskFinished is called on the pool thread when
+ * a task is done with this object, and wakes up the destructor when it is the
+ * last one
+ */
+void PhotoBatchProcessor::taskFinished()
+{
+    QMutexLocker locker(&m_tasksMutex);
+    m_activeTasks--;
+    if (m_activeTasks == 0)
+        m_tasksDone.wakeAll();
+}
+
+void PhotoBatchProcessor::finishJob(int index)
+{
+    PhotoBatchJob* job = m_jobs.at(index);
+    job->data.clear();
+    job->image = QImage();
+    m_inFlight--;
+
+    if (!m_canceled.load()) {
+        if (job->failed)
+            m_failed++;
+        else
+            m_processed++;
+        Q_EMIT photoFinished(job->path, !job->failed);
+        Q_EMIT progressChanged();
+
+        scheduleMore();
+    }
+
+    if (m_inFlight == 0 && (m_canceled.load() || m_nextJob >= m_jobs.size()))
+        finishBatch();
+}
+
+void PhotoBatchProcessor::finishBatch()
+{
+    m_running = false;
+    Q_EMIT runningChanged();
+    Q_EMIT progressChanged();
+    Q_EMIT finished(m_canceled.load() != 0);
+}
+
+/*!
+ * \brief PhotoBatchProcessor::readPhoto loads the file contents and its
+ * orientation. Rotations of formats that store the orientation in their
+ * metadata are done right away without touching the pixels.
+ */
+void PhotoBatchProcessor::readPhoto(PhotoBatchJob* job) const
+{
+    job->format = QString(QImageReader(job->path).format()).toLower();
+    if (job->format == "jpg")
+        job->format = "jpeg";
+
+    if (job->format == "jpeg") {
+        if (m_metadataRotation) {
+            rotateMetadata(job);
+            return;
+        }
+
+        PhotoMetadata* metadata = PhotoMetadata::fromFile(QFileInfo(job->path));
+        if (metadata != NULL) {
+            job->orientation = metadata->orientation();
+            delete metadata;
+        }
+    }
+
+    QFile file(job->path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Error reading" << job->path << "for batch editing";
+        job->failed = true;
+        return;
+    }
+    job->data = file.readAll();
+}
+
+/*!
+ * \brief PhotoBatchProcessor::processPhoto decodes the file contents, applies
+ * all the edits and encodes the result
+ */
+void PhotoBatchProcessor::processPhoto(PhotoBatchJob* job) const
+{
+    QBuffer input(&job->data);
+    QImageReader reader(&input, job->format.toLatin1());
+    QImage image = reader.read();
+    job->data.clear();
+    if (image.isNull()) {
+        qWarning() << "Error decoding" << job->path << "for batch editing:"
+                   << reader.errorString();
+        job->failed = true;
+        return;
+    }
+
+    // As in PhotoEditThread, edit the pixels as they are displayed.
+    if (job->format == "jpeg")
+        image = image.transformed(OrientationCorrection::fromOrientation(job->orientation).toTransform());
+
+    Q_FOREACH(const PhotoEditCommand& command, m_commands) {
+        image = PhotoEditThread::processImage(image, command);
+        if (image.isNull()) {
+            job->failed = true;
+            return;
+        }
+    }
+
+    QBuffer output(&job->data);
+    output.open(QIODevice::WriteOnly);
+    if (!image.save(&output, job->format.toLatin1().constData(), 90)) {
+        qWarning() << "Error encoding edited" << job->path;
+        job->failed = true;
+        return;
+    }
+    job->image = image;
+}
+
+/*!
+ * \brief PhotoBatchProcessor::writePhoto saves the edited file, preserving
+ * the original metadata
+ */
+void PhotoBatchProcessor::writePhoto(PhotoBatchJob* job) const
+{
+    PhotoMetadata* original = PhotoMetadata::fromFile(QFileInfo(job->path));
+
+    QFile file(job->path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(job->data) != job->data.size()) {
+        qWarning() << "Error saving edited" << job->path;
+        job->failed = true;
+        delete original;
+        return;
+    }
+    file.close();
+
+    PhotoMetadata* copy = PhotoMetadata::fromFile(QFileInfo(job->path));
+    if (original != NULL && copy != NULL) {
+        original->copyTo(copy);
+        copy->setOrientation(TOP_LEFT_ORIGIN); // reset previous orientation
+        copy->updateThumbnail(job->image);
+        copy->save();
+    }
+
+    delete original;
+    delete copy;
+}
+
+/*!
+ * \brief PhotoBatchProcessor::rotateMetadata applies all the rotations by
+ * changing only the orientation stored in the metadata
+ */
+void PhotoBatchProcessor::rotateMetadata(PhotoBatchJob* job) const
+{
+    PhotoMetadata* metadata = PhotoMetadata::fromFile(QFileInfo(job->path));
+    if (metadata == NULL) {
+        job->failed = true;
+        return;
+    }
+
+    Orientation left = OrientationCorrection::rotateOrientation(TOP_LEFT_ORIGIN, true);
+    Orientation orientation = metadata->orientation();
+    Q_FOREACH(const PhotoEditCommand& command, m_commands) {
+        orientation = OrientationCorrection::rotateOrientation(
+                    orientation, command.orientation == left);
+    }
+
+    metadata->setOrientation(orientation);
+    if (!metadata->save())
+        job->failed = true;
+    delete metadata;
+
+    job->stage = PhotoBatchJob::DONE;
+}
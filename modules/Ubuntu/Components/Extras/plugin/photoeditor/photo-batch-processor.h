@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PHOTO_BATCH_PROCESSOR_H_
+#define PHOTO_BATCH_PROCESSOR_H_
+
+#include "photo-edit-command.h"
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+#include <QVariantList>
+#include <QWaitCondition>
+
+struct PhotoBatchJob;
+
+/*!
+ * \brief The PhotoBatchProcessor class
+ *
+ * Applies the same list of edits to many photos at once, for example to
+ * auto-enhance or rotate a whole imported album.
+ *
+ * Every photo goes through three stages: reading the file and its metadata,
+ * decoding, editing and encoding the pixels, and writing the result back
+ * with the original metadata. Reading and writing run on a thread pool
+ * sized by ioThreads(), pixel work on a pool sized by cpuThreads(). Both
+ * pools are shared by all the processors, so their sizes are set once for
+ * the whole process, and only a bounded number of photos is in flight at any
+ * time so that memory use does not grow with the batch.
+ *
+ * The commands are given as a list whose items are either one of the
+ * strings "rotateRight", "rotateLeft" and "autoEnhance", or a map with an
+ * "exposureCompensation" value or a "crop" rectangle, mirroring the edit
+ * methods of PhotoData.
+ */
+class PhotoBatchProcessor : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(bool running READ running NOTIFY runningChanged)
+    Q_PROPERTY(int total READ total NOTIFY progressChanged)
+    Q_PROPERTY(int processed READ processed NOTIFY progressChanged)
+    Q_PROPERTY(int failed READ failed NOTIFY progressChanged)
+    Q_PROPERTY(qreal progress READ progress NOTIFY progressChanged)
+    Q_PROPERTY(qreal throughput READ throughput NOTIFY progressChanged)
+
+public:
+    explicit PhotoBatchProcessor(QObject* parent = 0);
+    virtual ~PhotoBatchProcessor();
+
+    static int ioThreads();
+    static void setIoThreads(int ioThreads);
+    static int cpuThreads();
+    static void setCpuThreads(int cpuThreads);
+
+    bool running() const;
+    int total() const;
+    int processed() const;
+    int failed() const;
+    qreal progress() const;
+    qreal throughput() const;
+
+    Q_INVOKABLE bool start(const QStringList& paths, const QVariantList& commands);
+    Q_INVOKABLE void cancel();
+
+Q_SIGNALS:
+    void runningChanged();
+    void progressChanged();
+
+    void photoFinished(const QString& path, bool success);
+    void finished(bool canceled);
+
+private Q_SLOTS:
+    void stageFinished(int index);
+
+private:
+    friend class PhotoBatchTask;
+
+    static bool parseCommands(const QVariantList& commands,
+                              QList<PhotoEditCommand>* parsed);
+    static bool onlyRotations(const QList<PhotoEditCommand>& commands);
+
+    void scheduleMore();
+    void schedule(int index);
+    void finishJob(int index);
+    void finishBatch();
+
+    void readPhoto(PhotoBatchJob* job) const;
+    void processPhoto(PhotoBatchJob* job) const;
+    void writePhoto(PhotoBatchJob* job) const;
+    void rotateMetadata(PhotoBatchJob* job) const;
+    void taskFinished();
+
+    QList<PhotoEditCommand> m_commands;
+    bool m_metadataRotation;
+    QList<PhotoBatchJob*> m_jobs;
+    int m_nextJob;
+    int m_inFlight;
+    int m_processed;
+    int m_failed;
+    bool m_running;
+    QAtomicInt m_canceled;
+    int m_activeTasks;
+    QMutex m_tasksMutex;
+    QWaitCondition m_tasksDone;
+    QElapsedTimer m_timer;
+};
+
+#endif  // PHOTO_BATCH_PROCESSOR_H_
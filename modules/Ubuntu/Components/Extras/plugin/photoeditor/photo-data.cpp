@@ -100,6 +100,7 @@ void PhotoData::setPath(QString path)
                 delete metadata;
                 Q_EMIT orientationChanged();
             }
+            Q_EMIT sizeChanged();
         }
     }
 }
@@ -144,6 +145,7 @@ void PhotoData::refreshFromDisk()
         Q_EMIT orientationChanged();
     }
 
+    Q_EMIT sizeChanged();
     Q_EMIT dataChanged();
 }
 
@@ -227,12 +229,14 @@ void PhotoData::finishEditing()
     if (!m_editThread || m_editThread->isRunning())
         return;
 
+    m_lastEditTrace = m_editThread->trace().toVariantMap();
     m_editThread->deleteLater();
     m_editThread = 0;
     m_busy = false;
 
     refreshFromDisk();
 
+    Q_EMIT lastEditTraceChanged();
     Q_EMIT busyChanged();
     Q_EMIT editFinished();
 }
@@ -273,3 +277,26 @@ bool PhotoData::busy() const
 {
     return m_busy;
 }
+
+/*!
+ * \brief Photo::size returns the size of the photo as displayed, that is
+ * after the orientation stored in its metadata has been applied
+ * \return
+ */
+QSize PhotoData::size() const
+{
+    QSize size = QImageReader(m_file.absoluteFilePath()).size();
+    if (fileFormatHasOrientation() && m_orientation >= LEFT_TOP_ORIGIN)
+        size.transpose();
+    return size;
+}
+
+/*!
+ * \brief Photo::lastEditTrace returns the duration and amount of data of each
+ * stage of the last edit, see PhotoEditTrace::toVariantMap()
+ * \return
+ */
+QVariantMap PhotoData::lastEditTrace() const
+{
+    return m_lastEditTrace;
+}
@@ -28,6 +28,7 @@
 
 // QT
 #include <QFileInfo>
+#include <QSize>
 #include <QVariant>
 
 class PhotoEditCommand;
@@ -43,6 +44,8 @@ class PhotoData : public QObject
     Q_PROPERTY(QString path READ path WRITE setPath NOTIFY pathChanged)
     Q_PROPERTY(int orientation READ orientation NOTIFY orientationChanged)
     Q_PROPERTY(bool busy READ busy NOTIFY busyChanged)
+    Q_PROPERTY(QSize size READ size NOTIFY sizeChanged)
+    Q_PROPERTY(QVariantMap lastEditTrace READ lastEditTrace NOTIFY lastEditTraceChanged)
 
 public:
     explicit PhotoData();
@@ -54,6 +57,8 @@ public:
     void setPath(QString path);
     QFileInfo file() const;
     bool busy() const;
+    QSize size() const;
+    QVariantMap lastEditTrace() const;
 
     virtual Orientation orientation() const;
 
@@ -71,6 +76,8 @@ Q_SIGNALS:
     void pathChanged();
     void orientationChanged();
     void busyChanged();
+    void sizeChanged();
+    void lastEditTraceChanged();
 
     void editFinished();
     void dataChanged();
@@ -85,6 +92,7 @@ private:
     PhotoEditThread *m_editThread;
     QFileInfo m_file;
     bool m_busy;
+    QVariantMap m_lastEditTrace;
 
     Orientation m_orientation;
 };
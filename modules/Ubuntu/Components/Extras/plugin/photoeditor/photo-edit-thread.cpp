@@ -49,24 +49,33 @@ const PhotoEditCommand &PhotoEditThread::command() const
  */
 void PhotoEditThread::run()
 {
+    QString filePath = m_photo->file().filePath();
+    m_trace.start(filePath, m_command.type);
+
     // The only operation in which we don't have to work on the actual image
     // pixels is image rotation in the case where we can simply change the
     // metadata rotation field.
     if (m_command.type == EDIT_ROTATE && m_photo->fileFormatHasOrientation()) {
         handleSimpleMetadataRotation(m_command);
+        m_trace.endStage("metadata", QFileInfo(filePath).size());
+        m_trace.log();
         return;
     }
 
     // In all other cases we load the image, do the work, and save it back.
-    QImage image(m_photo->file().filePath(), m_photo->fileFormat().toStdString().c_str());
+    QImage image(filePath, m_photo->fileFormat().toStdString().c_str());
     if (image.isNull()) {
-        qWarning() << "Error loading" << m_photo->file().filePath() << "for editing";
+        qWarning() << "Error loading" << filePath << "for editing";
+        m_trace.fail("decode");
+        m_trace.log();
         return;
     }
+    m_trace.endStage("decode", QFileInfo(filePath).size());
 
     // Copy all metadata from the original image so that we can save it to the
     // new one after modifying the pixels.
     PhotoMetadata* original = PhotoMetadata::fromFile(m_photo->file());
+    m_trace.endStage("metadata-read", 0);
 
 #if (QT_VERSION >= QT_VERSION_CHECK(5, 5, 0))
     // If the photo was previously rotated through metadata and we are editing
@@ -83,40 +92,77 @@ void PhotoEditThread::run()
         image = image.transformed(transform);
     }
 #endif
+    m_trace.endStage("orientation", image.byteCount());
 
-    if (m_command.type == EDIT_ROTATE) {
-        QTransform transform = OrientationCorrection::fromOrientation(m_command.orientation).toTransform();
-        image = image.transformed(transform);
-    } else if (m_command.type == EDIT_CROP) {
-        QRect rect;
-        rect.setX(qBound(0.0, m_command.crop_rectangle.x(), 1.0) * image.width());
-        rect.setY(qBound(0.0, m_command.crop_rectangle.y(), 1.0) * image.height());
-        rect.setWidth(qBound(0.0, m_command.crop_rectangle.width(), 1.0) * image.width());
-        rect.setHeight(qBound(0.0, m_command.crop_rectangle.height(), 1.0) * image.height());
-
-        image = image.copy(rect);
-    } else if (m_command.type == EDIT_ENHANCE) {
-        image = enhanceImage(image);
-    } else if (m_command.type == EDIT_COMPENSATE_EXPOSURE) {
-        image = compensateExposure(image, m_command.exposureCompensation);
-    } else {
-        qWarning() << "Edit thread running with unknown or no operation.";
+    image = processImage(image, m_command);
+    if (image.isNull()) {
+        delete original;
+        m_trace.fail("process");
+        m_trace.log();
         return;
     }
+    m_trace.endStage("process", image.byteCount());
 
-    bool saved = image.save(m_photo->file().filePath(),
+    bool saved = image.save(filePath,
                             m_photo->fileFormat().toStdString().c_str(), 90);
-    if (!saved)
-        qWarning() << "Error saving edited" << m_photo->file().filePath();
+    if (!saved) {
+        qWarning() << "Error saving edited" << filePath;
+        m_trace.fail("encode");
+    } else {
+        m_trace.endStage("encode", QFileInfo(filePath).size());
+    }
 
     PhotoMetadata* copy = PhotoMetadata::fromFile(m_photo->file());
     original->copyTo(copy);
     copy->setOrientation(TOP_LEFT_ORIGIN); // reset previous orientation
     copy->updateThumbnail(image);
     copy->save();
+    m_trace.endStage("metadata-write", QFileInfo(filePath).size());
 
     delete original;
     delete copy;
+
+    m_trace.log();
+}
+
+/*!
+ * \brief PhotoEditThread::trace returns the timing of the stages of the
+ * edit, which is complete once the thread has finished
+ * \return
+ */
+const PhotoEditTrace &PhotoEditThread::trace() const
+{
+    return m_trace;
+}
+
+/*!
+ * \brief PhotoEditThread::processImage applies the pixel operation of an
+ * edit command to an image that is already in its displayed orientation
+ * \param image the image to edit
+ * \param command the edit to apply
+ * \return the edited image, or a null image if the command has no operation
+ */
+QImage PhotoEditThread::processImage(const QImage& image, const PhotoEditCommand& command)
+{
+    if (command.type == EDIT_ROTATE) {
+        QTransform transform = OrientationCorrection::fromOrientation(command.orientation).toTransform();
+        return image.transformed(transform);
+    } else if (command.type == EDIT_CROP) {
+        QRect rect;
+        rect.setX(qBound(0.0, command.crop_rectangle.x(), 1.0) * image.width());
+        rect.setY(qBound(0.0, command.crop_rectangle.y(), 1.0) * image.height());
+        rect.setWidth(qBound(0.0, command.crop_rectangle.width(), 1.0) * image.width());
+        rect.setHeight(qBound(0.0, command.crop_rectangle.height(), 1.0) * image.height());
+
+        return image.copy(rect);
+    } else if (command.type == EDIT_ENHANCE) {
+        return enhanceImage(image);
+    } else if (command.type == EDIT_COMPENSATE_EXPOSURE) {
+        return compensateExposure(image, command.exposureCompensation);
+    }
+
+    qWarning() << "Edit running with unknown or no operation.";
+    return QImage();
 }
 
 /*!
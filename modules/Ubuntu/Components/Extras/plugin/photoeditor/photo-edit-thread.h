@@ -19,6 +19,7 @@
 
 #include "photo-caches.h"
 #include "photo-edit-command.h"
+#include "photo-edit-trace.h"
 
 // util
 #include "orientation.h"
@@ -39,18 +40,22 @@ public:
     PhotoEditThread(PhotoData *photo, const PhotoEditCommand& command);
 
     const PhotoEditCommand& command() const;
+    const PhotoEditTrace& trace() const;
+
+    static QImage processImage(const QImage& image, const PhotoEditCommand& command);
+    static QImage enhanceImage(const QImage& image);
+    static QImage compensateExposure(const QImage& image, qreal compansation);
 
 protected:
     void run() Q_DECL_OVERRIDE;
 
 private:
-    QImage enhanceImage(const QImage& image);
-    QImage compensateExposure(const QImage& image, qreal compansation);
     QImage doColorBalance(const QImage& image, qreal brightness, qreal contrast, qreal saturation, qreal hue);
     void handleSimpleMetadataRotation(const PhotoEditCommand& state);
 
     PhotoData *m_photo;
     PhotoEditCommand m_command;
+    PhotoEditTrace m_trace;
 };
 
 #endif
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "photo-edit-trace.h"
+
+#include <QStringList>
+#include <QVariantList>
+
+Q_LOGGING_CATEGORY(PHOTO_EDIT_TIMING, "ubuntu.components.extras.photoeditor.timing")
+
+/*!
+ * \brief PhotoEditTrace::PhotoEditTrace
+ */
+PhotoEditTrace::PhotoEditTrace()
+    : m_editType(0),
+      m_lastMark(0),
+      m_failed(false)
+{
+}
+
+/*!
+ * \brief PhotoEditTrace::start clears any previous stage and starts timing
+ * \param path the photo being edited
+ * \param editType the EditType of the edit
+ */
+void PhotoEditTrace::start(const QString& path, int editType)
+{
+    m_path = path;
+    m_editType = editType;
+    m_stages.clear();
+    m_lastMark = 0;
+    m_failed = false;
+    m_timer.start();
+}
+
+/*!
+ * \brief PhotoEditTrace::endStage records a stage ending now
+ * \param name name of the stage
+ * \param bytes amount of data produced by the stage
+ */
+void PhotoEditTrace::endStage(const QString& name, qint64 bytes)
+{
+    qint64 now = m_timer.nsecsElapsed();
+
+    PhotoEditStage stage;
+    stage.name = name;
+    stage.nsecs = now - m_lastMark;
+    stage.bytes = bytes;
+    m_stages.append(stage);
+
+    m_lastMark = now;
+}
+
+/*!
+ * \brief PhotoEditTrace::fail records the stage during which the edit
+ * failed, ending now, and marks the whole edit as failed
+ * \param name name of the stage
+ */
+void PhotoEditTrace::fail(const QString& name)
+{
+    endStage(name, 0);
+    m_failed = true;
+}
+
+QString PhotoEditTrace::path() const
+{
+    return m_path;
+}
+
+int PhotoEditTrace::editType() const
+{
+    return m_editType;
+}
+
+qint64 PhotoEditTrace::totalNsecs() const
+{
+    return m_lastMark;
+}
+
+bool PhotoEditTrace::failed() const
+{
+    return m_failed;
+}
+
+const QList<PhotoEditStage>& PhotoEditTrace::stages() const
+{
+    return m_stages;
+}
+
+bool PhotoEditTrace::isEmpty() const
+{
+    return m_stages.isEmpty();
+}
+
+/*!
+ * \brief PhotoEditTrace::toVariantMap
+ * \return the trace in a form suitable for QML, with durations in milliseconds
+ */
+QVariantMap PhotoEditTrace::toVariantMap() const
+{
+    QVariantList stages;
+    Q_FOREACH(const PhotoEditStage& stage, m_stages) {
+        QVariantMap item;
+        item["name"] = stage.name;
+        item["duration"] = stage.nsecs / 1000000.0;
+        item["bytes"] = stage.bytes;
+        stages.append(item);
+    }
+
+    QVariantMap result;
+    result["path"] = m_path;
+    result["editType"] = m_editType;
+    result["duration"] = totalNsecs() / 1000000.0;
+    result["failed"] = m_failed;
+    result["stages"] = stages;
+    return result;
+}
+
+/*!
+ * \brief PhotoEditTrace::log writes the trace as a single line to the
+ * PHOTO_EDIT_TIMING logging category
+ */
+void PhotoEditTrace::log() const
+{
+    if (!PHOTO_EDIT_TIMING().isDebugEnabled())
+        return;
+
+    QStringList stages;
+    Q_FOREACH(const PhotoEditStage& stage, m_stages) {
+        stages.append(QString("%1=%2ms/%3B").arg(stage.name)
+                      .arg(stage.nsecs / 1000000.0, 0, 'f', 2)
+                      .arg(stage.bytes));
+    }
+
+    QString line = QString("Edit %1 of %2 %3 after %4ms: %5")
+            .arg(m_editType).arg(m_path)
+            .arg(m_failed ? "failed" : "finished")
+            .arg(totalNsecs() / 1000000.0, 0, 'f', 2)
+            .arg(stages.join(" "));
+    qCDebug(PHOTO_EDIT_TIMING, "%s", qPrintable(line));
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PHOTO_EDIT_TRACE_H_
+#define PHOTO_EDIT_TRACE_H_
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QLoggingCategory>
+#include <QString>
+#include <QVariantMap>
+
+Q_DECLARE_LOGGING_CATEGORY(PHOTO_EDIT_TIMING)
+
+/*!
+ * \brief The PhotoEditStage struct is the duration and amount of data of a
+ * single stage of an edit
+ */
+struct PhotoEditStage
+{
+    QString name;
+    qint64 nsecs;
+    qint64 bytes;
+};
+
+/*!
+ * \brief The PhotoEditTrace class
+ *
+ * Records how long each stage of a photo edit takes, such as decoding,
+ * processing the pixels, encoding and copying the metadata, so that slow
+ * edits can be attributed to the right stage.
+ *
+ * Stages are recorded one after the other: each call to endStage() measures
+ * the time elapsed since start() or the previous endStage(). An edit that
+ * stops early ends its last stage with fail() instead.
+ */
+class PhotoEditTrace
+{
+public:
+    PhotoEditTrace();
+
+    void start(const QString& path, int editType);
+    void endStage(const QString& name, qint64 bytes);
+    void fail(const QString& name);
+
+    QString path() const;
+    int editType() const;
+    qint64 totalNsecs() const;
+    bool failed() const;
+    const QList<PhotoEditStage>& stages() const;
+    bool isEmpty() const;
+
+    QVariantMap toVariantMap() const;
+    void log() const;
+
+private:
+    QString m_path;
+    int m_editType;
+    QElapsedTimer m_timer;
+    qint64 m_lastMark;
+    bool m_failed;
+    QList<PhotoEditStage> m_stages;
+};
+
+#endif  // PHOTO_EDIT_TRACE_H_
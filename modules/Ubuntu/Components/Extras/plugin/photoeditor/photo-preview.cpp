@@ -0,0 +1,407 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "photo-preview.h"
+#include "photo-image-provider.h"
+
+#include <QDebug>
+#include <QGuiApplication>
+#include <QPainter>
+#include <QScreen>
+#include <QThread>
+#include <QUrl>
+#include <qmath.h>
+
+// Fixed point precision of the color matrix used for saturation and hue.
+static const int MATRIX_SHIFT = 10;
+static const int MATRIX_ONE = 1 << MATRIX_SHIFT;
+
+// Luminance weights the color matrix rotates and desaturates around.
+static const qreal LUMA_RED = 0.213;
+static const qreal LUMA_GREEN = 0.715;
+static const qreal LUMA_BLUE = 0.072;
+
+/*!
+ * \brief The PhotoPreviewLoader class decodes the proxy of a photo on its
+ * own thread, the same way the photo image provider does for QML images
+ */
+class PhotoPreviewLoader : public QThread
+{
+public:
+    PhotoPreviewLoader(const QString& path, const QSize& bounds)
+        : m_path(path), m_bounds(bounds) {
+    }
+
+    QString path() const {
+        return m_path;
+    }
+
+    QImage image() const {
+        return m_image;
+    }
+
+protected:
+    void run() Q_DECL_OVERRIDE {
+        PhotoImageProvider provider;
+        QSize size;
+        QImage image = provider.requestImage(QUrl::fromLocalFile(m_path).toString(),
+                                             &size, m_bounds);
+        if (!image.isNull())
+            m_image = image.convertToFormat(QImage::Format_RGB32);
+    }
+
+private:
+    QString m_path;
+    QSize m_bounds;
+    QImage m_image;
+};
+
+/*!
+ * \brief PhotoPreview::PhotoPreview
+ */
+PhotoPreview::PhotoPreview(QQuickItem* parent)
+    : QQuickPaintedItem(parent),
+      m_exposure(0.0),
+      m_brightness(1.0),
+      m_contrast(1.0),
+      m_saturation(1.0),
+      m_hue(0.0),
+      m_loader(0)
+{
+    for (int i = 0; i < 256; i++)
+        m_histogram[i] = 0;
+}
+
+PhotoPreview::~PhotoPreview()
+{
+    if (m_loader) {
+        m_loader->wait();
+        delete m_loader;
+    }
+}
+
+QString PhotoPreview::path() const
+{
+    return m_path;
+}
+
+void PhotoPreview::setPath(const QString& path)
+{
+    if (path == m_path)
+        return;
+
+    bool wasReady = ready();
+    m_path = path;
+    Q_EMIT pathChanged();
+
+    loadProxy();
+
+    if (wasReady != ready())
+        Q_EMIT readyChanged();
+}
+
+/*!
+ * \brief PhotoPreview::exposure
+ * \return -1.0 is total dark, +1.0 is total bright, 0.0 leaves the photo as is
+ */
+qreal PhotoPreview::exposure() const
+{
+    return m_exposure;
+}
+
+void PhotoPreview::setExposure(qreal exposure)
+{
+    if (exposure == m_exposure)
+        return;
+
+    m_exposure = exposure;
+    Q_EMIT exposureChanged();
+    render();
+}
+
+/*!
+ * \brief PhotoPreview::brightness
+ * \return multiplier of the pixel values, 1.0 leaves the photo as is
+ */
+qreal PhotoPreview::brightness() const
+{
+    return m_brightness;
+}
+
+void PhotoPreview::setBrightness(qreal brightness)
+{
+    if (brightness == m_brightness)
+        return;
+
+    m_brightness = brightness;
+    Q_EMIT brightnessChanged();
+    render();
+}
+
+/*!
+ * \brief PhotoPreview::contrast
+ * \return multiplier of the distance from middle gray, 1.0 leaves the photo as is
+ */
+qreal PhotoPreview::contrast() const
+{
+    return m_contrast;
+}
+
+void PhotoPreview::setContrast(qreal contrast)
+{
+    if (contrast == m_contrast)
+        return;
+
+    m_contrast = contrast;
+    Q_EMIT contrastChanged();
+    render();
+}
+
+/*!
+ * \brief PhotoPreview::saturation
+ * \return 0.0 is grayscale, 1.0 leaves the photo as is
+ */
+qreal PhotoPreview::saturation() const
+{
+    return m_saturation;
+}
+
+void PhotoPreview::setSaturation(qreal saturation)
+{
+    if (saturation == m_saturation)
+        return;
+
+    m_saturation = saturation;
+    Q_EMIT saturationChanged();
+    render();
+}
+
+/*!
+ * \brief PhotoPreview::hue
+ * \return rotation of the hue in degrees, 0.0 leaves the photo as is
+ */
+qreal PhotoPreview::hue() const
+{
+    return m_hue;
+}
+
+void PhotoPreview::setHue(qreal hue)
+{
+    if (hue == m_hue)
+        return;
+
+    m_hue = hue;
+    Q_EMIT hueChanged();
+    render();
+}
+
+/*!
+ * \brief PhotoPreview::histogram
+ * \return the 256 bins of the intensity histogram of the previewed image,
+ * using the same intensity measure as IntensityHistogram
+ */
+QVariantList PhotoPreview::histogram() const
+{
+    QVariantList result;
+    result.reserve(256);
+    for (int i = 0; i < 256; i++)
+        result.append(m_histogram[i]);
+    return result;
+}
+
+bool PhotoPreview::ready() const
+{
+    return !m_proxy.isNull();
+}
+
+/*!
+ * \brief PhotoPreview::reset sets all the adjustments back to the values
+ * that leave the photo unchanged
+ */
+void PhotoPreview::reset()
+{
+    setExposure(0.0);
+    setBrightness(1.0);
+    setContrast(1.0);
+    setSaturation(1.0);
+    setHue(0.0);
+}
+
+/*!
+ * \brief PhotoPreview::paint \reimp
+ * Draws the previewed image scaled to fit the item, preserving its aspect ratio.
+ */
+void PhotoPreview::paint(QPainter* painter)
+{
+    if (m_preview.isNull())
+        return;
+
+    QSizeF size = m_preview.size();
+    size.scale(width(), height(), Qt::KeepAspectRatio);
+    QRectF target(QPointF((width() - size.width()) / 2,
+                          (height() - size.height()) / 2), size);
+
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, smooth());
+    painter->drawImage(target, m_preview);
+}
+
+/*!
+ * \brief PhotoPreview::loadProxy starts decoding the photo at screen size,
+ * so that the following renders only deal with as many pixels as can be
+ * shown. The preview is empty until the decode is done.
+ */
+void PhotoPreview::loadProxy()
+{
+    m_proxy = QImage();
+
+    // A decode of the previous path is left to finish on its own.
+    if (m_loader) {
+        disconnect(m_loader, SIGNAL(finished()), this, SLOT(proxyLoaded()));
+        connect(m_loader, SIGNAL(finished()), m_loader, SLOT(deleteLater()));
+        if (m_loader->isFinished())
+            m_loader->deleteLater();
+        m_loader = 0;
+    }
+
+    render();
+    if (m_path.isEmpty())
+        return;
+
+    QSize bounds(1024, 1024);
+    QScreen* screen = QGuiApplication::primaryScreen();
+    if (screen != NULL)
+        bounds = screen->size() * screen->devicePixelRatio();
+    bounds = bounds.expandedTo(QSize(bounds.height(), bounds.width()));
+
+    m_loader = new PhotoPreviewLoader(m_path, bounds);
+    connect(m_loader, SIGNAL(finished()), this, SLOT(proxyLoaded()));
+    m_loader->start();
+}
+
+/*!
+ * \brief PhotoPreview::proxyLoaded takes the decoded proxy from the loader
+ * and renders it with the current adjustments
+ */
+void PhotoPreview::proxyLoaded()
+{
+    if (!m_loader || m_loader->isRunning())
+        return;
+
+    m_proxy = m_loader->image();
+    if (m_proxy.isNull())
+        qWarning() << "Error loading" << m_loader->path() << "for preview";
+
+    m_loader->deleteLater();
+    m_loader = 0;
+
+    render();
+    if (ready())
+        Q_EMIT readyChanged();
+}
+
+/*!
+ * \brief PhotoPreview::render applies the current adjustments to the proxy
+ * and recomputes the histogram in a single pass over its pixels.
+ * Per-channel adjustments are folded into one lookup table, and saturation
+ * and hue into one fixed point color matrix that is skipped when it is the
+ * identity.
+ */
+void PhotoPreview::render()
+{
+    for (int i = 0; i < 256; i++)
+        m_histogram[i] = 0;
+
+    if (m_proxy.isNull()) {
+        m_preview = QImage();
+        Q_EMIT histogramChanged();
+        update();
+        return;
+    }
+
+    // Exposure is applied first and clamped the same way as
+    // PhotoEditThread::compensateExposure does.
+    int shift = qBound(-255, (int)(255 * m_exposure), 255);
+    uchar lut[256];
+    for (int i = 0; i < 256; i++) {
+        qreal value = qBound(0, i + shift, 255);
+        value *= m_brightness;
+        value = (value - 127.5) * m_contrast + 127.5;
+        lut[i] = (uchar) qBound(0, qRound(value), 255);
+    }
+
+    // Saturation matrix, rotated around the gray axis for the hue.
+    qreal s = qMax((qreal) 0.0, m_saturation);
+    qreal sat[3][3] = {
+        { (1 - s) * LUMA_RED + s, (1 - s) * LUMA_GREEN, (1 - s) * LUMA_BLUE },
+        { (1 - s) * LUMA_RED, (1 - s) * LUMA_GREEN + s, (1 - s) * LUMA_BLUE },
+        { (1 - s) * LUMA_RED, (1 - s) * LUMA_GREEN, (1 - s) * LUMA_BLUE + s }
+    };
+    qreal c = qCos(qDegreesToRadians(m_hue));
+    qreal n = qSin(qDegreesToRadians(m_hue));
+    qreal rot[3][3] = {
+        { LUMA_RED + c * (1 - LUMA_RED) - n * LUMA_RED,
+          LUMA_GREEN - c * LUMA_GREEN - n * LUMA_GREEN,
+          LUMA_BLUE - c * LUMA_BLUE + n * (1 - LUMA_BLUE) },
+        { LUMA_RED - c * LUMA_RED + n * 0.143,
+          LUMA_GREEN + c * (1 - LUMA_GREEN) + n * 0.140,
+          LUMA_BLUE - c * LUMA_BLUE - n * 0.283 },
+        { LUMA_RED - c * LUMA_RED - n * (1 - LUMA_RED),
+          LUMA_GREEN - c * LUMA_GREEN + n * LUMA_GREEN,
+          LUMA_BLUE + c * (1 - LUMA_BLUE) + n * LUMA_BLUE }
+    };
+
+    int matrix[3][3];
+    bool identity = true;
+    for (int row = 0; row < 3; row++) {
+        for (int column = 0; column < 3; column++) {
+            qreal value = 0.0;
+            for (int k = 0; k < 3; k++)
+                value += rot[row][k] * sat[k][column];
+            matrix[row][column] = qRound(value * MATRIX_ONE);
+            if (matrix[row][column] != (row == column ? MATRIX_ONE : 0))
+                identity = false;
+        }
+    }
+
+    if (m_preview.size() != m_proxy.size())
+        m_preview = QImage(m_proxy.size(), QImage::Format_RGB32);
+
+    for (int j = 0; j < m_proxy.height(); j++) {
+        const QRgb* source = reinterpret_cast<const QRgb*>(m_proxy.constScanLine(j));
+        QRgb* target = reinterpret_cast<QRgb*>(m_preview.scanLine(j));
+
+        for (int i = 0; i < m_proxy.width(); i++) {
+            int red = lut[qRed(source[i])];
+            int green = lut[qGreen(source[i])];
+            int blue = lut[qBlue(source[i])];
+
+            if (!identity) {
+                int r = (matrix[0][0] * red + matrix[0][1] * green + matrix[0][2] * blue) >> MATRIX_SHIFT;
+                int g = (matrix[1][0] * red + matrix[1][1] * green + matrix[1][2] * blue) >> MATRIX_SHIFT;
+                int b = (matrix[2][0] * red + matrix[2][1] * green + matrix[2][2] * blue) >> MATRIX_SHIFT;
+                red = qBound(0, r, 255);
+                green = qBound(0, g, 255);
+                blue = qBound(0, b, 255);
+            }
+
+            target[i] = qRgb(red, green, blue);
+            m_histogram[qMax(red, qMax(green, blue))]++;
+        }
+    }
+
+    Q_EMIT histogramChanged();
+    update();
+}
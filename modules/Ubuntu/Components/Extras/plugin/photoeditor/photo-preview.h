@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PHOTO_PREVIEW_H_
+#define PHOTO_PREVIEW_H_
+
+#include <QImage>
+#include <QQuickPaintedItem>
+#include <QString>
+#include <QVariantList>
+
+class PhotoPreviewLoader;
+
+/*!
+ * \brief The PhotoPreview class
+ *
+ * Shows a live preview of exposure and color balance adjustments without
+ * editing the photo on disk. The photo is decoded once into a screen-sized
+ * proxy on a worker thread, and every change of the adjustment values re-renders the proxy
+ * through lookup tables and recomputes its intensity histogram, which is
+ * cheap enough to follow a slider while it is being dragged.
+ *
+ * The exposure value uses the same scale as PhotoData::exposureCompensation,
+ * so the previewed image matches the result of the real edit.
+ */
+class PhotoPreview : public QQuickPaintedItem
+{
+    Q_OBJECT
+
+    Q_PROPERTY(QString path READ path WRITE setPath NOTIFY pathChanged)
+    Q_PROPERTY(qreal exposure READ exposure WRITE setExposure NOTIFY exposureChanged)
+    Q_PROPERTY(qreal brightness READ brightness WRITE setBrightness NOTIFY brightnessChanged)
+    Q_PROPERTY(qreal contrast READ contrast WRITE setContrast NOTIFY contrastChanged)
+    Q_PROPERTY(qreal saturation READ saturation WRITE setSaturation NOTIFY saturationChanged)
+    Q_PROPERTY(qreal hue READ hue WRITE setHue NOTIFY hueChanged)
+    Q_PROPERTY(QVariantList histogram READ histogram NOTIFY histogramChanged)
+    Q_PROPERTY(bool ready READ ready NOTIFY readyChanged)
+
+public:
+    explicit PhotoPreview(QQuickItem* parent = 0);
+    virtual ~PhotoPreview();
+
+    QString path() const;
+    void setPath(const QString& path);
+    qreal exposure() const;
+    void setExposure(qreal exposure);
+    qreal brightness() const;
+    void setBrightness(qreal brightness);
+    qreal contrast() const;
+    void setContrast(qreal contrast);
+    qreal saturation() const;
+    void setSaturation(qreal saturation);
+    qreal hue() const;
+    void setHue(qreal hue);
+    QVariantList histogram() const;
+    bool ready() const;
+
+    Q_INVOKABLE void reset();
+
+    void paint(QPainter* painter) Q_DECL_OVERRIDE;
+
+Q_SIGNALS:
+    void pathChanged();
+    void exposureChanged();
+    void brightnessChanged();
+    void contrastChanged();
+    void saturationChanged();
+    void hueChanged();
+    void histogramChanged();
+    void readyChanged();
+
+private Q_SLOTS:
+    void proxyLoaded();
+
+private:
+    void loadProxy();
+    void render();
+
+    QString m_path;
+    qreal m_exposure;
+    qreal m_brightness;
+    qreal m_contrast;
+    qreal m_saturation;
+    qreal m_hue;
+
+    PhotoPreviewLoader* m_loader;
+    QImage m_proxy;
+    QImage m_preview;
+    int m_histogram[256];
+};
+
+#endif  // PHOTO_PREVIEW_H_
@@ -0,0 +1,413 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "photo-tile-provider.h"
+
+#include <QtGlobal>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDateTime>
+#include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QDirIterator>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QStringList>
+#include <QtCore/QUrl>
+#include <QtGui/QImageReader>
+
+#include <utime.h>
+
+const char* PhotoTileProvider::PROVIDER_ID = "phototile";
+const int PhotoTileProvider::TILE_SIZE = 256;
+
+// Maximum amount of decoded tiles kept in memory, in kilobytes.
+static const int MEMORY_CACHE_SIZE = 64 * 1024;
+
+// Maximum size of the tiles kept on disk, in bytes, and the size pruning
+// brings them down to.
+static const qint64 DISK_CACHE_SIZE = 256 * 1024 * 1024;
+static const qint64 DISK_CACHE_PRUNED_SIZE = 192 * 1024 * 1024;
+
+// Number of photos shown last whose tiles are never pruned.
+static const int RECENT_PHOTOS = 4;
+
+PhotoTileProvider::PhotoTileProvider()
+    : QQuickImageProvider(QQuickImageProvider::Image),
+      m_tiles(MEMORY_CACHE_SIZE),
+      m_diskCacheSize(-1),
+      m_pendingBytes(0),
+      m_pruning(false)
+{
+    m_cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+                 "/photo-tiles";
+}
+
+PhotoTileProvider::~PhotoTileProvider()
+{
+}
+
+/*!
+ * \brief PhotoTileProvider::levelCount
+ * \param photoSize size of the full resolution photo
+ * \return the number of levels in the pyramid, the last one being the first
+ * that fits in a single tile
+ */
+int PhotoTileProvider::levelCount(const QSize& photoSize)
+{
+    int count = 1;
+    int extent = qMax(photoSize.width(), photoSize.height());
+    while (extent > TILE_SIZE) {
+        extent = (extent + 1) / 2;
+        count++;
+    }
+    return count;
+}
+
+/*!
+ * \brief PhotoTileProvider::levelSize
+ * \param photoSize size of the full resolution photo
+ * \param level pyramid level, 0 being the full resolution
+ * \return the size of the photo at the given level
+ */
+QSize PhotoTileProvider::levelSize(const QSize& photoSize, int level)
+{
+    int divisor = 1 << level;
+    return QSize(qMax(1, (photoSize.width() + divisor - 1) / divisor),
+                 qMax(1, (photoSize.height() + divisor - 1) / divisor));
+}
+
+QImage PhotoTileProvider::requestImage(const QString& id,
+                                       QSize* size, const QSize& requestedSize)
+{
+    Q_UNUSED(requestedSize);
+
+    // Tiles are always served at their native size, the requested size is
+    // only meaningful for the whole photo provider.
+    QStringList parts = id.split('/');
+    bool levelOk, columnOk, rowOk;
+    int level = parts.value(0).toInt(&levelOk);
+    int column = parts.value(1).toInt(&columnOk);
+    int row = parts.value(2).toInt(&rowOk);
+    if (parts.size() < 4 || !levelOk || !columnOk || !rowOk ||
+        level < 0 || column < 0 || row < 0) {
+        qWarning() << "Invalid photo tile request" << id;
+        return QImage();
+    }
+
+    QString filePath = QUrl(id.section('/', 3)).path();
+    QFileInfo file(filePath);
+    if (!file.exists()) {
+        return QImage();
+    }
+
+    QString key = cacheKey(file);
+    markUsed(key);
+    QString tileKey = QString("%1/%2/%3/%4").arg(key).arg(level).arg(column).arg(row);
+
+    QImage tile;
+    {
+        QMutexLocker locker(&m_mutex);
+        QImage* cached = m_tiles.object(tileKey);
+        if (cached) {
+            tile = *cached;
+        }
+    }
+
+    if (tile.isNull()) {
+        QString diskPath = diskTilePath(key, level, column, row);
+        if (QFileInfo::exists(diskPath)) {
+            tile = QImage(diskPath);
+            if (!tile.isNull()) {
+                QMutexLocker locker(&m_mutex);
+                m_tiles.insert(tileKey, new QImage(tile), tile.byteCount() / 1024);
+            }
+        }
+    }
+
+    if (tile.isNull()) {
+        tile = buildTiles(key, filePath, level, column, row);
+    }
+
+    if (size != NULL) {
+        *size = tile.size();
+    }
+
+    return tile;
+}
+
+/*!
+ * \brief PhotoTileProvider::cacheKey
+ * The key changes whenever the photo file is edited, so that stale tiles are
+ * never served after an edit.
+ */
+QString PhotoTileProvider::cacheKey(const QFileInfo& file) const
+{
+    QString identity = QString("%1:%2:%3").arg(file.absoluteFilePath())
+                                          .arg(file.size())
+                                          .arg(file.lastModified().toMSecsSinceEpoch());
+    return QCryptographicHash::hash(identity.toUtf8(),
+                                    QCryptographicHash::Sha1).toHex();
+}
+
+QString PhotoTileProvider::diskTilePath(const QString& key, int level,
+                                        int column, int row) const
+{
+    return QString("%1/%2/%3/%4_%5.png").arg(m_cacheDir).arg(key).arg(level)
+                                        .arg(column).arg(row);
+}
+
+/*!
+ * \brief PhotoTileProvider::loadLevel decodes the photo directly at the
+ * given size, letting the image format scale while decoding when possible.
+ * \param size size of the decoded image after orientation correction
+ */
+QImage PhotoTileProvider::loadLevel(const QString& filePath, const QSize& size) const
+{
+    QImageReader reader(filePath);
+    QSize decodeSize(size);
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 5, 0))
+    reader.setAutoTransform(true);
+    // The scaled size applies before the orientation is corrected.
+    if (reader.transformation() & QImageIOHandler::TransformationRotate90) {
+        decodeSize.transpose();
+    }
+#endif
+    if (decodeSize != reader.size()) {
+        reader.setScaledSize(decodeSize);
+    }
+
+    QImage image = reader.read();
+    if (image.isNull()) {
+        qWarning() << "Error decoding" << filePath << "for tiling:"
+                   << reader.errorString();
+    }
+    return image;
+}
+
+/*!
+ * \brief PhotoTileProvider::buildTiles decodes a whole level of the pyramid
+ * and splits it in tiles, storing all of them in the memory and disk caches
+ * so that the level never needs to be decoded again.
+ * \return the tile at the given column and row
+ */
+QImage PhotoTileProvider::buildTiles(const QString& key, const QString& filePath,
+                                     int level, int column, int row)
+{
+    // Only decode a level once even if several of its tiles are requested
+    // concurrently.
+    QSharedPointer<QMutex> lock = levelLock(QString("%1/%2").arg(key).arg(level));
+    QMutexLocker buildLocker(lock.data());
+
+    QString diskPath = diskTilePath(key, level, column, row);
+    if (QFileInfo::exists(diskPath)) {
+        return QImage(diskPath);
+    }
+
+    QImageReader reader(filePath);
+    QSize photoSize = reader.size();
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 5, 0))
+    reader.setAutoTransform(true);
+    if (reader.transformation() & QImageIOHandler::TransformationRotate90) {
+        photoSize.transpose();
+    }
+#endif
+    if (!photoSize.isValid() || level >= levelCount(photoSize)) {
+        return QImage();
+    }
+
+    QImage levelImage = loadLevel(filePath, levelSize(photoSize, level));
+    if (levelImage.isNull()) {
+        return QImage();
+    }
+
+    QString levelDir = QFileInfo(diskPath).absolutePath();
+    if (!QDir().mkpath(levelDir)) {
+        qWarning() << "Unable to create tile cache directory" << levelDir;
+    }
+
+    QImage requested;
+    qint64 written = 0;
+    int columns = (levelImage.width() + TILE_SIZE - 1) / TILE_SIZE;
+    int rows = (levelImage.height() + TILE_SIZE - 1) / TILE_SIZE;
+    for (int j = 0; j < rows; j++) {
+        for (int i = 0; i < columns; i++) {
+            QImage tile = levelImage.copy(i * TILE_SIZE, j * TILE_SIZE,
+                                          qMin(TILE_SIZE, levelImage.width() - i * TILE_SIZE),
+                                          qMin(TILE_SIZE, levelImage.height() - j * TILE_SIZE));
+            QString tilePath = diskTilePath(key, level, i, j);
+            if (tile.save(tilePath, "png")) {
+                written += QFileInfo(tilePath).size();
+            }
+
+            QString tileKey = QString("%1/%2/%3/%4").arg(key).arg(level).arg(i).arg(j);
+            {
+                QMutexLocker locker(&m_mutex);
+                m_tiles.insert(tileKey, new QImage(tile), tile.byteCount() / 1024);
+            }
+
+            if (i == column && j == row) {
+                requested = tile;
+            }
+        }
+    }
+
+    buildLocker.unlock();
+    addDiskUsage(written);
+
+    return requested;
+}
+
+/*!
+ * \brief PhotoTileProvider::levelLock
+ * \return the lock serializing the builds of the given level, which is shared
+ * by the requests for that level in progress and dropped after them
+ */
+QSharedPointer<QMutex> PhotoTileProvider::levelLock(const QString& levelKey)
+{
+    QMutexLocker locker(&m_mutex);
+
+    QSharedPointer<QMutex> lock = m_levelLocks.value(levelKey).toStrongRef();
+    if (lock.isNull()) {
+        QMutableHashIterator<QString, QWeakPointer<QMutex> > it(m_levelLocks);
+        while (it.hasNext()) {
+            if (it.next().value().isNull()) {
+                it.remove();
+            }
+        }
+
+        lock = QSharedPointer<QMutex>(new QMutex);
+        m_levelLocks.insert(levelKey, lock);
+    }
+    return lock;
+}
+
+/*!
+ * \brief PhotoTileProvider::markUsed records the photo as recently shown, by
+ * touching its directory in the disk cache, so that its tiles are the last to
+ * be pruned. The first request also measures the disk cache, pruning it if it
+ * is over budget.
+ */
+void PhotoTileProvider::markUsed(const QString& key)
+{
+    bool measure = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        int index = m_recentKeys.indexOf(key);
+        if (index >= 0) {
+            m_recentKeys.move(index, 0);
+            return;
+        }
+
+        m_recentKeys.prepend(key);
+        while (m_recentKeys.size() > RECENT_PHOTOS) {
+            m_recentKeys.removeLast();
+        }
+
+        measure = m_diskCacheSize < 0 && !m_pruning;
+        m_pruning = m_pruning || measure;
+    }
+
+    // Done here rather than in the constructor, which runs on the GUI thread.
+    if (measure) {
+        pruneDiskCache();
+    }
+
+    QString keyDir = QString("%1/%2").arg(m_cacheDir).arg(key);
+    if (QFileInfo::exists(keyDir)) {
+        utime(keyDir.toUtf8(), NULL);
+    }
+}
+
+/*!
+ * \brief PhotoTileProvider::addDiskUsage accounts for tiles written to disk,
+ * and prunes the disk cache when they take it over DISK_CACHE_SIZE
+ */
+void PhotoTileProvider::addDiskUsage(qint64 bytes)
+{
+    bool prune = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_pruning) {
+            m_pendingBytes += bytes;
+            return;
+        }
+
+        m_diskCacheSize += bytes;
+        prune = m_diskCacheSize > DISK_CACHE_SIZE;
+        m_pruning = prune;
+    }
+
+    if (prune) {
+        pruneDiskCache();
+    }
+}
+
+static qint64 directorySize(const QString& path)
+{
+    qint64 size = 0;
+    QDirIterator it(path, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        size += it.fileInfo().size();
+    }
+    return size;
+}
+
+/*!
+ * \brief PhotoTileProvider::pruneDiskCache measures the disk cache and, if it
+ * is over DISK_CACHE_SIZE, removes the tiles of the photos least recently
+ * shown down to DISK_CACHE_PRUNED_SIZE. The photos shown last are kept.
+ */
+void PhotoTileProvider::pruneDiskCache()
+{
+    QStringList recentKeys;
+    {
+        QMutexLocker locker(&m_mutex);
+        recentKeys = m_recentKeys;
+    }
+
+    QDir cacheDir(m_cacheDir);
+    QFileInfoList keyDirs = cacheDir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot,
+                                                   QDir::Time | QDir::Reversed);
+
+    QList<qint64> sizes;
+    qint64 total = 0;
+    Q_FOREACH(const QFileInfo& keyDir, keyDirs) {
+        sizes.append(directorySize(keyDir.absoluteFilePath()));
+        total += sizes.last();
+    }
+
+    if (total > DISK_CACHE_SIZE) {
+        for (int i = 0; i < keyDirs.size() && total > DISK_CACHE_PRUNED_SIZE; i++) {
+            QString path = keyDirs.at(i).absoluteFilePath();
+            if (recentKeys.contains(keyDirs.at(i).fileName())) {
+                continue;
+            }
+            if (QDir(path).removeRecursively()) {
+                total -= sizes.at(i);
+            } else {
+                qWarning() << "Unable to prune tile cache directory" << path;
+            }
+        }
+    }
+
+    // Tiles written meanwhile may be counted twice, which only makes the next
+    // prune come a little early.
+    QMutexLocker locker(&m_mutex);
+    m_diskCacheSize = total + m_pendingBytes;
+    m_pendingBytes = 0;
+    m_pruning = false;
+}
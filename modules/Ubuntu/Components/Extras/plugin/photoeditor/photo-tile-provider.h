@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PHOTO_TILE_PROVIDER_H_
+#define PHOTO_TILE_PROVIDER_H_
+
+#include <QtQuick/QQuickImageProvider>
+#include <QtCore/QCache>
+#include <QtCore/QFileInfo>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QWeakPointer>
+#include <QtCore/QSize>
+#include <QtGui/QImage>
+
+/*!
+ * \brief The PhotoTileProvider class
+ *
+ * Serves a photo as a multi-resolution pyramid of square tiles, so that the
+ * UI can show a deep zoom of very large photos by requesting only the tiles
+ * that are visible at the current zoom level.
+ *
+ * Level 0 is the full resolution image, and every following level halves the
+ * size of the previous one. Tiles are requested with ids of the form:
+ *   image://phototile/<level>/<column>/<row>/<path to photo>
+ *
+ * Levels are built lazily from a scaled decode of the photo the first time
+ * one of their tiles is needed, and tiles are kept both in memory and in an
+ * on-disk cache keyed by the photo path, size and modification time. The
+ * disk cache is kept under a size budget by dropping the tiles of the photos
+ * least recently shown, sparing the few shown last.
+ */
+class PhotoTileProvider : public QQuickImageProvider
+{
+public:
+    static const char* PROVIDER_ID;
+    static const int TILE_SIZE;
+
+    PhotoTileProvider();
+    virtual ~PhotoTileProvider();
+
+    virtual QImage requestImage(const QString& id, QSize* size,
+                                const QSize& requestedSize);
+
+    static int levelCount(const QSize& photoSize);
+    static QSize levelSize(const QSize& photoSize, int level);
+
+private:
+    QString cacheKey(const QFileInfo& file) const;
+    QString diskTilePath(const QString& key, int level, int column, int row) const;
+    QImage loadLevel(const QString& filePath, const QSize& size) const;
+    QImage buildTiles(const QString& key, const QString& filePath, int level,
+                      int column, int row);
+    QSharedPointer<QMutex> levelLock(const QString& levelKey);
+    void markUsed(const QString& key);
+    void addDiskUsage(qint64 bytes);
+    void pruneDiskCache();
+
+    QString m_cacheDir;
+    QCache<QString, QImage> m_tiles;
+    QMutex m_mutex;
+    // One lock per level being built, so that different levels and photos
+    // are built in parallel.
+    QHash<QString, QWeakPointer<QMutex> > m_levelLocks;
+    // Photos shown last, the most recent first.
+    QStringList m_recentKeys;
+    // Size of the disk cache in bytes, -1 until it is first measured.
+    qint64 m_diskCacheSize;
+    qint64 m_pendingBytes;
+    bool m_pruning;
+};
+
+#endif // PHOTO_TILE_PROVIDER_H_
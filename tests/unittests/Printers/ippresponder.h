@@ -0,0 +1,303 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USC_PRINTERS_IPPRESPONDER_H
+#define USC_PRINTERS_IPPRESPONDER_H
+
+#include <cups/ipp.h>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <functional>
+
+#include <QByteArray>
+#include <QDebug>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+
+class IppResponderThread : public QThread
+{
+public:
+    explicit IppResponderThread(const std::function<void()> &body)
+        : QThread(Q_NULLPTR)
+        , m_body(body)
+    {
+    }
+
+protected:
+    void run() Q_DECL_OVERRIDE
+    {
+        m_body();
+    }
+
+private:
+    std::function<void()> m_body;
+};
+
+/* Stands in for cupsd: a minimal HTTP server on the loopback interface that
+answers IPP requests with the responses of a handler. Every connection is
+served on a thread of its own, so a handler may block to hold a request the
+way cupsd holds a long poll. The CUPS library is pointed at it with the
+CUPS_SERVER environment variable, set before its first request. */
+class IppResponder
+{
+public:
+    /* Returns the response to a request, or null to close the connection
+    instead. Called on the thread of the connection. */
+    typedef std::function<ipp_t*(ipp_t *request)> Handler;
+
+    explicit IppResponder(const Handler &handler)
+        : m_handler(handler)
+    {
+        m_listener = socket(AF_INET, SOCK_STREAM, 0);
+
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        if (bind(m_listener, (sockaddr*) &address, length) != 0
+                || listen(m_listener, 16) != 0
+                || getsockname(m_listener, (sockaddr*) &address, &length) != 0) {
+            qWarning() << "Unable to listen for IPP requests:" << strerror(errno);
+        }
+        m_port = ntohs(address.sin_port);
+
+        m_acceptor = new IppResponderThread([this]() { acceptConnections(); });
+        m_acceptor->start();
+    }
+
+    ~IppResponder()
+    {
+        shutdown(m_listener, SHUT_RDWR);
+        m_acceptor->wait();
+        delete m_acceptor;
+        close(m_listener);
+
+        m_lock.lock();
+        Q_FOREACH(int socket, m_sockets) {
+            shutdown(socket, SHUT_RDWR);
+        }
+        m_lock.unlock();
+
+        Q_FOREACH(IppResponderThread *thread, m_threads) {
+            thread->wait();
+            delete thread;
+        }
+    }
+
+    // The value of CUPS_SERVER that makes the CUPS library use this server.
+    QByteArray server() const
+    {
+        return "127.0.0.1:" + QByteArray::number(m_port);
+    }
+
+    // A successful response to the request, for the handler to fill.
+    static ipp_t* newResponse(ipp_t *request, const ipp_status_t status = IPP_OK)
+    {
+        ipp_t *response = ippNewResponse(request);
+        ippSetStatusCode(response, status);
+        return response;
+    }
+
+private:
+    struct Buffer
+    {
+        QByteArray data;
+        int position = 0;
+    };
+
+    static ssize_t readBuffer(void *context, ipp_uchar_t *data, size_t bytes)
+    {
+        Buffer *buffer = static_cast<Buffer*>(context);
+        int count = qMin((int) bytes, buffer->data.size() - buffer->position);
+        memcpy(data, buffer->data.constData() + buffer->position, count);
+        buffer->position += count;
+        return count;
+    }
+
+    static ssize_t writeBuffer(void *context, ipp_uchar_t *data, size_t bytes)
+    {
+        static_cast<Buffer*>(context)->data.append((const char*) data, bytes);
+        return bytes;
+    }
+
+    static bool receive(const int socket, QByteArray &buffer)
+    {
+        char data[4096];
+        ssize_t count = recv(socket, data, sizeof(data), 0);
+        if (count <= 0) {
+            return false;
+        }
+        buffer.append(data, count);
+        return true;
+    }
+
+    static bool sendAll(const int socket, const QByteArray &data)
+    {
+        int sent = 0;
+        while (sent < data.size()) {
+            ssize_t count = send(socket, data.constData() + sent,
+                                 data.size() - sent, MSG_NOSIGNAL);
+            if (count <= 0) {
+                return false;
+            }
+            sent += count;
+        }
+        return true;
+    }
+
+    /* Reads the next HTTP request of the connection into body. buffer keeps
+    what was received beyond it. */
+    static bool readRequest(const int socket, QByteArray &buffer,
+                            QByteArray &body)
+    {
+        int end;
+        while ((end = buffer.indexOf("\r\n\r\n")) < 0) {
+            if (!receive(socket, buffer)) {
+                return false;
+            }
+        }
+
+        QList<QByteArray> lines = buffer.left(end).split('\n');
+        buffer.remove(0, end + 4);
+
+        int length = 0;
+        bool chunked = false;
+        for (int i = 1; i < lines.size(); i++) {
+            int colon = lines.at(i).indexOf(':');
+            QByteArray name = lines.at(i).left(colon).trimmed().toLower();
+            QByteArray value = lines.at(i).mid(colon + 1).trimmed().toLower();
+            if (name == "content-length") {
+                length = value.toInt();
+            } else if (name == "transfer-encoding") {
+                chunked = value.contains("chunked");
+            } else if (name == "expect" && value == "100-continue") {
+                if (!sendAll(socket, "HTTP/1.1 100 Continue\r\n\r\n")) {
+                    return false;
+                }
+            }
+        }
+
+        body.clear();
+        if (!chunked) {
+            while (buffer.size() < length) {
+                if (!receive(socket, buffer)) {
+                    return false;
+                }
+            }
+            body = buffer.left(length);
+            buffer.remove(0, length);
+            return true;
+        }
+
+        Q_FOREVER {
+            while ((end = buffer.indexOf("\r\n")) < 0) {
+                if (!receive(socket, buffer)) {
+                    return false;
+                }
+            }
+            int size = buffer.left(end).split(';').first().trimmed().toInt(Q_NULLPTR, 16);
+            buffer.remove(0, end + 2);
+
+            while (buffer.size() < size + 2) {
+                if (!receive(socket, buffer)) {
+                    return false;
+                }
+            }
+            body.append(buffer.left(size));
+            buffer.remove(0, size + 2);
+
+            if (size == 0) {
+                return true;
+            }
+        }
+    }
+
+    void acceptConnections()
+    {
+        Q_FOREVER {
+            int socket = accept(m_listener, Q_NULLPTR, Q_NULLPTR);
+            if (socket < 0) {
+                return;
+            }
+
+            QMutexLocker locker(&m_lock);
+            m_sockets << socket;
+            auto thread = new IppResponderThread([this, socket]() {
+                serve(socket);
+            });
+            m_threads << thread;
+            thread->start();
+        }
+    }
+
+    void serve(const int socket)
+    {
+        QByteArray buffer;
+        QByteArray body;
+        while (readRequest(socket, buffer, body)) {
+            Buffer input;
+            input.data = body;
+            ipp_t *request = ippNew();
+            if (ippReadIO(&input, readBuffer, 1, Q_NULLPTR, request)
+                    != IPP_STATE_DATA) {
+                ippDelete(request);
+                break;
+            }
+
+            ipp_t *response = m_handler(request);
+            ippDelete(request);
+            if (!response) {
+                break;
+            }
+
+            Buffer output;
+            ippSetState(response, IPP_STATE_IDLE);
+            ippWriteIO(&output, writeBuffer, 1, Q_NULLPTR, response);
+            ippDelete(response);
+
+            QByteArray header = "HTTP/1.1 200 OK\r\n"
+                                "Content-Type: application/ipp\r\n"
+                                "Content-Length: "
+                    + QByteArray::number(output.data.size()) + "\r\n\r\n";
+            if (!sendAll(socket, header + output.data)) {
+                break;
+            }
+        }
+
+        QMutexLocker locker(&m_lock);
+        m_sockets.removeOne(socket);
+        close(socket);
+    }
+
+    Handler m_handler;
+    int m_listener = -1;
+    int m_port = 0;
+    IppResponderThread *m_acceptor = Q_NULLPTR;
+    QList<IppResponderThread*> m_threads;
+    QList<int> m_sockets;
+    QMutex m_lock;
+};
+
+#endif // USC_PRINTERS_IPPRESPONDER_H
@@ -288,6 +288,11 @@ public:
         return m_state;
     }
 
+    virtual qint64 configChangeTime() const override
+    {
+        return m_configChangeTime;
+    }
+
     virtual QList<QPageSize> supportedPageSizes() const override
     {
         return m_supportedPageSizes;
@@ -356,11 +361,44 @@ public:
     }
 
 
-    virtual void requestPrinter(const QString &printerName) override
+    virtual void requestPrinter(
+            const QString &printerName,
+            const TaskScheduler::Priority priority
+                = TaskScheduler::Priority::Background) override
     {
+        Q_UNUSED(priority);
         m_requestedPrinters << printerName;
     }
 
+    virtual void requestPrinterState(const QString &printerName) override
+    {
+        m_requestedPrinterStates << printerName;
+    }
+
+    virtual void requestPrinterOptions(const QString &printerName,
+                                       const QStringList &options) override
+    {
+        // Like cupsd, loads them in the background if asked to.
+        if (m_asyncOptions) {
+            m_requestedOptions << options;
+        } else {
+            PrinterBackend::requestPrinterOptions(printerName, options);
+        }
+    }
+
+    virtual void requestJobs() override
+    {
+        // The list is then delivered by mockJobListLoaded.
+        if (!m_asyncJobs) {
+            PrinterBackend::requestJobs();
+        }
+    }
+
+    virtual void setStateInternal(const PrinterEnum::State &state) override
+    {
+        m_state = state;
+    }
+
     virtual void requestJobExtendedAttributes(QSharedPointer<Printer> printer, QSharedPointer<PrinterJob> job) override
     {
         QMap<QString, QVariant> attributes = printerGetJobAttributes(printer->name(), job->jobId());
@@ -397,6 +435,18 @@ public:
         Q_EMIT printerModified(text, printerUri, printerName, printerState, printerStateReason, acceptingJobs);
     }
 
+    void mockPrinterStateChanged(
+        const QString &text,
+        const QString &printerUri,
+        const QString &printerName,
+        uint printerState,
+        const QString &printerStateReason,
+        bool acceptingJobs
+    )
+    {
+        Q_EMIT printerStateChanged(text, printerUri, printerName, printerState, printerStateReason, acceptingJobs);
+    }
+
     void mockPrinterDeleted(
         const QString &text,
         const QString &printerUri,
@@ -452,6 +502,16 @@ public:
         );
     }
 
+    void mockJobListLoaded(const QList<QSharedPointer<PrinterJob>> &jobs)
+    {
+        Q_EMIT jobListLoaded(jobs);
+    }
+
+    void mockDriversChunkLoaded(const QList<PrinterDriver> &drivers)
+    {
+        Q_EMIT printerDriversChunkLoaded(drivers);
+    }
+
     void mockDriversLoaded(const QList<PrinterDriver> &drivers)
     {
         Q_EMIT printerDriversLoaded(drivers);
@@ -467,6 +527,23 @@ public:
         Q_EMIT printerLoaded(printer);
     }
 
+    void mockPrinterStateLoaded(const PrinterStateAttributes &attributes)
+    {
+        Q_EMIT printerStateLoaded(attributes);
+    }
+
+    void mockPrinterOptionsLoaded(const QString &printerName,
+                                  const QStringList &options)
+    {
+        Q_EMIT printerOptionsLoaded(printerName, options,
+                                    printerGetOptions(printerName, options));
+    }
+
+    void mockJobsLoaded(const QList<JobAttributes> &jobs)
+    {
+        Q_EMIT jobsLoaded(jobs);
+    }
+
     void mockDeviceFound(const Device &device)
     {
         Q_EMIT deviceFound(device);
@@ -493,6 +570,7 @@ public:
     QString m_defaultPrinterName = QString::null;
 
     PrinterEnum::State m_state = PrinterEnum::State::IdleState;
+    qint64 m_configChangeTime = -1;
 
     QPageSize m_defaultPageSize;
     QList<QPageSize> m_supportedPageSizes;
@@ -503,6 +581,10 @@ public:
     QList<QSharedPointer<Printer>> m_availablePrinters;
     QList<QSharedPointer<PrinterJob>> m_jobs;
     QStringList m_requestedPrinters;
+    QStringList m_requestedPrinterStates;
+    bool m_asyncOptions = false;
+    bool m_asyncJobs = false;
+    QList<QStringList> m_requestedOptions;
 
     PrinterEnum::PrinterType m_type = PrinterEnum::PrinterType::ProxyType;
 
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "backend/capabilitycache.h"
+#include "structs.h"
+
+#include <QDebug>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+class TestCapabilityCache : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init()
+    {
+        QVERIFY(m_dir.isValid());
+        m_path = m_dir.path() + "/capabilities";
+        QFile::remove(m_path);
+    }
+    void testLookupMissing()
+    {
+        CapabilityCache cache(m_path);
+        PrinterCapabilities caps;
+        QVERIFY(!cache.lookup("printer-a", 1, &caps));
+    }
+    void testLookup()
+    {
+        CapabilityCache cache(m_path);
+        cache.store("printer-a", makeCapabilities(42));
+
+        PrinterCapabilities caps;
+        QVERIFY(cache.lookup("printer-a", 42, &caps));
+        QCOMPARE(caps.defaultColorModel, makeCapabilities(42).defaultColorModel);
+    }
+    void testChangeTimeMismatch()
+    {
+        CapabilityCache cache(m_path);
+        cache.store("printer-a", makeCapabilities(42));
+
+        PrinterCapabilities caps;
+        QVERIFY(!cache.lookup("printer-a", 43, &caps));
+        QVERIFY(!cache.lookup("printer-a", -1, &caps));
+    }
+    void testStaleEntryDropped()
+    {
+        CapabilityCache cache(m_path);
+        cache.store("printer-a", makeCapabilities(42));
+
+        PrinterCapabilities caps;
+        QVERIFY(!cache.lookup("printer-a", 43, &caps));
+        QVERIFY(!cache.lookup("printer-a", 42, &caps));
+    }
+    void testPrinterDeleted()
+    {
+        CapabilityCache cache(m_path);
+        cache.store("printer-a", makeCapabilities(42));
+        cache.store("printer-a/instance", makeCapabilities(42));
+        cache.store("printer-b", makeCapabilities(42));
+        cache.printerDeleted("", "", "printer-a", 0, "", true);
+
+        PrinterCapabilities caps;
+        QVERIFY(!cache.lookup("printer-a", 42, &caps));
+        QVERIFY(!cache.lookup("printer-a/instance", 42, &caps));
+        QVERIFY(cache.lookup("printer-b", 42, &caps));
+    }
+    void testWritesBatched()
+    {
+        CapabilityCache cache(m_path);
+        cache.store("printer-a", makeCapabilities(42));
+        cache.store("printer-b", makeCapabilities(42));
+        QVERIFY(!QFile::exists(m_path));
+
+        QTRY_VERIFY(QFile::exists(m_path));
+        CapabilityCache other(m_path);
+        PrinterCapabilities caps;
+        QVERIFY(other.lookup("printer-a", 42, &caps));
+        QVERIFY(other.lookup("printer-b", 42, &caps));
+    }
+    void testNotStoredWithoutChangeTime()
+    {
+        CapabilityCache cache(m_path);
+        cache.store("printer-a", makeCapabilities(-1));
+        QVERIFY(!QFile::exists(m_path));
+    }
+    void testRemove()
+    {
+        CapabilityCache cache(m_path);
+        cache.store("printer-a", makeCapabilities(42));
+        cache.remove("printer-a");
+
+        PrinterCapabilities caps;
+        QVERIFY(!cache.lookup("printer-a", 42, &caps));
+    }
+    void testPersisted()
+    {
+        PrinterCapabilities expected = makeCapabilities(42);
+        {
+            CapabilityCache cache(m_path);
+            cache.store("printer-a", expected);
+        }
+
+        CapabilityCache cache(m_path);
+        PrinterCapabilities caps;
+        QVERIFY(cache.lookup("printer-a", 42, &caps));
+
+        QCOMPARE(caps.changeTime, expected.changeTime);
+        QCOMPARE(caps.hasPpd, true);
+        QCOMPARE(caps.defaultColorModel, expected.defaultColorModel);
+        QCOMPARE(caps.supportedColorModels, expected.supportedColorModels);
+        QCOMPARE(caps.defaultPrintQuality, expected.defaultPrintQuality);
+        QCOMPARE(caps.supportedPrintQualities, expected.supportedPrintQualities);
+        QCOMPARE(caps.supportedPageSizes, expected.supportedPageSizes);
+        QCOMPARE(caps.defaultPageSize, expected.defaultPageSize);
+        QCOMPARE(caps.supportedResolutions, expected.supportedResolutions);
+        QCOMPARE(caps.defaultDuplexMode, expected.defaultDuplexMode);
+        QCOMPARE(caps.supportedDuplexModes, expected.supportedDuplexModes);
+    }
+    void testCorruptFileIgnored()
+    {
+        QFile file(m_path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("not a cache");
+        file.close();
+
+        CapabilityCache cache(m_path);
+        PrinterCapabilities caps;
+        QVERIFY(!cache.lookup("printer-a", 42, &caps));
+    }
+private:
+    PrinterCapabilities makeCapabilities(const qint64 changeTime)
+    {
+        PrinterCapabilities caps;
+        caps.changeTime = changeTime;
+        caps.hasPpd = true;
+
+        ColorModel gray;
+        gray.name = "Gray";
+        gray.text = "Grayscale";
+        gray.colorType = PrinterEnum::ColorModelType::GrayType;
+        gray.originalOption = "ColorModel";
+        ColorModel rgb;
+        rgb.name = "RGB";
+        rgb.text = "Color";
+        rgb.colorType = PrinterEnum::ColorModelType::ColorType;
+        rgb.originalOption = "ColorModel";
+        caps.defaultColorModel = rgb;
+        caps.supportedColorModels << gray << rgb;
+
+        PrintQuality draft;
+        draft.name = "Draft";
+        draft.text = "Draft";
+        draft.originalOption = "PrintQuality";
+        caps.defaultPrintQuality = draft;
+        caps.supportedPrintQualities << draft;
+
+        caps.supportedPageSizes << QPageSize(QPageSize::A4)
+                                << QPageSize(QPageSize::Letter);
+        caps.defaultPageSize = QPageSize(QPageSize::A4);
+        caps.supportedResolutions << 300 << 600;
+        caps.defaultDuplexMode = PrinterEnum::DuplexMode::DuplexLongSide;
+        caps.supportedDuplexModes << PrinterEnum::DuplexMode::DuplexNone
+                                  << PrinterEnum::DuplexMode::DuplexLongSide;
+        return caps;
+    }
+
+    QTemporaryDir m_dir;
+    QString m_path;
+};
+
+QTEST_GUILESS_MAIN(TestCapabilityCache)
+#include "tst_capabilitycache.moc"
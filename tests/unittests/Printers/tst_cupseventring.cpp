@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cups/cupsnotifier.h"
+
+#include <QDebug>
+#include <QObject>
+#include <QTest>
+#include <QThread>
+
+class RingProducer : public QThread
+{
+public:
+    RingProducer(CupsEventRing *ring, const uint count)
+        : m_ring(ring), m_count(count)
+    {
+    }
+
+protected:
+    void run() override
+    {
+        for (uint i = 0; i < m_count; i++) {
+            CupsEvent event;
+            event.type = CupsEvent::Type::JobState;
+            event.jobId = i;
+            event.printerName = QString::number(i);
+            while (!m_ring->push(event)) {
+                QThread::yieldCurrentThread();
+            }
+        }
+    }
+
+private:
+    CupsEventRing *m_ring;
+    uint m_count;
+};
+
+class TestCupsEventRing : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testCapacity()
+    {
+        QCOMPARE(CupsEventRing(1000).capacity(), 1024);
+        QCOMPARE(CupsEventRing(4).capacity(), 4);
+        QCOMPARE(CupsEventRing(0).capacity(), 2);
+    }
+    void testEmpty()
+    {
+        CupsEventRing ring(4);
+        CupsEvent event;
+        QVERIFY(ring.isEmpty());
+        QVERIFY(!ring.pop(event));
+    }
+    void testOrder()
+    {
+        CupsEventRing ring(4);
+        CupsEvent event;
+
+        // Wraps around a few times.
+        for (uint i = 0; i < 10; i++) {
+            event.jobId = i;
+            event.printerName = QString::number(i);
+            QVERIFY(ring.push(event));
+            QVERIFY(!ring.isEmpty());
+
+            CupsEvent popped;
+            QVERIFY(ring.pop(popped));
+            QCOMPARE(popped.jobId, i);
+            QCOMPARE(popped.printerName, QString::number(i));
+        }
+        QVERIFY(ring.isEmpty());
+    }
+    void testFull()
+    {
+        CupsEventRing ring(4);
+        CupsEvent event;
+        for (uint i = 0; i < 4; i++) {
+            event.jobId = i;
+            QVERIFY(ring.push(event));
+        }
+
+        event.jobId = 4;
+        QVERIFY(!ring.push(event));
+
+        // Room is made by popping.
+        CupsEvent popped;
+        QVERIFY(ring.pop(popped));
+        QCOMPARE(popped.jobId, (uint) 0);
+        QVERIFY(ring.push(event));
+
+        for (uint i = 1; i < 5; i++) {
+            QVERIFY(ring.pop(popped));
+            QCOMPARE(popped.jobId, i);
+        }
+        QVERIFY(!ring.pop(popped));
+    }
+    void testThreads()
+    {
+        const uint count = 100000;
+        CupsEventRing ring(64);
+        RingProducer producer(&ring, count);
+        producer.start();
+
+        uint next = 0;
+        CupsEvent event;
+        while (next < count) {
+            if (!ring.pop(event)) {
+                QThread::yieldCurrentThread();
+                continue;
+            }
+
+            QCOMPARE(event.type, CupsEvent::Type::JobState);
+            QCOMPARE(event.jobId, next);
+            QCOMPARE(event.printerName, QString::number(next));
+            next++;
+        }
+
+        QVERIFY(producer.wait(10000));
+        QVERIFY(ring.isEmpty());
+    }
+};
+
+QTEST_GUILESS_MAIN(TestCupsEventRing)
+#include "tst_cupseventring.moc"
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "backend/devicecache.h"
+#include "structs.h"
+
+#include <QDebug>
+#include <QObject>
+#include <QSignalSpy>
+#include <QTest>
+
+class TestDeviceCache : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testEmpty()
+    {
+        DeviceCache cache(60000);
+        QVERIFY(!cache.isFresh());
+        QVERIFY(!cache.isSearching());
+        QVERIFY(cache.devices().isEmpty());
+    }
+    void testSearch()
+    {
+        DeviceCache cache(60000);
+        cache.begin();
+        QVERIFY(cache.isSearching());
+
+        Device a; a.uri = "usb://HP/LaserJet?serial=1";
+        Device b; b.uri = "usb://hp/LaserJet/?serial=1";
+        Device c; c.uri = "socket://10.0.0.2";
+        QVERIFY(cache.insert(a));
+        QVERIFY(!cache.insert(b));
+        QVERIFY(cache.insert(c));
+
+        // Not fresh until the search finishes.
+        QVERIFY(!cache.isFresh());
+        cache.finish();
+        QVERIFY(cache.isFresh());
+        QCOMPARE(cache.devices().size(), 2);
+        QCOMPARE(cache.devices().at(0).uri, a.uri);
+    }
+    void testExpiry()
+    {
+        DeviceCache cache(50);
+        cache.begin();
+        cache.finish();
+        QVERIFY(cache.isFresh());
+        QTRY_VERIFY(!cache.isFresh());
+    }
+    void testFinishesAfterAllParts()
+    {
+        DeviceCache cache(60000);
+        QSignalSpy finishedSpy(&cache, SIGNAL(searchFinished()));
+        cache.begin(2);
+
+        cache.finish();
+        QVERIFY(cache.isSearching());
+        QCOMPARE(finishedSpy.count(), 0);
+
+        cache.finish();
+        QVERIFY(!cache.isSearching());
+        QVERIFY(cache.isFresh());
+        QCOMPARE(finishedSpy.count(), 1);
+    }
+    void testFailedSearchNotReused()
+    {
+        DeviceCache cache(60000);
+        QSignalSpy finishedSpy(&cache, SIGNAL(searchFinished()));
+        cache.begin(2);
+        cache.fail();
+        cache.finish();
+        cache.finish();
+
+        QCOMPARE(finishedSpy.count(), 1);
+        QVERIFY(!cache.isSearching());
+        QVERIFY(!cache.isFresh());
+    }
+    void testBeginForgets()
+    {
+        DeviceCache cache(60000);
+        cache.begin();
+        Device a; a.uri = "socket://10.0.0.2";
+        cache.insert(a);
+        cache.finish();
+
+        cache.begin();
+        QVERIFY(cache.devices().isEmpty());
+        QVERIFY(cache.insert(a));
+    }
+};
+
+QTEST_GUILESS_MAIN(TestDeviceCache)
+#include "tst_devicecache.moc"
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "cups/drivercatalogue.h"
+#include "structs.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+class TestDriverCatalogue : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init()
+    {
+        QVERIFY(m_dir.isValid());
+        m_path = m_dir.path() + "/drivers";
+        QFile::remove(m_path);
+    }
+    void testOpenMissing()
+    {
+        DriverCatalogue catalogue(m_path);
+        QVERIFY(!catalogue.open(1));
+        QVERIFY(!catalogue.isOpen());
+        QCOMPARE(catalogue.count(), 0);
+    }
+    void testRoundTrip()
+    {
+        QList<PrinterDriver> drivers = makeDrivers();
+        QVERIFY(DriverCatalogue::write(m_path, 42, drivers));
+
+        DriverCatalogue catalogue(m_path);
+        QVERIFY(catalogue.open(42));
+        QCOMPARE(catalogue.count(), drivers.size());
+
+        for (int i = 0; i < drivers.size(); i++) {
+            PrinterDriver driver = catalogue.driver(i);
+            QCOMPARE(driver.name, drivers[i].name);
+            QCOMPARE(driver.deviceId, drivers[i].deviceId);
+            QCOMPARE(driver.language, drivers[i].language);
+            QCOMPARE(driver.makeModel, drivers[i].makeModel);
+        }
+        QCOMPARE(catalogue.drivers().size(), drivers.size());
+    }
+    void testLoadShared()
+    {
+        QList<PrinterDriver> drivers = makeDrivers();
+        QVERIFY(DriverCatalogue::write(m_path, 50, drivers));
+
+        QList<PrinterDriver> first;
+        QVERIFY(DriverCatalogue::load(m_path, 50, first));
+        QCOMPARE(first.size(), drivers.size());
+        QCOMPARE(first.at(3).name, drivers.at(3).name);
+        QCOMPARE(first.at(3).makeModel, drivers.at(3).makeModel);
+
+        // Repeated strings are shared, and so is the list of a second load.
+        QCOMPARE(first.at(0).deviceId.constData(),
+                 first.at(1).deviceId.constData());
+        QCOMPARE(first.at(0).language.constData(),
+                 first.at(2).language.constData());
+        QList<PrinterDriver> second;
+        QVERIFY(DriverCatalogue::load(m_path, 50, second));
+        QCOMPARE(second.at(0).name.constData(), first.at(0).name.constData());
+
+        // Drivers of a replaced catalogue stay valid.
+        QVERIFY(DriverCatalogue::write(m_path, 51, drivers.mid(0, 10)));
+        QList<PrinterDriver> third;
+        QVERIFY(DriverCatalogue::load(m_path, 51, third));
+        QCOMPARE(third.size(), 10);
+        QCOMPARE(first.at(99).name, drivers.at(99).name);
+
+        QList<PrinterDriver> stale;
+        QVERIFY(!DriverCatalogue::load(m_path, 52, stale));
+        QVERIFY(stale.isEmpty());
+    }
+    void testStringsInterned()
+    {
+        QList<PrinterDriver> drivers = makeDrivers();
+        QVERIFY(DriverCatalogue::write(m_path, 42, drivers));
+        qint64 size = QFileInfo(m_path).size();
+
+        // Twice the drivers, with the same strings, only adds the records.
+        QVERIFY(DriverCatalogue::write(m_path, 42, drivers + drivers));
+        QVERIFY(QFileInfo(m_path).size() - size < drivers.size() * 64);
+    }
+    void testStale()
+    {
+        QVERIFY(DriverCatalogue::write(m_path, 42, makeDrivers()));
+
+        DriverCatalogue catalogue(m_path);
+        QVERIFY(!catalogue.open(43));
+        QVERIFY(!catalogue.open(-1));
+    }
+    void testRemoteServer()
+    {
+        QVERIFY(DriverCatalogue::isLocalServer("/run/cups/cups.sock"));
+        QVERIFY(DriverCatalogue::isLocalServer("localhost"));
+        QVERIFY(!DriverCatalogue::isLocalServer("print.example.com"));
+        QCOMPARE(DriverCatalogue::ppdSourceStamp("print.example.com"), qint64(-1));
+    }
+    void testPathPerServer()
+    {
+        QVERIFY(DriverCatalogue::defaultPath("localhost")
+                != DriverCatalogue::defaultPath("print.example.com"));
+        QCOMPARE(DriverCatalogue::defaultPath("localhost"),
+                 DriverCatalogue::defaultPath("localhost"));
+    }
+    void testCorrupt()
+    {
+        QVERIFY(DriverCatalogue::write(m_path, 42, makeDrivers()));
+
+        QFile file(m_path);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QVERIFY(file.resize(file.size() - 1));
+        file.close();
+
+        DriverCatalogue catalogue(m_path);
+        QVERIFY(!catalogue.open(42));
+    }
+    void testSourceStamp()
+    {
+        QTemporaryDir source;
+        QVERIFY(source.isValid());
+
+        QCOMPARE(DriverCatalogue::sourceStamp(
+                     QStringList({source.path() + "/missing"})), (qint64) -1);
+        QVERIFY(DriverCatalogue::sourceStamp(
+                    QStringList({source.path()})) > 0);
+    }
+private:
+    QList<PrinterDriver> makeDrivers()
+    {
+        QList<PrinterDriver> drivers;
+        for (int i = 0; i < 100; i++) {
+            PrinterDriver driver;
+            driver.name = QString("drv:///sample.drv/model%1.ppd").arg(i).toUtf8();
+            driver.deviceId = "NONE";
+            driver.language = i % 2 ? "en" : "de";
+            driver.makeModel = QString("Sample Model %1").arg(i).toUtf8();
+            drivers << driver;
+        }
+        return drivers;
+    }
+
+    QTemporaryDir m_dir;
+    QString m_path;
+};
+
+QTEST_GUILESS_MAIN(TestDriverCatalogue)
+#include "tst_drivercatalogue.moc"
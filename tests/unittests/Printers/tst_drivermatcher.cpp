@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "models/drivermatcher.h"
+#include "structs.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTest>
+
+class TestDriverMatcher : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testParseDeviceId()
+    {
+        auto id = DriverMatcher::parseDeviceId(
+            "MFG:Hewlett-Packard;CMD:PJL,PCL,POSTSCRIPT;MDL:HP LaserJet 1020;CLS:PRINTER;");
+        QCOMPARE(id.manufacturer, QString("hp"));
+        QCOMPARE(id.model, QString("laserjet 1020"));
+        QCOMPARE(id.commandSets, QStringList({"pjl", "pcl", "postscript"}));
+    }
+    void testParseLongKeys()
+    {
+        auto id = DriverMatcher::parseDeviceId(
+            "MANUFACTURER:Canon;MODEL:PIXMA iP4200;COMMAND SET:BJL,BJRaster3;");
+        QCOMPARE(id.manufacturer, QString("canon"));
+        QCOMPARE(id.model, QString("pixma ip4200"));
+    }
+    void testMatch()
+    {
+        QList<PrinterDriver> drivers;
+        drivers << makeDriver("HP LaserJet 1022, hpcups", "NONE")
+                << makeDriver("HP LaserJet 1020 Foomatic/foo2zjs (recommended)", "NONE")
+                << makeDriver("Generic PostScript Printer", "NONE")
+                << makeDriver("HP LaserJet 1020, hpcups",
+                              "MFG:HP;MDL:LaserJet 1020;")
+                << makeDriver("Canon PIXMA iP4200", "NONE")
+                << makeDriver("HP LaserJet 1020 Foomatic/foo2zjs", "NONE");
+        DriverMatcher matcher(drivers);
+
+        QList<int> matches = matcher.match(
+            "MFG:Hewlett-Packard;CMD:PJL,POSTSCRIPT;MDL:HP LaserJet 1020;");
+
+        // The exact device id first, then recommended model matches, then
+        // generic drivers. Other models are left out.
+        QCOMPARE(matches, QList<int>({3, 1, 5, 2}));
+    }
+    void testMatchMakeModel()
+    {
+        QList<PrinterDriver> drivers;
+        drivers << makeDriver("Canon PIXMA iP4200", "NONE")
+                << makeDriver("Canon PIXMA iP4300", "NONE");
+        DriverMatcher matcher(drivers);
+
+        QCOMPARE(matcher.match("", "Canon PIXMA iP4200"), QList<int>({0}));
+    }
+    void testNoMatch()
+    {
+        QList<PrinterDriver> drivers;
+        drivers << makeDriver("Canon PIXMA iP4200", "NONE");
+        DriverMatcher matcher(drivers);
+
+        QVERIFY(matcher.match("MFG:Epson;MDL:Stylus;").isEmpty());
+        QVERIFY(matcher.match("").isEmpty());
+    }
+    void testMatchSpeed()
+    {
+        // About as many drivers as HP has in a full CUPS installation.
+        QList<PrinterDriver> drivers;
+        QStringList series({"LaserJet", "DeskJet", "OfficeJet Pro", "Color LaserJet"});
+        QStringList variants({"hpcups", "hpijs", "Postscript", "Foomatic/pxlmono"});
+        for (int i = 0; i < 3000; i++) {
+            drivers << makeDriver(
+                QString("HP %1 %2, %3").arg(series.at(i % series.size()))
+                    .arg(1000 + i / 4).arg(variants.at(i % variants.size())).toUtf8(),
+                "NONE");
+        }
+        DriverMatcher matcher(drivers);
+
+        // The model itself, then the other drivers with its number.
+        QList<int> matches = matcher.match("MFG:HP;MDL:LaserJet 1000;");
+        QCOMPARE(matches, QList<int>({0, 3, 1, 2}));
+
+        // A lookup scores the drivers of the model, not all of HP's.
+        const int lookups = 1000;
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < lookups; i++) {
+            matcher.match(QString("MFG:Hewlett-Packard;MDL:HP DeskJet %1;")
+                          .arg(1000 + i % 750));
+        }
+        QVERIFY2(timer.elapsed() < lookups,
+                 qPrintable(QString("%1 ms").arg(timer.elapsed())));
+    }
+private:
+    PrinterDriver makeDriver(const QByteArray &makeModel,
+                             const QByteArray &deviceId)
+    {
+        PrinterDriver driver;
+        driver.name = makeModel;
+        driver.makeModel = makeModel;
+        driver.deviceId = deviceId;
+        driver.language = "en";
+        return driver;
+    }
+};
+
+QTEST_GUILESS_MAIN(TestDriverMatcher)
+#include "tst_drivermatcher.moc"
@@ -123,6 +123,162 @@ private Q_SLOTS:
             );
         }
     }
+    void testFilterRanking()
+    {
+        PrinterDriver substring;
+        substring.makeModel = "Foo Multilaser 10";
+        PrinterDriver prefix;
+        prefix.makeModel = "Foo Laserjet 20";
+        PrinterDriver word;
+        word.makeModel = "Foo Laser 30";
+        PrinterDriver other;
+        other.makeModel = "Bar Inkjet 40";
+
+        m_model->load();
+        getBackend()->mockDriversLoaded(
+            QList<PrinterDriver>({substring, prefix, word, other}));
+
+        QSignalSpy filterCompleteSpy(m_model, SIGNAL(filterComplete()));
+        m_model->setFilter("laser");
+        QTRY_COMPARE(filterCompleteSpy.count(), 1);
+
+        // Whole words first, then prefixes, then other substrings.
+        QCOMPARE(m_model->rowCount(), 3);
+        QCOMPARE(m_model->data(m_model->index(0), DriverModel::Roles::MakeModelRole).toByteArray(),
+                 word.makeModel);
+        QCOMPARE(m_model->data(m_model->index(1), DriverModel::Roles::MakeModelRole).toByteArray(),
+                 prefix.makeModel);
+        QCOMPARE(m_model->data(m_model->index(2), DriverModel::Roles::MakeModelRole).toByteArray(),
+                 substring.makeModel);
+    }
+    void testFilterBackspace()
+    {
+        PrinterDriver canon;
+        canon.makeModel = "Canon 4500 Foojet";
+        PrinterDriver canon2;
+        canon2.makeModel = "Canon 4600 Barjet";
+
+        m_model->load();
+        getBackend()->mockDriversLoaded(QList<PrinterDriver>({canon, canon2}));
+
+        QSignalSpy filterCompleteSpy(m_model, SIGNAL(filterComplete()));
+        m_model->setFilter("canon 45");
+        QTRY_COMPARE(filterCompleteSpy.count(), 1);
+        QCOMPARE(m_model->rowCount(), 1);
+
+        // A shorter pattern widens the results again.
+        m_model->setFilter("canon 4");
+        QTRY_COMPARE(filterCompleteSpy.count(), 2);
+        QCOMPARE(m_model->rowCount(), 2);
+    }
+    void testFilterAfterCancel()
+    {
+        PrinterDriver canon;
+        canon.makeModel = "Canon 4500 Foojet";
+        PrinterDriver canon2;
+        canon2.makeModel = "Canon 4600 Barjet";
+
+        m_model->load();
+        getBackend()->mockDriversLoaded(QList<PrinterDriver>({canon, canon2}));
+
+        // Cancelling while the index builds keeps it for filtering.
+        m_model->cancel();
+        QSignalSpy filterCompleteSpy(m_model, SIGNAL(filterComplete()));
+        m_model->setFilter("canon 45");
+        QTRY_COMPARE(filterCompleteSpy.count(), 1);
+        QCOMPARE(m_model->rowCount(), 1);
+    }
+    void testFilterUpdatesRows()
+    {
+        QList<PrinterDriver> drivers;
+        for (int i = 0; i < 10; i++) {
+            PrinterDriver driver;
+            driver.name = QString("driver%1").arg(i).toUtf8();
+            driver.makeModel = QString("Maker %1").arg(i % 2 ? "odd" : "even").toUtf8();
+            drivers << driver;
+        }
+
+        m_model->load();
+        getBackend()->mockDriversLoaded(drivers);
+        QCOMPARE(m_model->rowCount(), 10);
+
+        QSignalSpy filterCompleteSpy(m_model, SIGNAL(filterComplete()));
+        QSignalSpy resetSpy(m_model, SIGNAL(modelReset()));
+        QSignalSpy removeSpy(m_model, SIGNAL(rowsRemoved(const QModelIndex&, int, int)));
+        QSignalSpy insertSpy(m_model, SIGNAL(rowsInserted(const QModelIndex&, int, int)));
+
+        m_model->setFilter("odd");
+        QTRY_COMPARE(filterCompleteSpy.count(), 1);
+        QCOMPARE(m_model->rowCount(), 5);
+        QCOMPARE(removeSpy.count(), 5);
+
+        m_model->setFilter("");
+        QCOMPARE(filterCompleteSpy.count(), 2);
+        QCOMPARE(m_model->rowCount(), 10);
+        QCOMPARE(insertSpy.count(), 5);
+
+        // Views keep their delegates.
+        QCOMPARE(resetSpy.count(), 0);
+    }
+    void testFetchMore()
+    {
+        QList<PrinterDriver> drivers;
+        for (int i = 0; i < 500; i++) {
+            PrinterDriver driver;
+            driver.name = QString("driver%1").arg(i).toUtf8();
+            drivers << driver;
+        }
+
+        m_model->load();
+        getBackend()->mockDriversLoaded(drivers);
+
+        QCOMPARE(m_model->count(), 500);
+        QCOMPARE(m_model->rowCount(), 200);
+        QVERIFY(m_model->canFetchMore(QModelIndex()));
+
+        m_model->fetchMore(QModelIndex());
+        QCOMPARE(m_model->rowCount(), 400);
+        m_model->fetchMore(QModelIndex());
+        QCOMPARE(m_model->rowCount(), 500);
+        QVERIFY(!m_model->canFetchMore(QModelIndex()));
+        QCOMPARE(m_model->data(m_model->index(499), DriverModel::Roles::NameRole).toByteArray(),
+                 QByteArray("driver499"));
+    }
+    void testChunks()
+    {
+        QList<PrinterDriver> drivers;
+        for (int i = 0; i < 300; i++) {
+            PrinterDriver driver;
+            driver.name = QString("driver%1").arg(i).toUtf8();
+            drivers << driver;
+        }
+
+        QSignalSpy insertSpy(m_model, SIGNAL(rowsInserted(const QModelIndex&, int, int)));
+        QSignalSpy resetSpy(m_model, SIGNAL(modelReset()));
+
+        m_model->load();
+        QCOMPARE(m_model->timeToFirstResult(), (qint64) -1);
+
+        getBackend()->mockDriversChunkLoaded(drivers.mid(0, 50));
+        QCOMPARE(m_model->rowCount(), 50);
+        QCOMPARE(m_model->count(), 50);
+        QVERIFY(m_model->timeToFirstResult() >= 0);
+
+        // Rows are appended up to a page, the rest can be fetched.
+        getBackend()->mockDriversChunkLoaded(drivers.mid(50));
+        QCOMPARE(m_model->rowCount(), 200);
+        QCOMPARE(m_model->count(), 300);
+        QCOMPARE(insertSpy.count(), 2);
+
+        // The complete list leaves the rows alone.
+        getBackend()->mockDriversLoaded(drivers);
+        QCOMPARE(m_model->rowCount(), 200);
+        QCOMPARE(m_model->count(), 300);
+        QCOMPARE(insertSpy.count(), 2);
+        QCOMPARE(resetSpy.count(), 0);
+        QCOMPARE(m_model->data(m_model->index(199), DriverModel::Roles::NameRole).toByteArray(),
+                 QByteArray("driver199"));
+    }
 private:
     PrinterBackend *m_backend;
     DriverModel *m_model;
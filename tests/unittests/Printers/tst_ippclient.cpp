@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cups/ippclient.h"
+#include "ippresponder.h"
+
+#include <thread>
+
+#include <QAtomicInt>
+#include <QDebug>
+#include <QObject>
+#include <QSemaphore>
+#include <QTest>
+
+class TestIppClient : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase()
+    {
+        m_responder = new IppResponder([this](ipp_t *request) {
+            if (m_hold.loadAcquire()) {
+                m_holding.release();
+                m_gate.acquire();
+            }
+            return IppResponder::newResponse(request);
+        });
+        qputenv("CUPS_SERVER", m_responder->server());
+    }
+    void cleanupTestCase()
+    {
+        delete m_responder;
+    }
+    void testRequest()
+    {
+        IppClient client(2);
+        ipp_t *response = client.getNotifications(1, 1, false);
+        QVERIFY(response);
+        QCOMPARE(ippGetStatusCode(response), IPP_OK);
+        ippDelete(response);
+
+        IppClient::ConnectionPoolStats stats = client.connectionPoolStats();
+        QCOMPARE(stats.openConnections, 1);
+        QCOMPARE(stats.idleConnections, 1);
+        QCOMPARE(stats.checkouts, 1);
+        QCOMPARE(stats.waits, 0);
+    }
+    void testPoolWaits()
+    {
+        IppClient client(2);
+        auto request = [&client]() {
+            ippDelete(client.getNotifications(1, 1, true));
+        };
+
+        // Fill the pool with requests that cupsd holds.
+        m_hold.storeRelease(1);
+        std::thread first(request);
+        std::thread second(request);
+        QVERIFY(m_holding.tryAcquire(2, 5000));
+
+        // The next request waits for a connection, and gives up.
+        QCOMPARE(client.createSubscription(true, 60), -1);
+        IppClient::ConnectionPoolStats stats = client.connectionPoolStats();
+        QCOMPARE(stats.openConnections, 2);
+        QCOMPARE(stats.idleConnections, 0);
+        QCOMPARE(stats.waits, 1);
+        QCOMPARE(stats.timeouts, 1);
+        QVERIFY(stats.maxWaitTime >= 4900);
+        QCOMPARE(stats.totalWaitTime, stats.maxWaitTime);
+
+        // This one gets the connection of the first held request.
+        m_hold.storeRelease(0);
+        std::thread third(request);
+        QTRY_COMPARE(client.connectionPoolStats().waits, 2);
+        m_gate.release();
+        third.join();
+
+        m_gate.release();
+        first.join();
+        second.join();
+
+        stats = client.connectionPoolStats();
+        QCOMPARE(stats.checkouts, 4);
+        QCOMPARE(stats.waits, 2);
+        QCOMPARE(stats.timeouts, 1);
+        QCOMPARE(stats.reconnects, 0);
+        QVERIFY(stats.totalWaitTime >= stats.maxWaitTime);
+        QCOMPARE(stats.openConnections, 2);
+        QCOMPARE(stats.idleConnections, 2);
+    }
+private:
+    IppResponder *m_responder = Q_NULLPTR;
+    QAtomicInt m_hold;
+    QSemaphore m_holding;
+    QSemaphore m_gate;
+};
+
+QTEST_GUILESS_MAIN(TestIppClient)
+#include "tst_ippclient.moc"
@@ -102,6 +102,101 @@ private Q_SLOTS:
 
         QCOMPARE(changedSpy.count(), 1);
     }
+    void testPrinterStateRefreshesJobs()
+    {
+        // Two pending jobs and a completed one.
+        m_backend->mockJobCreated("", "", "test-printer", 1, "", true, 100, 3, "", "", 1);
+        m_backend->mockJobCreated("", "", "test-printer", 1, "", true, 101, 3, "", "", 1);
+        m_backend->mockJobCreated("", "", "test-printer", 1, "", true, 102, 9, "", "", 1);
+
+        qRegisterMetaType<QList<int>>("QList<int>");
+        QSignalSpy refreshSpy(m_model, SIGNAL(forceJobsRefresh(const QString&, const QList<int>&)));
+        m_backend->mockPrinterStateChanged("", "", "test-printer", 1, "", true);
+
+        // One refresh for all the active jobs of the printer.
+        QCOMPARE(refreshSpy.count(), 1);
+        QList<QVariant> args = refreshSpy.at(0);
+        QCOMPARE(args.at(0).toString(), QString("test-printer"));
+        QList<int> jobIds = args.at(1).value<QList<int>>();
+        qSort(jobIds);
+        QCOMPARE(jobIds, QList<int>() << 100 << 101);
+    }
+    void testUpdateJobs()
+    {
+        auto jobA = QSharedPointer<PrinterJob>(new PrinterJob("test-printer", m_backend, 1));
+        auto jobB = QSharedPointer<PrinterJob>(new PrinterJob("test-printer", m_backend, 2));
+
+        m_backend->m_jobs << jobA << jobB;
+        m_backend->mockJobCreated("", "", "test-printer", 1, "", true, 1, 1, "", "", 1);
+        m_backend->mockJobCreated("", "", "test-printer", 1, "", true, 2, 1, "", "", 1);
+        QTRY_COMPARE(m_model->count(), 2);
+
+        JobAttributes attributesA;
+        attributesA.printerName = "test-printer";
+        attributesA.jobId = 1;
+        attributesA.attributes = m_backend->printerGetJobAttributes("test-printer", 1);
+        attributesA.attributes.insert("copies", 3);
+
+        JobAttributes attributesB;
+        attributesB.printerName = "test-printer";
+        attributesB.jobId = 2;
+        attributesB.attributes = m_backend->printerGetJobAttributes("test-printer", 2);
+        attributesB.attributes.insert("copies", 7);
+
+        // Both jobs are updated with a single change.
+        QSignalSpy changedSpy(m_model, SIGNAL(dataChanged(const QModelIndex&, const QModelIndex&, const QVector<int>&)));
+        m_backend->mockJobsLoaded(QList<JobAttributes>({attributesA, attributesB}));
+
+        QCOMPARE(changedSpy.count(), 1);
+        QList<QVariant> args = changedSpy.at(0);
+        QCOMPARE(args.at(0).value<QModelIndex>().row(), 0);
+        QCOMPARE(args.at(1).value<QModelIndex>().row(), 1);
+        QCOMPARE(m_model->data(m_model->index(0), JobModel::CopiesRole).toInt(), 3);
+        QCOMPARE(m_model->data(m_model->index(1), JobModel::CopiesRole).toInt(), 7);
+    }
+
+    void testLoadJobs()
+    {
+        // Nothing to load from the mock backend.
+        QCOMPARE(m_model->loading(), false);
+
+        QList<QSharedPointer<PrinterJob>> jobs;
+        for (int i = 1; i <= 250; i++) {
+            jobs << QSharedPointer<PrinterJob>(new PrinterJob("test-printer", m_backend, i));
+        }
+        m_backend->m_jobs << jobs;
+
+        // A job created while loading is not added twice.
+        m_backend->mockJobCreated("", "", "test-printer", 1, "", true, 1, 1, "", "", 1);
+        QTRY_COMPARE(m_model->count(), 1);
+
+        QSignalSpy insertSpy(m_model, SIGNAL(rowsInserted(const QModelIndex&, int, int)));
+        m_backend->mockJobListLoaded(jobs);
+
+        // The rest are inserted a chunk at a time.
+        QTRY_COMPARE(m_model->count(), 250);
+        QCOMPARE(insertSpy.count(), 3);
+        QCOMPARE(m_model->data(m_model->index(249), JobModel::IdRole).toInt(), 250);
+    }
+    void testJobCompletedWhileLoading()
+    {
+        MockPrinterBackend backend;
+        backend.m_asyncJobs = true;
+        JobModel model(&backend);
+        QCOMPARE(model.loading(), true);
+
+        QList<QSharedPointer<PrinterJob>> jobs;
+        jobs << QSharedPointer<PrinterJob>(new PrinterJob("test-printer", &backend, 1))
+             << QSharedPointer<PrinterJob>(new PrinterJob("test-printer", &backend, 2));
+
+        // The list was taken before job 1 completed.
+        backend.mockJobCompleted("", "", "test-printer", 1, "", true, 1, 9, "", "", 1);
+        backend.mockJobListLoaded(jobs);
+
+        QTRY_COMPARE(model.loading(), false);
+        QCOMPARE(model.count(), 1);
+        QCOMPARE(model.data(model.index(0), JobModel::IdRole).toInt(), 2);
+    }
 
     // Tests for the roles in the model exposed to QML
 
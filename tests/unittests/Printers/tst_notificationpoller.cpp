@@ -0,0 +1,428 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cups/notificationpoller.h"
+#include "ippresponder.h"
+
+#include <cups/ipp.h>
+
+#include <thread>
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QObject>
+#include <QSemaphore>
+#include <QSet>
+#include <QTest>
+#include <QThread>
+
+/* Stands in for cupsd, adding an event like Get-Notifications returns
+them. */
+static void addEvent(ipp_t *response, const int number, const char *name,
+                     const int jobId = 0, const bool separator = true)
+{
+    if (separator) {
+        ippAddSeparator(response);
+    }
+
+    ipp_tag_t group = IPP_TAG_EVENT_NOTIFICATION;
+    ippAddInteger(response, group, IPP_TAG_INTEGER,
+                  "notify-subscription-id", 42);
+    ippAddString(response, group, IPP_TAG_URI, "notify-printer-uri", NULL,
+                 "ipp://localhost/printers/test-printer");
+    ippAddString(response, group, IPP_TAG_KEYWORD, "notify-subscribed-event",
+                 NULL, name);
+    ippAddInteger(response, group, IPP_TAG_INTEGER, "notify-sequence-number",
+                  number);
+    ippAddString(response, group, IPP_TAG_TEXT, "notify-text", NULL, name);
+    ippAddString(response, group, IPP_TAG_NAME, "printer-name", NULL,
+                 "test-printer");
+    ippAddInteger(response, group, IPP_TAG_ENUM, "printer-state", 4);
+    const char *reasons[] = { "media-low", "toner-low" };
+    ippAddStrings(response, group, IPP_TAG_KEYWORD, "printer-state-reasons",
+                  2, NULL, reasons);
+    ippAddBoolean(response, group, "printer-is-accepting-jobs", 1);
+
+    if (jobId > 0) {
+        ippAddInteger(response, group, IPP_TAG_INTEGER, "notify-job-id", jobId);
+        ippAddInteger(response, group, IPP_TAG_ENUM, "job-state", 5);
+        ippAddString(response, group, IPP_TAG_KEYWORD, "job-state-reasons",
+                     NULL, "job-printing");
+        ippAddString(response, group, IPP_TAG_NAME, "job-name", NULL,
+                     "test-job");
+        ippAddInteger(response, group, IPP_TAG_INTEGER,
+                      "job-impressions-completed", 3);
+    }
+}
+
+static ipp_t* newResponse(const int interval = 0)
+{
+    ipp_t *response = ippNew();
+    ippSetStatusCode(response, IPP_OK);
+    if (interval > 0) {
+        ippAddInteger(response, IPP_TAG_OPERATION, IPP_TAG_INTEGER,
+                      "notify-get-interval", interval);
+    }
+    return response;
+}
+
+static int integerValue(ipp_t *request, const char *name)
+{
+    ipp_attribute_t *attr = ippFindAttribute(request, name, IPP_TAG_INTEGER);
+    return attr ? ippGetInteger(attr, 0) : 0;
+}
+
+// A subscription request received by the stand-in cupsd.
+struct SubscriptionRequest
+{
+    ipp_op_t operation;
+    int subscriptionId;
+    int sequenceNumber;
+    int leaseDuration;
+};
+
+class TestNotificationPoller : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase()
+    {
+        m_responder = new IppResponder([this](ipp_t *request) {
+            return respond(request);
+        });
+        qputenv("CUPS_SERVER", m_responder->server());
+    }
+    void cleanupTestCase()
+    {
+        delete m_responder;
+    }
+    void init()
+    {
+        QMutexLocker locker(&m_lock);
+        m_requests.clear();
+        m_events.clear();
+        m_subscriptions.clear();
+        m_lastSubscription = 0;
+        m_holdPolls = false;
+    }
+    void testParse()
+    {
+        ipp_t *response = newResponse(30);
+        addEvent(response, 1, "job-created", 100);
+        addEvent(response, 2, "printer-state-changed");
+
+        QList<CupsEvent> events;
+        int interval = -1;
+        int next = NotificationPoller::parseNotifications(response, 1,
+                                                          events, interval);
+        ippDelete(response);
+
+        QCOMPARE(next, 3);
+        QCOMPARE(interval, 30);
+        QCOMPARE(events.size(), 2);
+
+        CupsEvent job = events.at(0);
+        QCOMPARE(job.type, CupsEvent::Type::JobCreated);
+        QCOMPARE(job.text, QString("job-created"));
+        QCOMPARE(job.printerUri,
+                 QString("ipp://localhost/printers/test-printer"));
+        QCOMPARE(job.printerName, QString("test-printer"));
+        QCOMPARE(job.printerState, (uint) 4);
+        QCOMPARE(job.printerStateReasons, QString("media-low,toner-low"));
+        QCOMPARE(job.acceptingJobs, true);
+        QCOMPARE(job.jobId, (uint) 100);
+        QCOMPARE(job.jobState, (uint) 5);
+        QCOMPARE(job.jobStateReasons, QString("job-printing"));
+        QCOMPARE(job.jobName, QString("test-job"));
+        QCOMPARE(job.jobImpressionsCompleted, (uint) 3);
+
+        CupsEvent printer = events.at(1);
+        QCOMPARE(printer.type, CupsEvent::Type::PrinterStateChanged);
+        QCOMPARE(printer.printerName, QString("test-printer"));
+        QCOMPARE(printer.jobId, (uint) 0);
+        QCOMPARE(printer.jobName, QString());
+    }
+    void testWithoutSeparators()
+    {
+        ipp_t *response = newResponse();
+        addEvent(response, 1, "job-state-changed", 100, false);
+        addEvent(response, 2, "job-completed", 101, false);
+
+        QList<CupsEvent> events;
+        int interval = -1;
+        int next = NotificationPoller::parseNotifications(response, 1,
+                                                          events, interval);
+        ippDelete(response);
+
+        QCOMPARE(next, 3);
+        QCOMPARE(interval, 0);
+        QCOMPARE(events.size(), 2);
+        QCOMPARE(events.at(0).type, CupsEvent::Type::JobState);
+        QCOMPARE(events.at(0).jobId, (uint) 100);
+        QCOMPARE(events.at(1).type, CupsEvent::Type::JobCompleted);
+        QCOMPARE(events.at(1).jobId, (uint) 101);
+    }
+    void testReceivedSkipped()
+    {
+        ipp_t *response = newResponse();
+        addEvent(response, 1, "printer-added");
+        addEvent(response, 2, "printer-modified");
+        addEvent(response, 3, "printer-deleted");
+
+        QList<CupsEvent> events;
+        int interval;
+        int next = NotificationPoller::parseNotifications(response, 3,
+                                                          events, interval);
+        ippDelete(response);
+
+        QCOMPARE(next, 4);
+        QCOMPARE(events.size(), 1);
+        QCOMPARE(events.at(0).type, CupsEvent::Type::PrinterDeleted);
+    }
+    void testUnknownSkipped()
+    {
+        ipp_t *response = newResponse();
+        addEvent(response, 5, "server-restarted");
+        addEvent(response, 6, "printer-added");
+
+        QList<CupsEvent> events;
+        int interval;
+        int next = NotificationPoller::parseNotifications(response, 5,
+                                                          events, interval);
+        ippDelete(response);
+
+        // Still counted, so that it is not asked for again.
+        QCOMPARE(next, 7);
+        QCOMPARE(events.size(), 1);
+        QCOMPARE(events.at(0).type, CupsEvent::Type::PrinterAdded);
+    }
+    void testEmpty()
+    {
+        ipp_t *response = newResponse(60);
+
+        QList<CupsEvent> events;
+        int interval;
+        int next = NotificationPoller::parseNotifications(response, 8,
+                                                          events, interval);
+        ippDelete(response);
+
+        QCOMPARE(next, 8);
+        QCOMPARE(interval, 60);
+        QVERIFY(events.isEmpty());
+    }
+    void testNextInterval()
+    {
+        // Quick while busy.
+        int busy = NotificationPoller::nextInterval(16000, true, 0);
+        QCOMPARE(NotificationPoller::nextInterval(16000, true, 60), busy);
+
+        // Backs off while idle, up to a limit.
+        int interval = busy;
+        for (int i = 0; i < 20; i++) {
+            int next = NotificationPoller::nextInterval(interval, false, 0);
+            QVERIFY(next >= interval);
+            interval = next;
+        }
+        QVERIFY(interval > busy);
+        QCOMPARE(NotificationPoller::nextInterval(interval, false, 0), interval);
+
+        // Up to the interval suggested by cupsd, if it is shorter.
+        QCOMPARE(NotificationPoller::nextInterval(interval, false, 2), 2000);
+        QCOMPARE(NotificationPoller::nextInterval(1000, false, 5), 2000);
+    }
+    void testPollContinuesSequence()
+    {
+        NotificationPoller poller;
+        QList<CupsEvent> received;
+        connect(&poller, &NotificationPoller::eventsReceived,
+                [&received](const QList<CupsEvent> &events) {
+            received << events;
+        });
+        addEvents(QList<QByteArray>() << "job-created" << "printer-added");
+
+        poller.poll();
+        QCOMPARE(received.size(), 2);
+        QCOMPARE(received.at(0).type, CupsEvent::Type::JobCreated);
+        QCOMPARE(received.at(1).type, CupsEvent::Type::PrinterAdded);
+
+        // The next poll asks for the events after those received.
+        addEvents(QList<QByteArray>() << "job-completed");
+        poller.poll();
+        QCOMPARE(received.size(), 3);
+        QCOMPARE(received.at(2).type, CupsEvent::Type::JobCompleted);
+
+        QList<SubscriptionRequest> requests = takeRequests();
+        QCOMPARE(requests.size(), 3);
+        QCOMPARE(requests.at(0).operation, IPP_CREATE_PRINTER_SUBSCRIPTION);
+        QCOMPARE(requests.at(1).operation, IPP_GET_NOTIFICATIONS);
+        QCOMPARE(requests.at(1).subscriptionId, 1);
+        QCOMPARE(requests.at(1).sequenceNumber, 1);
+        QCOMPARE(requests.at(2).operation, IPP_GET_NOTIFICATIONS);
+        QCOMPARE(requests.at(2).subscriptionId, 1);
+        QCOMPARE(requests.at(2).sequenceNumber, 3);
+    }
+    void testResubscribesWhenNotFound()
+    {
+        NotificationPoller poller;
+        addEvents(QList<QByteArray>() << "printer-added");
+        poller.poll();
+
+        // cupsd restarted and forgot the subscription.
+        m_lock.lock();
+        m_subscriptions.clear();
+        m_lock.unlock();
+        poller.poll();
+        poller.poll();
+
+        QList<SubscriptionRequest> requests = takeRequests();
+        QCOMPARE(requests.size(), 5);
+        QCOMPARE(requests.at(2).operation, IPP_GET_NOTIFICATIONS);
+        QCOMPARE(requests.at(2).subscriptionId, 1);
+        QCOMPARE(requests.at(2).sequenceNumber, 2);
+        QCOMPARE(requests.at(3).operation, IPP_CREATE_PRINTER_SUBSCRIPTION);
+        QCOMPARE(requests.at(4).operation, IPP_GET_NOTIFICATIONS);
+        QCOMPARE(requests.at(4).subscriptionId, 2);
+        QCOMPARE(requests.at(4).sequenceNumber, 1);
+    }
+    void testRenewsLease()
+    {
+        NotificationPoller poller;
+        poller.setLeaseDuration(1);
+        poller.poll();
+        poller.poll();
+
+        // Past half of the lease.
+        QThread::msleep(600);
+        poller.poll();
+
+        QList<SubscriptionRequest> requests = takeRequests();
+        QCOMPARE(requests.size(), 5);
+        QCOMPARE(requests.at(0).operation, IPP_CREATE_PRINTER_SUBSCRIPTION);
+        QCOMPARE(requests.at(0).leaseDuration, 1);
+        QCOMPARE(requests.at(2).operation, IPP_GET_NOTIFICATIONS);
+        QCOMPARE(requests.at(3).operation, IPP_RENEW_SUBSCRIPTION);
+        QCOMPARE(requests.at(3).subscriptionId, 1);
+        QCOMPARE(requests.at(3).leaseDuration, 1);
+        QCOMPARE(requests.at(4).operation, IPP_GET_NOTIFICATIONS);
+    }
+    void testAbortHeldPoll()
+    {
+        NotificationPoller poller;
+        QList<CupsEvent> received;
+        connect(&poller, &NotificationPoller::eventsReceived,
+                [&received](const QList<CupsEvent> &events) {
+            received << events;
+        });
+        m_lock.lock();
+        m_holdPolls = true;
+        m_lock.unlock();
+
+        std::thread polling([&poller]() { poller.poll(); });
+        QVERIFY(m_holding.tryAcquire(1, 5000));
+
+        QElapsedTimer timer;
+        timer.start();
+        poller.abort();
+        polling.join();
+        QVERIFY(timer.elapsed() < 2000);
+        m_gate.release();
+
+        // Aborted pollers make no more requests.
+        int count = takeRequests().size();
+        poller.poll();
+        QCOMPARE(takeRequests().size(), 0);
+        QCOMPARE(count, 2);
+        QVERIFY(received.isEmpty());
+    }
+private:
+    void addEvents(const QList<QByteArray> &events)
+    {
+        QMutexLocker locker(&m_lock);
+        m_events << events;
+    }
+
+    QList<SubscriptionRequest> takeRequests()
+    {
+        QMutexLocker locker(&m_lock);
+        QList<SubscriptionRequest> requests = m_requests;
+        m_requests.clear();
+        return requests;
+    }
+
+    /* Answers like cupsd: subscriptions are numbered from 1, and every
+    subscription gets all the events of m_events. */
+    ipp_t* respond(ipp_t *request)
+    {
+        SubscriptionRequest received;
+        received.operation = ippGetOperation(request);
+        received.subscriptionId = integerValue(request, "notify-subscription-id")
+                + integerValue(request, "notify-subscription-ids");
+        received.sequenceNumber = integerValue(request, "notify-sequence-numbers");
+        received.leaseDuration = integerValue(request, "notify-lease-duration");
+
+        QMutexLocker locker(&m_lock);
+        m_requests << received;
+
+        if (received.operation == IPP_CREATE_PRINTER_SUBSCRIPTION) {
+            int id = ++m_lastSubscription;
+            m_subscriptions << id;
+
+            ipp_t *response = IppResponder::newResponse(request);
+            ippAddInteger(response, IPP_TAG_SUBSCRIPTION, IPP_TAG_INTEGER,
+                          "notify-subscription-id", id);
+            return response;
+        }
+
+        if (received.operation != IPP_GET_NOTIFICATIONS) {
+            return IppResponder::newResponse(request);
+        }
+
+        if (!m_subscriptions.contains(received.subscriptionId)) {
+            return IppResponder::newResponse(request, IPP_NOT_FOUND);
+        }
+
+        // Hold the poll until there are events, or the test lets it go.
+        if (m_holdPolls && received.sequenceNumber > m_events.size()) {
+            locker.unlock();
+            m_holding.release();
+            m_gate.acquire();
+            locker.relock();
+        }
+
+        ipp_t *response = IppResponder::newResponse(request);
+        ippAddInteger(response, IPP_TAG_OPERATION, IPP_TAG_INTEGER,
+                      "notify-get-interval", 60);
+        for (int i = received.sequenceNumber; i <= m_events.size(); i++) {
+            addEvent(response, i, m_events.at(i - 1).constData());
+        }
+        return response;
+    }
+
+    IppResponder *m_responder = Q_NULLPTR;
+    QMutex m_lock;
+    QList<SubscriptionRequest> m_requests;
+    QList<QByteArray> m_events;
+    QSet<int> m_subscriptions;
+    int m_lastSubscription = 0;
+    bool m_holdPolls = false;
+    QSemaphore m_holding;
+    QSemaphore m_gate;
+};
+
+QTEST_GUILESS_MAIN(TestNotificationPoller)
+#include "tst_notificationpoller.moc"
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "printer/notifiereventbus.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QSignalSpy>
+#include <QTest>
+
+class TestNotifierEventBus : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testIdleDispatchedAtOnce()
+    {
+        NotifierEventBus bus(500, 2000);
+        QSignalSpy stateSpy(&bus, SIGNAL(printerStateChanged(const QString&, const QString&, const QString&, uint, const QString&, bool)));
+        QSignalSpy changedSpy(&bus, SIGNAL(printerChanged(const QString&)));
+
+        bus.onPrinterStateChanged("", "ipp://foo/bar", "printer-a", 3, "none", true);
+        QCOMPARE(stateSpy.count(), 1);
+        QCOMPARE(changedSpy.count(), 1);
+        QCOMPARE(changedSpy.at(0).at(0).toString(), QString("printer-a"));
+        QVERIFY(!bus.hasPending());
+    }
+    void testBurstCoalesced()
+    {
+        NotifierEventBus bus(200, 2000);
+        QSignalSpy stateSpy(&bus, SIGNAL(printerStateChanged(const QString&, const QString&, const QString&, uint, const QString&, bool)));
+
+        for (uint i = 0; i < 20; i++) {
+            bus.onPrinterStateChanged("spam!", "ipp://bar/baz", "printer-a", i, "none", true);
+        }
+        QCOMPARE(stateSpy.count(), 1);
+        QVERIFY(bus.hasPending());
+
+        QTRY_COMPARE(stateSpy.count(), 2);
+        QCOMPARE(stateSpy.at(1).at(3).toUInt(), (uint) 19);
+
+        NotifierEventBus::Stats stats = bus.stats();
+        QCOMPARE(stats.received, 20);
+        QCOMPARE(stats.dispatched, 2);
+        QCOMPARE(stats.coalesced, 18);
+        QCOMPARE(stats.dropped, 0);
+    }
+    void testMaxLatency()
+    {
+        // Keep sending events with no gap for longer than the max latency;
+        // they are dispatched while the burst goes on.
+        int minLatency = 200;
+        NotifierEventBus bus(minLatency, minLatency * 2);
+        QSignalSpy stateSpy(&bus, SIGNAL(printerStateChanged(const QString&, const QString&, const QString&, uint, const QString&, bool)));
+
+        QElapsedTimer timer;
+        timer.start();
+        while (timer.elapsed() < minLatency * 5) {
+            bus.onPrinterStateChanged("spam!", "ipp://foo/bar", "printer-a", 0, "none", true);
+            QCoreApplication::processEvents();
+        }
+        QVERIFY(stateSpy.count() >= 3);
+
+        int count = stateSpy.count();
+        QTRY_COMPARE(stateSpy.count(), count + 1);
+        QVERIFY(!bus.hasPending());
+    }
+    void testKeyedByEntity()
+    {
+        NotifierEventBus bus(100, 1000);
+        QSignalSpy changedSpy(&bus, SIGNAL(printerChanged(const QString&)));
+        QSignalSpy jobSpy(&bus, SIGNAL(jobState(const QString&, const QString&, const QString&, uint, const QString&, bool, uint, uint, const QString&, const QString&, uint)));
+
+        // Opens the window.
+        bus.onPrinterModified("", "", "printer-a", 0, "", true);
+        QCOMPARE(changedSpy.count(), 1);
+
+        bus.onPrinterModified("", "", "printer-a", 0, "", true);
+        bus.onPrinterStateChanged("", "", "printer-a", 0, "", true);
+        bus.onPrinterModified("", "", "printer-b", 0, "", true);
+        bus.onJobState("", "", "printer-a", 0, "", true, 1, 5, "", "", 1);
+        bus.onJobState("", "", "printer-a", 0, "", true, 2, 5, "", "", 1);
+        bus.onJobState("", "", "printer-a", 0, "", true, 1, 5, "", "", 2);
+        QCOMPARE(changedSpy.count(), 1);
+
+        bus.flush();
+        QCOMPARE(changedSpy.count(), 3);
+        QCOMPARE(changedSpy.at(1).at(0).toString(), QString("printer-a"));
+        QCOMPARE(changedSpy.at(2).at(0).toString(), QString("printer-b"));
+
+        QCOMPARE(jobSpy.count(), 2);
+        QCOMPARE(jobSpy.at(0).at(6).toUInt(), (uint) 1);
+        QCOMPARE(jobSpy.at(0).at(10).toUInt(), (uint) 2);
+        QCOMPARE(jobSpy.at(1).at(6).toUInt(), (uint) 2);
+    }
+    void testDeletionDropsUpdates()
+    {
+        NotifierEventBus bus(100, 1000);
+        QSignalSpy changedSpy(&bus, SIGNAL(printerChanged(const QString&)));
+        QSignalSpy deletedSpy(&bus, SIGNAL(printerDeleted(const QString&, const QString&, const QString&, uint, const QString&, bool)));
+
+        bus.onPrinterModified("", "", "printer-a", 0, "", true);
+        bus.onPrinterModified("", "", "printer-a", 0, "", true);
+        bus.onPrinterDeleted("", "", "printer-a", 0, "", true);
+
+        // Deletions are not held back.
+        QCOMPARE(deletedSpy.count(), 1);
+        QVERIFY(!bus.hasPending());
+
+        bus.flush();
+        QCOMPARE(changedSpy.count(), 1);
+        QCOMPARE(bus.stats().dropped, 1);
+    }
+    void testCompletionDropsJobState()
+    {
+        NotifierEventBus bus(100, 1000);
+        QSignalSpy createdSpy(&bus, SIGNAL(jobCreated(const QString&, const QString&, const QString&, uint, const QString&, bool, uint, uint, const QString&, const QString&, uint)));
+        QSignalSpy stateSpy(&bus, SIGNAL(jobState(const QString&, const QString&, const QString&, uint, const QString&, bool, uint, uint, const QString&, const QString&, uint)));
+        QSignalSpy completedSpy(&bus, SIGNAL(jobCompleted(const QString&, const QString&, const QString&, uint, const QString&, bool, uint, uint, const QString&, const QString&, uint)));
+
+        bus.onJobCreated("", "", "printer-a", 0, "", true, 7, 3, "", "", 0);
+        bus.onJobState("", "", "printer-a", 0, "", true, 7, 5, "", "", 1);
+        bus.onJobState("", "", "printer-a", 0, "", true, 7, 5, "", "", 2);
+        bus.onJobCompleted("", "", "printer-a", 0, "", true, 7, 9, "", "", 3);
+
+        QCOMPARE(createdSpy.count(), 1);
+        QCOMPARE(stateSpy.count(), 1);
+        QCOMPARE(completedSpy.count(), 1);
+        QVERIFY(!bus.hasPending());
+        QCOMPARE(bus.stats().dropped, 1);
+    }
+};
+
+QTEST_GUILESS_MAIN(TestNotifierEventBus)
+#include "tst_notifiereventbus.moc"
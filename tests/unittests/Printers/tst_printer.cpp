@@ -452,6 +452,89 @@ private Q_SLOTS:
         QCOMPARE(m_instance->defaultDuplexMode(), newDefaultDuplexMode);
         QCOMPARE(m_instance->supportedDuplexModes(), duplexModes);
     }
+    void testAttributesLoadOnDemand()
+    {
+        MockPrinterBackend *backend = new MockPrinterBackend(m_printerName);
+        backend->m_asyncOptions = true;
+        backend->printerOptions[m_printerName].insert("DeviceUri", "/dev/null");
+        backend->printerOptions[m_printerName].insert("Copies", "2");
+        Printer p(backend);
+        QVERIFY(backend->m_requestedOptions.isEmpty());
+
+        QSignalSpy extendedSpy(&p, SIGNAL(extendedAttributesChanged()));
+        QSignalSpy capabilitiesSpy(&p, SIGNAL(capabilitiesChanged()));
+
+        // Only the group asked for is loaded, and only once.
+        QCOMPARE(p.deviceUri(), QString());
+        QCOMPARE(p.copies(), 1);
+        QCOMPARE(backend->m_requestedOptions.size(), 1);
+
+        backend->mockPrinterOptionsLoaded(m_printerName,
+                                          backend->m_requestedOptions.first());
+        QCOMPARE(extendedSpy.count(), 1);
+        QCOMPARE(capabilitiesSpy.count(), 0);
+        QCOMPARE(p.deviceUri(), QString("/dev/null"));
+        QCOMPARE(p.copies(), 2);
+        QCOMPARE(backend->m_requestedOptions.size(), 1);
+    }
+    void testPageSizesLoadWithCapabilities()
+    {
+        MockPrinterBackend *backend = new MockPrinterBackend(m_printerName);
+        backend->m_asyncOptions = true;
+        backend->m_supportedPageSizes = QList<QPageSize>({
+            QPageSize(QPageSize::A4), QPageSize(QPageSize::Letter)
+        });
+        backend->m_supportedDuplexModes = QList<PrinterEnum::DuplexMode>({
+            PrinterEnum::DuplexMode::DuplexLongSide
+        });
+        Printer p(backend);
+
+        // Placeholders, until the capabilities are loaded.
+        QSignalSpy capabilitiesSpy(&p, SIGNAL(capabilitiesChanged()));
+        QVERIFY(p.supportedPageSizes().isEmpty());
+        QVERIFY(p.supportedDuplexModes().isEmpty());
+        QCOMPARE(backend->m_requestedOptions.size(), 1);
+
+        backend->mockPrinterOptionsLoaded(m_printerName,
+                                          backend->m_requestedOptions.first());
+        QCOMPARE(capabilitiesSpy.count(), 1);
+        QCOMPARE(p.supportedPageSizes(), backend->m_supportedPageSizes);
+        QCOMPARE(p.supportedDuplexModes(), backend->m_supportedDuplexModes);
+    }
+    void testUpdateFromReloadsAttributes()
+    {
+        MockPrinterBackend *backend = new MockPrinterBackend(m_printerName);
+        backend->m_asyncOptions = true;
+        backend->printerOptions[m_printerName].insert("DeviceUri", "/dev/null");
+        QSharedPointer<Printer> p = QSharedPointer<Printer>(new Printer(backend));
+
+        // Asked for here, but not loaded by the new printer.
+        m_instance->deviceUri();
+        m_instance->updateFrom(p);
+        QCOMPARE(backend->m_requestedOptions.size(), 1);
+
+        QSignalSpy extendedSpy(m_instance.data(), SIGNAL(extendedAttributesChanged()));
+        backend->mockPrinterOptionsLoaded(m_printerName,
+                                          backend->m_requestedOptions.first());
+        QCOMPARE(extendedSpy.count(), 1);
+        QCOMPARE(m_instance->deviceUri(), QString("/dev/null"));
+    }
+    void testDeepCompareLoadsNothing()
+    {
+        MockPrinterBackend *backend = new MockPrinterBackend(m_printerName);
+        backend->m_asyncOptions = true;
+        QSharedPointer<Printer> p = QSharedPointer<Printer>(new Printer(backend));
+
+        // Loaded here only, so not compared.
+        m_instance->deviceUri();
+        QVERIFY(m_instance->deepCompare(p));
+        QVERIFY(backend->m_requestedOptions.isEmpty());
+
+        // A changed configuration makes them differ.
+        backend->m_configChangeTime = 10;
+        QSharedPointer<Printer> changed = QSharedPointer<Printer>(new Printer(backend));
+        QVERIFY(!m_instance->deepCompare(changed));
+    }
 
 private:
     QString m_printerName = "my-printer";
@@ -125,6 +125,51 @@ private Q_SLOTS:
         Device d; d.id = id;
         QCOMPARE(d.toString(), expected);
     }
+    void testKey_data()
+    {
+        QTest::addColumn<Device>("a");
+        QTest::addColumn<Device>("b");
+        QTest::addColumn<bool>("same");
+
+        {
+            Device a; a.uri = "ipp://printer.local/ipp/print"; a.id = "MFG:HP;MDL:X;";
+            Device b = a;
+            QTest::newRow("identical") << a << b << true;
+        }
+        {
+            Device a; a.uri = "IPP://Printer.local/ipp/print/";
+            Device b; b.uri = "ipp://printer.local/ipp/print";
+            QTest::newRow("case and trailing slash") << a << b << true;
+        }
+        {
+            Device a; a.uri = "socket://10.0.0.2"; a.id = "MFG:HP;MDL:X;";
+            Device b; b.uri = "socket://10.0.0.2"; b.id = " MFG:HP;MDL:X";
+            QTest::newRow("id whitespace and terminator") << a << b << true;
+        }
+        {
+            Device a; a.uri = "socket://10.0.0.2"; a.info = "HP X";
+            Device b; b.uri = "socket://10.0.0.2"; b.info = "HP X (snmp)";
+            QTest::newRow("info ignored") << a << b << true;
+        }
+        {
+            Device a; a.uri = "usb://HP/LaserJet?serial=1";
+            Device b; b.uri = "usb://HP/LaserJet?serial=2";
+            QTest::newRow("different serial") << a << b << false;
+        }
+        {
+            Device a; a.uri = "socket://10.0.0.2"; a.id = "MFG:HP;MDL:X;";
+            Device b; b.uri = "socket://10.0.0.2"; b.id = "MFG:HP;MDL:Y;";
+            QTest::newRow("different id") << a << b << false;
+        }
+    }
+    void testKey()
+    {
+        QFETCH(Device, a);
+        QFETCH(Device, b);
+        QFETCH(bool, same);
+
+        QCOMPARE(a.key() == b.key(), same);
+    }
 };
 
 QTEST_GUILESS_MAIN(TestDevice)
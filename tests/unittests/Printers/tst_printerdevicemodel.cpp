@@ -96,6 +96,17 @@ private Q_SLOTS:
         QCOMPARE(countSpy.count(), 1);
         QCOMPARE(insertSpy.count(), 1);
     }
+    void testNormalisedDuplicatesIgnored()
+    {
+        Device d; d.uri = "ipp://printer.local/ipp/print/"; d.id = "MFG:HP;MDL:X;";
+        m_backend->mockDeviceFound(d);
+
+        Device d1; d1.uri = "IPP://Printer.local/ipp/print"; d1.id = "MFG:HP;MDL:X";
+        d1.info = "Found by another backend";
+        m_backend->mockDeviceFound(d1);
+
+        QCOMPARE(m_model->count(), 1);
+    }
     void testRoles_data()
     {
         QTest::addColumn<DeviceModel::Roles>("role");
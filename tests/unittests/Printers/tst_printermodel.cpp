@@ -157,6 +157,107 @@ private Q_SLOTS:
 
     // Tests for the roles in the model exposed to QML
 
+    void testModifiedLoadsState()
+    {
+        MockPrinterBackend *backend = new MockPrinterBackend("a-printer");
+        backend->m_type = PrinterEnum::PrinterType::CupsType;
+        auto printer = QSharedPointer<Printer>(new Printer(backend));
+        m_backend->mockPrinterLoaded(printer);
+
+        m_backend->mockPrinterModified("", "", "a-printer", 3, "", true);
+        QCOMPARE(m_backend->m_requestedPrinterStates, QStringList() << "a-printer");
+        QVERIFY(!m_backend->m_requestedPrinters.contains("a-printer"));
+    }
+    void testModifiedLoadsProxy()
+    {
+        auto printer = QSharedPointer<Printer>(new Printer(new MockPrinterBackend("a-printer")));
+        m_backend->mockPrinterLoaded(printer);
+
+        m_backend->mockPrinterModified("", "", "a-printer", 3, "", true);
+        QVERIFY(m_backend->m_requestedPrinters.contains("a-printer"));
+        QVERIFY(m_backend->m_requestedPrinterStates.isEmpty());
+    }
+    void testStatePatched()
+    {
+        MockPrinterBackend *backend = new MockPrinterBackend("a-printer");
+        backend->m_type = PrinterEnum::PrinterType::CupsType;
+        backend->m_configChangeTime = 10;
+        auto printer = QSharedPointer<Printer>(new Printer(backend));
+        m_backend->mockPrinterLoaded(printer);
+        QCOMPARE(m_model->count(), 2);
+
+        QSignalSpy changedSpy(m_model, SIGNAL(dataChanged(const QModelIndex&, const QModelIndex&, const QVector<int>&)));
+
+        PrinterStateAttributes attributes;
+        attributes.printerName = "a-printer";
+        attributes.state = PrinterEnum::State::ErrorState;
+        attributes.stateMessage = "Out of paper";
+        attributes.acceptJobs = printer->acceptJobs();
+        attributes.stateChangeTime = 20;
+        attributes.configChangeTime = 10;
+        m_backend->mockPrinterStateLoaded(attributes);
+
+        // Patched in place, only the changed roles.
+        QVERIFY(m_backend->m_requestedPrinters.isEmpty());
+        QCOMPARE(printer->state(), PrinterEnum::State::ErrorState);
+        QCOMPARE(printer->lastMessage(), QString("Out of paper"));
+        QCOMPARE(changedSpy.count(), 1);
+        QVector<int> roles = changedSpy.at(0).at(2).value<QVector<int>>();
+        QVERIFY(roles.contains(PrinterModel::StateRole));
+        QVERIFY(roles.contains(PrinterModel::LastMessageRole));
+        QVERIFY(!roles.contains(PrinterModel::AcceptJobsRole));
+
+        // Nothing to do if the state did not change since.
+        m_backend->mockPrinterStateLoaded(attributes);
+        QCOMPARE(changedSpy.count(), 1);
+    }
+    void testConfigChangeReloads()
+    {
+        MockPrinterBackend *backend = new MockPrinterBackend("a-printer");
+        backend->m_type = PrinterEnum::PrinterType::CupsType;
+        backend->m_configChangeTime = 10;
+        auto printer = QSharedPointer<Printer>(new Printer(backend));
+        m_backend->mockPrinterLoaded(printer);
+
+        QSignalSpy changedSpy(m_model, SIGNAL(dataChanged(const QModelIndex&, const QModelIndex&, const QVector<int>&)));
+
+        PrinterStateAttributes attributes;
+        attributes.printerName = "a-printer";
+        attributes.state = PrinterEnum::State::ErrorState;
+        attributes.configChangeTime = 11;
+        m_backend->mockPrinterStateLoaded(attributes);
+
+        QCOMPARE(m_backend->m_requestedPrinters, QStringList() << "a-printer");
+        QCOMPARE(changedSpy.count(), 0);
+        QCOMPARE(printer->state(), PrinterEnum::State::IdleState);
+    }
+    void testAttributesLoadedChangeRoles()
+    {
+        MockPrinterBackend *backend = new MockPrinterBackend("a-printer");
+        backend->m_type = PrinterEnum::PrinterType::CupsType;
+        backend->m_asyncOptions = true;
+        backend->printerOptions["a-printer"].insert("Copies", "3");
+        auto printer = QSharedPointer<Printer>(new Printer(backend));
+        m_backend->mockPrinterLoaded(printer);
+
+        QSignalSpy changedSpy(m_model, SIGNAL(dataChanged(const QModelIndex&, const QModelIndex&, const QVector<int>&)));
+
+        // Listing the names loads nothing.
+        QModelIndex idx = m_model->index(1);
+        QCOMPARE(m_model->data(idx, PrinterModel::NameRole).toString(), QString("a-printer"));
+        QVERIFY(backend->m_requestedOptions.isEmpty());
+
+        QCOMPARE(m_model->data(idx, PrinterModel::CopiesRole).toInt(), 1);
+        QCOMPARE(backend->m_requestedOptions.size(), 1);
+
+        backend->mockPrinterOptionsLoaded("a-printer",
+                                          backend->m_requestedOptions.first());
+        QCOMPARE(changedSpy.count(), 1);
+        QVector<int> roles = changedSpy.at(0).at(2).value<QVector<int>>();
+        QVERIFY(roles.contains(PrinterModel::CopiesRole));
+        QVERIFY(!roles.contains(PrinterModel::ColorModelRole));
+        QCOMPARE(m_model->data(idx, PrinterModel::CopiesRole).toInt(), 3);
+    }
     void testColorModelRole()
     {
         ColorModel a;
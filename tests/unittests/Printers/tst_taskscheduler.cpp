@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "backend/taskscheduler.h"
+
+#include <QDebug>
+#include <QMutex>
+#include <QObject>
+#include <QSemaphore>
+#include <QSignalSpy>
+#include <QStringList>
+#include <QTest>
+#include <QThread>
+
+class MockTask : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MockTask(const QString &name, QStringList *log,
+                      QSemaphore *gate = Q_NULLPTR)
+        : QObject(Q_NULLPTR)
+        , m_name(name)
+        , m_log(log)
+        , m_gate(gate)
+    {
+    }
+
+    static QMutex logLock;
+
+public Q_SLOTS:
+    void load()
+    {
+        if (m_gate) {
+            m_gate->acquire();
+        }
+
+        logLock.lock();
+        *m_log << m_name;
+        logLock.unlock();
+
+        Q_EMIT loaded(QThread::currentThread() != qApp->thread());
+        Q_EMIT finished();
+    }
+
+Q_SIGNALS:
+    void loaded(bool onWorkerThread);
+    void finished();
+
+private:
+    QString m_name;
+    QStringList *m_log;
+    QSemaphore *m_gate;
+};
+
+QMutex MockTask::logLock;
+
+class TestTaskScheduler : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testRunsOnWorker()
+    {
+        QStringList log;
+        TaskScheduler scheduler(2);
+
+        auto task = new MockTask("a", &log);
+        QSignalSpy loadedSpy(task, SIGNAL(loaded(bool)));
+        QSignalSpy destroyedSpy(task, SIGNAL(destroyed(QObject*)));
+
+        QVERIFY(scheduler.submit("a", task, "load",
+                                 TaskScheduler::Priority::Background));
+
+        QTRY_COMPARE(destroyedSpy.count(), 1);
+        QCOMPARE(loadedSpy.count(), 1);
+        QCOMPARE(loadedSpy.at(0).at(0).toBool(), true);
+        QTRY_COMPARE(scheduler.stats().completed, 1);
+        QCOMPARE(scheduler.contains("a"), false);
+    }
+    void testDeduplicates()
+    {
+        QStringList log;
+        QSemaphore gate;
+        TaskScheduler scheduler(1);
+
+        QVERIFY(scheduler.submit("a", new MockTask("a", &log, &gate), "load",
+                                 TaskScheduler::Priority::Background));
+        QVERIFY(!scheduler.submit("a", new MockTask("a", &log, &gate), "load",
+                                  TaskScheduler::Priority::Background));
+        QCOMPARE(scheduler.stats().deduplicated, 1);
+
+        gate.release(2);
+        QTRY_COMPARE(scheduler.stats().completed, 1);
+        QCOMPARE(log, QStringList({"a"}));
+    }
+    void testDeduplicatesPerOwner()
+    {
+        QStringList log;
+        QSemaphore gate;
+        TaskScheduler scheduler(1);
+        QObject first;
+        QObject second;
+
+        QVERIFY(scheduler.submit("a", new MockTask("a", &log, &gate), "load",
+                                 TaskScheduler::Priority::Background, &first));
+        QVERIFY(!scheduler.submit("a", new MockTask("a", &log, &gate), "load",
+                                  TaskScheduler::Priority::Background, &first));
+        QVERIFY(scheduler.submit("a", new MockTask("a", &log, &gate), "load",
+                                 TaskScheduler::Priority::Background, &second));
+        QVERIFY(scheduler.contains("a", &second));
+        QVERIFY(!scheduler.contains("a"));
+
+        gate.release(2);
+        QTRY_COMPARE(scheduler.stats().completed, 2);
+        QCOMPARE(log, QStringList({"a", "a"}));
+    }
+    void testPriorities()
+    {
+        QStringList log;
+        QSemaphore gate;
+        TaskScheduler scheduler(1);
+        QSignalSpy depthSpy(&scheduler, SIGNAL(queueDepthChanged(int)));
+
+        // Keep the only worker busy while the others queue up.
+        scheduler.submit("busy", new MockTask("busy", &log, &gate), "load",
+                         TaskScheduler::Priority::Background);
+        scheduler.submit("background", new MockTask("background", &log),
+                         "load", TaskScheduler::Priority::Background);
+        scheduler.submit("default", new MockTask("default", &log), "load",
+                         TaskScheduler::Priority::DefaultPrinter);
+        scheduler.submit("visible", new MockTask("visible", &log), "load",
+                         TaskScheduler::Priority::Visible);
+        QCOMPARE(scheduler.queueDepth(), 3);
+        QCOMPARE(depthSpy.count(), 3);
+
+        gate.release();
+        QTRY_COMPARE(scheduler.stats().completed, 4);
+        QCOMPARE(log, QStringList({"busy", "visible", "default", "background"}));
+        QCOMPARE(scheduler.queueDepth(), 0);
+    }
+    void testRaisesPriority()
+    {
+        QStringList log;
+        QSemaphore gate;
+        TaskScheduler scheduler(1);
+
+        scheduler.submit("busy", new MockTask("busy", &log, &gate), "load",
+                         TaskScheduler::Priority::Background);
+        scheduler.submit("a", new MockTask("a", &log), "load",
+                         TaskScheduler::Priority::Background);
+        scheduler.submit("b", new MockTask("b", &log), "load",
+                         TaskScheduler::Priority::Background);
+        scheduler.submit("b", new MockTask("b", &log), "load",
+                         TaskScheduler::Priority::Visible);
+
+        gate.release();
+        QTRY_COMPARE(scheduler.stats().completed, 3);
+        QCOMPARE(log, QStringList({"busy", "b", "a"}));
+    }
+    void testDropsOrphans()
+    {
+        QStringList log;
+        QSemaphore gate;
+        TaskScheduler scheduler(1);
+        QObject *owner = new QObject;
+
+        scheduler.submit("busy", new MockTask("busy", &log, &gate), "load",
+                         TaskScheduler::Priority::Background);
+        scheduler.submit("orphan", new MockTask("orphan", &log), "load",
+                         TaskScheduler::Priority::Background, owner);
+        delete owner;
+
+        gate.release();
+        QTRY_COMPARE(scheduler.stats().completed, 1);
+        QTest::qWait(100);
+        QCOMPARE(log, QStringList({"busy"}));
+        QCOMPARE(scheduler.queueDepth(), 0);
+    }
+};
+
+QTEST_GUILESS_MAIN(TestTaskScheduler)
+#include "tst_taskscheduler.moc"
@@ -0,0 +1,295 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "imaging.h"
+#include "photo-edit-command.h"
+#include "photo-edit-thread.h"
+#include "photo-image-provider.h"
+#include "photo-metadata.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QHash>
+#include <QImage>
+#include <QTemporaryDir>
+#include <QTest>
+#include <qmath.h>
+
+/*
+ * Benchmarks of the photo editor operations on synthetic photos of common
+ * camera resolutions. This is not run as part of the unit tests; run it
+ * with "make benchmark", which writes the results as QTestLib XML to
+ * photoeditor-benchmark.xml so that they can be compared between releases.
+ */
+class PhotoEditorBenchmark: public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+
+    void benchmarkIntensityHistogram_data();
+    void benchmarkIntensityHistogram();
+    void benchmarkAutoEnhanceTransformation_data();
+    void benchmarkAutoEnhanceTransformation();
+    void benchmarkEnhanceImage_data();
+    void benchmarkEnhanceImage();
+    void benchmarkCompensateExposure_data();
+    void benchmarkCompensateExposure();
+    void benchmarkRotate_data();
+    void benchmarkRotate();
+    void benchmarkCrop_data();
+    void benchmarkCrop();
+    void benchmarkMetadataRoundTrip_data();
+    void benchmarkMetadataRoundTrip();
+    void benchmarkRequestImage_data();
+    void benchmarkRequestImage();
+
+private:
+    void addSizes();
+    QImage syntheticImage(int megapixels);
+    QString syntheticFile(int megapixels);
+
+    QTemporaryDir m_workingDir;
+    QHash<int, QImage> m_images;
+    QHash<int, QString> m_files;
+};
+
+static const int MEGAPIXELS[] = { 2, 12, 24, 48 };
+
+void PhotoEditorBenchmark::initTestCase()
+{
+    QVERIFY(m_workingDir.isValid());
+}
+
+void PhotoEditorBenchmark::addSizes()
+{
+    QTest::addColumn<int>("megapixels");
+
+    for (unsigned int i = 0; i < sizeof(MEGAPIXELS) / sizeof(MEGAPIXELS[0]); i++) {
+        QTest::newRow(qPrintable(QString("%1MP").arg(MEGAPIXELS[i])))
+                << MEGAPIXELS[i];
+    }
+}
+
+/*!
+ * Generates a 4:3 photo with smooth gradients and some noise, so that the
+ * histogram is spread and the JPEG encoder has realistic work to do.
+ * Images are generated once per size and reused by all the benchmarks.
+ */
+QImage PhotoEditorBenchmark::syntheticImage(int megapixels)
+{
+    if (m_images.contains(megapixels))
+        return m_images.value(megapixels);
+
+    int height = qRound(qSqrt(megapixels * 1000000.0 * 3 / 4));
+    int width = height * 4 / 3;
+
+    QImage image(width, height, QImage::Format_RGB32);
+    quint32 seed = 42;
+    for (int j = 0; j < height; j++) {
+        QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(j));
+        for (int i = 0; i < width; i++) {
+            seed = seed * 1664525 + 1013904223;
+            int noise = (seed >> 24) & 0x1f;
+            line[i] = qRgb((i * 255 / width + noise) & 0xff,
+                           (j * 255 / height + noise) & 0xff,
+                           ((i + j) * 255 / (width + height)) & 0xff);
+        }
+    }
+
+    m_images.insert(megapixels, image);
+    return image;
+}
+
+/*!
+ * Saves the synthetic photo of the given size as a JPEG file in the working
+ * directory, and returns its path.
+ */
+QString PhotoEditorBenchmark::syntheticFile(int megapixels)
+{
+    if (m_files.contains(megapixels))
+        return m_files.value(megapixels);
+
+    QString path = QDir(m_workingDir.path()).absoluteFilePath(
+                QString("synthetic-%1mp.jpg").arg(megapixels));
+    if (!syntheticImage(megapixels).save(path, "jpeg", 90))
+        return QString();
+
+    m_files.insert(megapixels, path);
+    return path;
+}
+
+void PhotoEditorBenchmark::benchmarkIntensityHistogram_data()
+{
+    addSizes();
+}
+
+void PhotoEditorBenchmark::benchmarkIntensityHistogram()
+{
+    QFETCH(int, megapixels);
+    QImage image = syntheticImage(megapixels);
+
+    QBENCHMARK {
+        IntensityHistogram histogram(image);
+        Q_UNUSED(histogram);
+    }
+}
+
+void PhotoEditorBenchmark::benchmarkAutoEnhanceTransformation_data()
+{
+    addSizes();
+}
+
+void PhotoEditorBenchmark::benchmarkAutoEnhanceTransformation()
+{
+    QFETCH(int, megapixels);
+    QImage image = syntheticImage(megapixels);
+
+    QBENCHMARK {
+        AutoEnhanceTransformation enhance(image);
+        Q_UNUSED(enhance);
+    }
+}
+
+void PhotoEditorBenchmark::benchmarkEnhanceImage_data()
+{
+    addSizes();
+}
+
+void PhotoEditorBenchmark::benchmarkEnhanceImage()
+{
+    QFETCH(int, megapixels);
+    QImage image = syntheticImage(megapixels);
+
+    QBENCHMARK {
+        QImage result = PhotoEditThread::enhanceImage(image);
+        QVERIFY(!result.isNull());
+    }
+}
+
+void PhotoEditorBenchmark::benchmarkCompensateExposure_data()
+{
+    addSizes();
+}
+
+void PhotoEditorBenchmark::benchmarkCompensateExposure()
+{
+    QFETCH(int, megapixels);
+    QImage image = syntheticImage(megapixels);
+
+    QBENCHMARK {
+        QImage result = PhotoEditThread::compensateExposure(image, 0.3);
+        QVERIFY(!result.isNull());
+    }
+}
+
+void PhotoEditorBenchmark::benchmarkRotate_data()
+{
+    addSizes();
+}
+
+void PhotoEditorBenchmark::benchmarkRotate()
+{
+    QFETCH(int, megapixels);
+    QImage image = syntheticImage(megapixels);
+
+    PhotoEditCommand command;
+    command.type = EDIT_ROTATE;
+    command.orientation = OrientationCorrection::rotateOrientation(TOP_LEFT_ORIGIN, false);
+
+    QBENCHMARK {
+        QImage result = PhotoEditThread::processImage(image, command);
+        QCOMPARE(result.width(), image.height());
+    }
+}
+
+void PhotoEditorBenchmark::benchmarkCrop_data()
+{
+    addSizes();
+}
+
+void PhotoEditorBenchmark::benchmarkCrop()
+{
+    QFETCH(int, megapixels);
+    QImage image = syntheticImage(megapixels);
+
+    PhotoEditCommand command;
+    command.type = EDIT_CROP;
+    command.crop_rectangle = QRectF(0.1, 0.1, 0.8, 0.8);
+
+    QBENCHMARK {
+        QImage result = PhotoEditThread::processImage(image, command);
+        QVERIFY(!result.isNull());
+    }
+}
+
+void PhotoEditorBenchmark::benchmarkMetadataRoundTrip_data()
+{
+    addSizes();
+}
+
+void PhotoEditorBenchmark::benchmarkMetadataRoundTrip()
+{
+    QFETCH(int, megapixels);
+    QString path = syntheticFile(megapixels);
+    QVERIFY(!path.isEmpty());
+
+    // Read, change and save the metadata, as rotating a photo does.
+    int i = 0;
+    QBENCHMARK {
+        PhotoMetadata* metadata = PhotoMetadata::fromFile(QFileInfo(path));
+        QVERIFY(metadata != NULL);
+        metadata->setOrientation((i++ % 2) ? TOP_LEFT_ORIGIN : RIGHT_TOP_ORIGIN);
+        QVERIFY(metadata->save());
+        delete metadata;
+    }
+}
+
+void PhotoEditorBenchmark::benchmarkRequestImage_data()
+{
+    QTest::addColumn<int>("megapixels");
+    QTest::addColumn<QSize>("requestedSize");
+
+    QList<QSize> sizes;
+    sizes << QSize() << QSize(1920, 1920) << QSize(512, 512) << QSize(128, 128);
+
+    for (unsigned int i = 0; i < sizeof(MEGAPIXELS) / sizeof(MEGAPIXELS[0]); i++) {
+        Q_FOREACH(const QSize& size, sizes) {
+            QString name = QString("%1MP@%2").arg(MEGAPIXELS[i])
+                    .arg(size.isValid() ? QString::number(size.width()) : QString("full"));
+            QTest::newRow(qPrintable(name)) << MEGAPIXELS[i] << size;
+        }
+    }
+}
+
+void PhotoEditorBenchmark::benchmarkRequestImage()
+{
+    QFETCH(int, megapixels);
+    QFETCH(QSize, requestedSize);
+    QString path = syntheticFile(megapixels);
+    QVERIFY(!path.isEmpty());
+
+    PhotoImageProvider provider;
+    QBENCHMARK {
+        QSize size;
+        QImage image = provider.requestImage(path, &size, requestedSize);
+        QVERIFY(!image.isNull());
+    }
+}
+
+QTEST_MAIN(PhotoEditorBenchmark)
+
+#include "tst_PhotoEditorBenchmark.moc"